@@ -0,0 +1,16 @@
+
+#include <math.h>
+#include "benchmark_scene.h"
+
+void benchmark_look_at(const float position[3], const float target[3], float roll, transform_component_t* transform)
+{
+    const float direction[3] = {target[0] - position[0], target[1] - position[1], target[2] - position[2]};
+
+    transform->position = (Q_VEC3){{Q_FROM_FLOAT(position[0]), Q_FROM_FLOAT(position[1]), Q_FROM_FLOAT(position[2])}};
+
+    // The camera looks down -z, yaw turns it about y, pitch tilts it about its own x and roll turns it about its own z
+    const float yaw   = atan2f(-direction[0], -direction[2]);
+    const float pitch = atan2f(direction[1], sqrtf(direction[0] * direction[0] + direction[2] * direction[2]));
+    const Q_QUAT yaw_pitch = q_quat_mul_quat(q_quat_angle_axis(Q_FROM_FLOAT(yaw), Q_VEC3_UP), q_quat_angle_axis(Q_FROM_FLOAT(pitch), Q_VEC3_RIGHT));
+    transform->rotation = q_quat_mul_quat(yaw_pitch, q_quat_angle_axis(Q_FROM_FLOAT(roll), Q_VEC3_FORWARD));
+}
@@ -0,0 +1,10 @@
+
+#ifndef PICO_ENGINE_BENCHMARK_BENCHMARK_SCENE_H
+#define PICO_ENGINE_BENCHMARK_BENCHMARK_SCENE_H
+
+#include "models/farm_scene.h"
+
+// Places the camera at the position looking at the target, rolled by the angle in radians
+void benchmark_look_at(const float position[3], const float target[3], float roll, transform_component_t* transform);
+
+#endif // PICO_ENGINE_BENCHMARK_BENCHMARK_SCENE_H
@@ -0,0 +1,311 @@
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pico/stdlib.h>
+
+#include "pgl/capture.h"
+
+#define REPLAY_MAX_FRAMES 256
+
+typedef struct
+{
+    const uint8_t* data;
+    size_t size;
+    size_t offset;
+} replay_reader_t;
+
+static uint8_t* resources[PGL_CAPTURE_MAX_RESOURCES];
+
+static uint32_t frame_us[REPLAY_MAX_FRAMES];
+static uint32_t min_frame_us[REPLAY_MAX_FRAMES];
+static uint32_t frame_hashes[REPLAY_MAX_FRAMES];
+
+static void replay_fail(const char* message)
+{
+    fprintf(stderr, "capture replay: %s\n", message);
+    exit(1);
+}
+
+static const uint8_t* replay_read(replay_reader_t* reader, size_t size)
+{
+    if (reader->size - reader->offset < size)
+        replay_fail("the capture ends in the middle of a record");
+
+    const uint8_t* bytes = &reader->data[reader->offset];
+    reader->offset += size;
+    return bytes;
+}
+
+static uint8_t replay_read_u8(replay_reader_t* reader)
+{
+    return *replay_read(reader, 1);
+}
+
+static uint16_t replay_read_u16(replay_reader_t* reader)
+{
+    const uint8_t* bytes = replay_read(reader, 2);
+    return (uint16_t)(bytes[0] | (bytes[1] << 8));
+}
+
+static uint32_t replay_read_u32(replay_reader_t* reader)
+{
+    const uint8_t* bytes = replay_read(reader, 4);
+    return (uint32_t)bytes[0] | ((uint32_t)bytes[1] << 8) | ((uint32_t)bytes[2] << 16) | ((uint32_t)bytes[3] << 24);
+}
+
+// Reads the Q values of a vector, a quaternion or an array of them in memory order
+static void replay_read_values(replay_reader_t* reader, void* values, uint32_t size)
+{
+    for (uint32_t i = 0; i < size / sizeof(Q_TYPE); ++i)
+        ((Q_TYPE*)values)[i] = (Q_TYPE)replay_read_u32(reader);
+}
+
+// Returns the resource of the id, NULL only for PGL_CAPTURE_NULL when it is optional
+static const void* replay_read_resource(replay_reader_t* reader, bool optional)
+{
+    const uint16_t id = replay_read_u16(reader);
+    if (id == PGL_CAPTURE_NULL && optional)
+        return NULL;
+    if (id >= PGL_CAPTURE_MAX_RESOURCES || resources[id] == NULL)
+        replay_fail("a call refers to data that is not in the capture");
+    return resources[id];
+}
+
+// Returns the bytes of the "PGLC <hex>" lines of a serial capture, or the file itself when it is a binary capture
+static uint8_t* replay_decode(uint8_t* file, size_t* size)
+{
+    if (*size > 4 && memcmp(file, PGL_CAPTURE_MAGIC, 4) == 0 && file[4] == PGL_CAPTURE_VERSION)
+        return file;
+
+    // Hex digits take twice the space of the bytes, so the bytes fit in place
+    size_t decoded_size = 0;
+    for (size_t offset = 0; offset < *size;)
+    {
+        const size_t line_start = offset;
+        while (offset < *size && file[offset] != '\n')
+            ++offset;
+        const size_t line_end = offset++;
+
+        if (line_end - line_start < 5 || memcmp(&file[line_start], "PGLC ", 5) != 0)
+            continue;
+
+        for (size_t i = line_start + 5; i + 1 < line_end; i += 2)
+        {
+            unsigned int byte;
+            if (sscanf((const char*)&file[i], "%2x", &byte) != 1)
+                break;
+            file[decoded_size++] = (uint8_t)byte;
+        }
+    }
+
+    *size = decoded_size;
+    return file;
+}
+
+static uint32_t replay_hash_image(const swapchain_image_t* image)
+{
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+    const uint8_t* bytes = (const uint8_t*)image->colours;
+    for (uint32_t i = 0; i < sizeof(image->colours); ++i)
+        hash = (hash ^ bytes[i]) * 16777619u;
+    return hash;
+}
+
+// Replays the calls of the capture and returns the number of frames
+static uint32_t replay_run(const uint8_t* capture, size_t size)
+{
+    replay_reader_t reader = {capture, size, 0};
+
+    const uint8_t* magic = replay_read(&reader, 4);
+    const uint8_t version = replay_read_u8(&reader);
+    if (memcmp(magic, PGL_CAPTURE_MAGIC, 4) != 0 || version != PGL_CAPTURE_VERSION)
+        replay_fail("the file is not a capture of this version");
+
+    const uint8_t frac_bits   = replay_read_u8(&reader);
+    const uint8_t colour_size = replay_read_u8(&reader);
+    const uint8_t depth_size  = replay_read_u8(&reader);
+    const uint16_t width      = replay_read_u16(&reader);
+    const uint16_t height     = replay_read_u16(&reader);
+    if (frac_bits != Q_FRAC_BITS || colour_size != sizeof(colour_t) || depth_size != sizeof(depth_t) ||
+        width != SCREEN_WIDTH || height != SCREEN_HEIGHT)
+        replay_fail("the capture was made with another fixed-point type, colour format, depth precision or resolution");
+
+    uint32_t frame_count = 0;
+    uint64_t start_us = 0;
+
+    while (true)
+    {
+        const uint8_t record = replay_read_u8(&reader);
+        switch (record)
+        {
+            case PGL_CAPTURE_RECORD_RESOURCE:
+            {
+                const uint16_t id = replay_read_u16(&reader);
+                const uint32_t resource_size = replay_read_u32(&reader);
+                const uint8_t* bytes = replay_read(&reader, resource_size);
+                if (id >= PGL_CAPTURE_MAX_RESOURCES)
+                    replay_fail("a resource id is out of range");
+
+                // Repeated replays load every resource once
+                if (resources[id] == NULL)
+                {
+                    resources[id] = malloc(GREATER(resource_size, 1u));
+                    memcpy(resources[id], bytes, resource_size);
+                }
+                break;
+            }
+            case PGL_CAPTURE_RECORD_FRAME:
+            {
+                if (frame_count == REPLAY_MAX_FRAMES)
+                    replay_fail("the capture has too many frames");
+
+                // There is no display to consume the images, release the last one right away
+                swapchain_request_display_image();
+                while (!pgl_request_draw_image())
+                    swapchain_request_display_image();
+                start_us = time_us_64();
+                break;
+            }
+            case PGL_CAPTURE_RECORD_MODEL:
+            {
+                Q_VEC3 position, scale;
+                Q_QUAT rotation;
+                replay_read_values(&reader, &position, sizeof(position));
+                replay_read_values(&reader, &rotation, sizeof(rotation));
+                replay_read_values(&reader, &scale, sizeof(scale));
+                pgl_model(position, rotation, scale);
+                break;
+            }
+            case PGL_CAPTURE_RECORD_VIEW:
+            {
+                Q_VEC3 view[3];
+                replay_read_values(&reader, view, sizeof(view));
+                pgl_view(view[0], view[1], view[2]);
+                break;
+            }
+            case PGL_CAPTURE_RECORD_PROJECTION:
+            {
+                Q_TYPE projection[3];
+                replay_read_values(&reader, projection, sizeof(projection));
+                pgl_projection(projection[0], projection[1], projection[2]);
+                break;
+            }
+            case PGL_CAPTURE_RECORD_VIEWPORT:
+            {
+                const int32_t x = (int32_t)replay_read_u32(&reader);
+                const int32_t y = (int32_t)replay_read_u32(&reader);
+                const uint32_t viewport_width  = replay_read_u32(&reader);
+                const uint32_t viewport_height = replay_read_u32(&reader);
+                pgl_viewport(x, y, viewport_width, viewport_height);
+                break;
+            }
+            case PGL_CAPTURE_RECORD_CLEAR_COLOURS:
+                pgl_clear_colours((colour_t)replay_read_u32(&reader));
+                break;
+            case PGL_CAPTURE_RECORD_CLEAR_DEPTHS:
+                pgl_clear_depths((depth_t)replay_read_u32(&reader));
+                break;
+            case PGL_CAPTURE_RECORD_BIND_TEXTURE:
+            {
+                pgl_texture_t texture;
+                texture.texels      = replay_read_resource(&reader, false);
+                texture.mipmaps     = replay_read_resource(&reader, true);
+                texture.palette     = replay_read_resource(&reader, true);
+                texture.width_bits  = replay_read_u16(&reader);
+                texture.height_bits = replay_read_u16(&reader);
+                texture.level_count = replay_read_u16(&reader);
+                texture.format      = replay_read_u16(&reader);
+                texture.layout      = replay_read_u16(&reader);
+                pgl_bind_texture(&texture);
+                break;
+            }
+            case PGL_CAPTURE_RECORD_DRAW:
+            {
+                const bool packed = replay_read_u8(&reader);
+                const void* vertices = replay_read_resource(&reader, false);
+                const uint16_t* indices = replay_read_resource(&reader, false);
+                const uint16_t index_count = replay_read_u16(&reader);
+                if (packed)
+                    pgl_draw_packed(vertices, indices, index_count);
+                else
+                    pgl_draw(vertices, indices, index_count);
+                break;
+            }
+            case PGL_CAPTURE_RECORD_DRAW_MESHLETS:
+            {
+                const bool packed = replay_read_u8(&reader);
+                const void* vertices = replay_read_resource(&reader, false);
+                const pgl_meshlet_t* meshlets = replay_read_resource(&reader, false);
+                const uint16_t meshlet_count = replay_read_u16(&reader);
+                const uint8_t* indices = replay_read_resource(&reader, false);
+                if (packed)
+                    pgl_draw_packed_meshlets(vertices, meshlets, meshlet_count, indices);
+                else
+                    pgl_draw_meshlets(vertices, meshlets, meshlet_count, indices);
+                break;
+            }
+            case PGL_CAPTURE_RECORD_RESOLVE:
+            {
+                pgl_resolve();
+                frame_us[frame_count] = (uint32_t)(time_us_64() - start_us);
+                frame_hashes[frame_count] = replay_hash_image(swapchain_request_draw_image());
+                ++frame_count;
+                swapchain_swap_images();
+                break;
+            }
+            case PGL_CAPTURE_RECORD_END:
+                return frame_count;
+            default:
+                replay_fail("the capture holds an unknown record");
+        }
+    }
+}
+
+// Replays a capture of pgl_capture_frames, either the binary file written on the host or the serial output of the
+// device, repeat times. Prints the fastest time of each frame and a hash of its image, which tells whether a change
+// of pgl altered the output.
+int main(int argc, char** argv)
+{
+    if (argc != 2 && argc != 3)
+    {
+        fprintf(stderr, "usage: %s <capture> [repeat count]\n", argv[0]);
+        return 1;
+    }
+    const uint32_t repeat_count = (argc == 3) ? (uint32_t)GREATER(atoi(argv[2]), 1) : 1;
+
+    FILE* file = fopen(argv[1], "rb");
+    if (file == NULL)
+        replay_fail("cannot open the capture");
+    fseek(file, 0, SEEK_END);
+    size_t size = (size_t)ftell(file);
+    fseek(file, 0, SEEK_SET);
+    uint8_t* data = malloc(GREATER(size, (size_t)1));
+    if (fread(data, 1, size, file) != size)
+        replay_fail("cannot read the capture");
+    fclose(file);
+
+    const uint8_t* capture = replay_decode(data, &size);
+
+    stdio_init_all();
+    pgl_init();
+
+    uint32_t frame_count = 0;
+    for (uint32_t r = 0; r < repeat_count; ++r)
+    {
+        frame_count = replay_run(capture, size);
+        for (uint32_t i = 0; i < frame_count; ++i)
+            min_frame_us[i] = (r == 0) ? frame_us[i] : SMALLER(min_frame_us[i], frame_us[i]);
+    }
+
+    uint64_t total_us = 0;
+    for (uint32_t i = 0; i < frame_count; ++i)
+    {
+        printf("REPLAY frame %lu: %lu us, image %08lx\n", (unsigned long)i, (unsigned long)min_frame_us[i], (unsigned long)frame_hashes[i]);
+        total_us += min_frame_us[i];
+    }
+    printf("REPLAY %lu frames, %lu us on average\n", (unsigned long)frame_count, (unsigned long)((frame_count != 0) ? total_us / frame_count : 0));
+
+    return 0;
+}
@@ -0,0 +1,133 @@
+
+#include <stdio.h>
+#include <string.h>
+#include <pico/stdlib.h>
+
+#include "benchmark_scene.h"
+
+// Rendered before the image is written, so that the levels of detail settle from their initial choice
+#define GOLDEN_FRAME_COUNT 4
+
+typedef struct
+{
+    const char* name;
+    float position[3];
+    float target[3];
+    float roll;
+} golden_view_t;
+
+// Canonical views of the farm, each stressing a different part of the pipeline
+static const golden_view_t golden_views[] = {
+    {"overview", { -3.0f,  6.0f,   8.0f}, { -3.0f,  0.0f, -12.0f}, 0.0f},
+    {"rolled",   { 17.0f,  4.0f,  -2.0f}, { -3.0f,  0.0f, -14.0f}, 0.5f}, // Scanlines cross the textures diagonally
+    {"woods",    {  2.0f,  1.5f, -14.0f}, {  2.0f,  1.5f, -24.0f}, 0.0f}, // Trees cross the near plane
+    {"sheep",    {  5.0f, -0.5f,  -8.0f}, {  4.0f, -1.5f, -12.0f}, 0.0f}, // Close-ups pick the finest texture levels
+    {"overdraw", { 26.0f,  1.0f, -18.0f}, {-18.0f,  1.0f, -12.0f}, 0.0f}, // The rows of objects overlap the most
+    {"distant",  { 40.0f, 20.0f,  40.0f}, { -3.0f,  0.0f, -12.0f}, 0.0f}, // Coarse levels of detail and sub-pixel triangles
+    {"house",    {-18.0f,  2.0f,   2.0f}, {-18.0f,  2.0f,  -8.0f}, 0.0f},
+    {"far_sheep",{ 45.0f, 20.0f,  20.0f}, { 10.0f, -1.5f, -12.0f}, 0.0f}, // The eye lies far out in the space of the small models
+};
+
+#if defined(PGL_DEBUG_VIEWS)
+// Names of the debug views by pgl_debug_view_t
+static const char* const golden_debug_views[] = {"none", "overdraw", "depth_rejects", "tile_time"};
+#endif
+
+// Writes the draw image as a binary PPM with 8-bit channels
+static bool golden_write_image(const swapchain_image_t* image, const char* path)
+{
+    FILE* file = fopen(path, "wb");
+    if (file == NULL)
+        return false;
+
+    fprintf(file, "P6\n%d %d\n255\n", SCREEN_WIDTH, SCREEN_HEIGHT);
+    for (uint32_t y = 0; y < SCREEN_HEIGHT; ++y)
+    {
+        for (uint32_t x = 0; x < SCREEN_WIDTH; ++x)
+        {
+            const uint32_t colour = image->colours[y][x];
+            const uint8_t rgb[3] = {
+                (uint8_t)((colour & COLOUR_RED_BITS)   * 255u / COLOUR_RED_BITS),
+                (uint8_t)((colour & COLOUR_GREEN_BITS) * 255u / COLOUR_GREEN_BITS),
+                (uint8_t)((colour & COLOUR_BLUE_BITS)  * 255u / COLOUR_BLUE_BITS),
+            };
+            fwrite(rgb, 1, sizeof(rgb), file);
+        }
+    }
+
+    return fclose(file) == 0;
+}
+
+// Renders the views of the farm into <directory>/<view>.ppm, tools/golden_images.py compares them with the golden images.
+// PGL_DEBUG_VIEWS builds take the name of a debug view to render instead as an optional second argument.
+int main(int argc, char** argv)
+{
+#if defined(PGL_DEBUG_VIEWS)
+    if (argc != 2 && argc != 3)
+    {
+        fprintf(stderr, "usage: %s <output directory> [none|overdraw|depth_rejects|tile_time]\n", argv[0]);
+        return 1;
+    }
+#else
+    if (argc != 2)
+    {
+        fprintf(stderr, "usage: %s <output directory>\n", argv[0]);
+        return 1;
+    }
+#endif
+
+    stdio_init_all();
+    pgl_init();
+    pgl_viewport(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT);
+
+#if defined(PGL_DEBUG_VIEWS)
+    if (argc == 3)
+    {
+        uint32_t view = 0;
+        while (view < COUNT_OF(golden_debug_views) && strcmp(argv[2], golden_debug_views[view]) != 0)
+            ++view;
+        if (view == COUNT_OF(golden_debug_views))
+        {
+            fprintf(stderr, "unknown debug view %s\n", argv[2]);
+            return 1;
+        }
+        pgl_debug_view((pgl_debug_view_t)view);
+    }
+#endif
+
+    for (uint32_t i = 0; i < COUNT_OF(golden_views); ++i)
+    {
+        const golden_view_t* view = &golden_views[i];
+
+        scene_t scene;
+        farm_scene_build(&scene);
+        benchmark_look_at(view->position, view->target, view->roll, &scene.camera.transform);
+
+        for (uint32_t frame = 0; frame < GOLDEN_FRAME_COUNT; ++frame)
+        {
+            // There is no display to consume the images, release the last one right away
+            swapchain_request_display_image();
+            while (!pgl_request_draw_image())
+                swapchain_request_display_image();
+
+            pgl_clear_colours(COLOUR_BLACK);
+            pgl_clear_depths(DEPTH_FURTHEST);
+            scene_draw(&scene);
+            pgl_resolve();
+
+            if (frame + 1 < GOLDEN_FRAME_COUNT)
+                swapchain_swap_images();
+        }
+
+        char path[256];
+        snprintf(path, sizeof(path), "%s/%s.ppm", argv[1], view->name);
+        if (!golden_write_image(swapchain_request_draw_image(), path))
+        {
+            fprintf(stderr, "cannot write %s\n", path);
+            return 1;
+        }
+        swapchain_swap_images();
+    }
+
+    return 0;
+}
@@ -0,0 +1,141 @@
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pico/stdlib.h>
+
+#include "benchmark_scene.h"
+#include "input/input_camera.h"
+
+static int input_replay_compare_us(const void* a, const void* b)
+{
+    const uint32_t x = *(const uint32_t*)a;
+    const uint32_t y = *(const uint32_t*)b;
+    return (x > y) - (x < y);
+}
+
+// Loads the last recording of the "INPUT" lines of input_log_dump in the serial output, returns whether there is one
+static bool input_replay_load(FILE* file, input_log_t* log)
+{
+    uint32_t capacity = 0;
+    input_log_event_t* events = NULL;
+    bool loaded = false;
+
+    char line[256];
+    while (fgets(line, sizeof(line), file) != NULL)
+    {
+        const char* text = strstr(line, "INPUT ");
+        if (text == NULL)
+            continue;
+
+        unsigned long tick, state;
+        if (strncmp(text, "INPUT START", 11) == 0)
+        {
+            transform_component_t start;
+            Q_TYPE* values = (Q_TYPE*)&start;
+            const char* cursor = text + 11;
+            uint32_t count = 0;
+            int length;
+            while (count < sizeof(start) / sizeof(Q_TYPE) && sscanf(cursor, " %lx%n", &state, &length) == 1)
+            {
+                values[count++] = (Q_TYPE)(uint32_t)state;
+                cursor += length;
+            }
+            if (count != sizeof(start) / sizeof(Q_TYPE))
+                continue;
+
+            // A new recording replaces the previous one
+            input_log_init(log, events, capacity);
+            input_log_record(log, &start);
+            input_log_stop(log);
+            loaded = false;
+        }
+        else if (sscanf(text, "INPUT KEYS %lx %lx", &tick, &state) == 2)
+        {
+            if (log->event_count == capacity)
+            {
+                capacity = GREATER(2 * capacity, 64u);
+                events = realloc(events, capacity * sizeof(input_log_event_t));
+                log->events = events;
+                log->capacity = capacity;
+            }
+            log->events[log->event_count++] = (input_log_event_t){(uint32_t)tick, (input_state_t)state};
+        }
+        else if (sscanf(text, "INPUT END %lx", &tick) == 1)
+        {
+            log->tick_count = (uint32_t)tick;
+            loaded = true;
+        }
+    }
+
+    return loaded;
+}
+
+// Replays a key recording of main.c, taken from the serial output of the device, on the scene of main.c. Renders a frame
+// per physics tick like the replay on the device and prints the same "INPUT FRAME <tick> <us>" lines, then a
+// "BENCH <json>" line of the "input" path, which tools/bench_compare.py compares against a baseline.
+int main(int argc, char** argv)
+{
+    if (argc != 2)
+    {
+        fprintf(stderr, "usage: %s <serial output with an input recording>\n", argv[0]);
+        return 1;
+    }
+
+    FILE* file = fopen(argv[1], "r");
+    if (file == NULL)
+    {
+        fprintf(stderr, "input replay: cannot open %s\n", argv[1]);
+        return 1;
+    }
+    input_log_t log = {0};
+    const bool loaded = input_replay_load(file, &log);
+    fclose(file);
+    if (!loaded || log.tick_count == 0)
+    {
+        fprintf(stderr, "input replay: %s holds no complete input recording\n", argv[1]);
+        return 1;
+    }
+
+    stdio_init_all();
+    pgl_init();
+    pgl_viewport(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT);
+
+    scene_t scene;
+    farm_scene_build(&scene);
+    input_log_replay(&log, &scene.camera.transform);
+
+    uint32_t* frame_us = malloc(log.tick_count * sizeof(uint32_t));
+    uint64_t total_us = 0;
+    uint64_t triangle_count = 0;
+
+    for (uint32_t tick = 0; tick < log.tick_count; ++tick)
+    {
+        input_camera_step(input_log_step(&log, 0), &scene.camera.transform);
+
+        // There is no display to consume the images, release the last one right away
+        swapchain_request_display_image();
+        while (!pgl_request_draw_image())
+            swapchain_request_display_image();
+
+        // The window main.c times, from the clears to the resolve
+        const uint64_t start_us = time_us_64();
+        pgl_clear_colours(COLOUR_BLACK);
+        pgl_clear_depths(DEPTH_FURTHEST);
+        triangle_count += scene_draw(&scene);
+        pgl_resolve();
+        frame_us[tick] = (uint32_t)(time_us_64() - start_us);
+        swapchain_swap_images();
+
+        printf("INPUT FRAME %lu %lu\n", (unsigned long)tick, (unsigned long)frame_us[tick]);
+        total_us += frame_us[tick];
+    }
+
+    qsort(frame_us, log.tick_count, sizeof(frame_us[0]), input_replay_compare_us);
+    const uint32_t p99_index = (log.tick_count * 99 + 99) / 100 - 1;
+    printf("BENCH {\"path\": \"input\", \"frames\": %lu, \"min_us\": %lu, \"avg_us\": %lu, \"p99_us\": %lu, \"max_us\": %lu, \"triangles\": %lu}\n",
+        (unsigned long)log.tick_count, (unsigned long)frame_us[0], (unsigned long)(total_us / log.tick_count),
+        (unsigned long)frame_us[p99_index], (unsigned long)frame_us[log.tick_count - 1], (unsigned long)(triangle_count / log.tick_count));
+
+    return 0;
+}
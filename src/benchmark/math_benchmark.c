@@ -0,0 +1,414 @@
+
+#include <stdio.h>
+#include <math.h>
+#include <pico/stdlib.h>
+
+#if PICO_ON_DEVICE
+    #include <hardware/clocks.h>
+#endif
+
+// The Cortex-M33 of RP2350 counts cycles, the other cores are timed in microseconds
+#if PICO_ON_DEVICE && PICO_RP2350 && !defined(__riscv)
+    #include <hardware/structs/m33.h>
+    #define BENCHMARK_CYCLE_COUNTER 1
+#else
+    #define BENCHMARK_CYCLE_COUNTER 0
+#endif
+
+#include "common/macros.h"
+#include "common/reciprocal.h"
+
+#define BENCHMARK_SAMPLE_COUNT  1024
+#define BENCHMARK_REPEAT_COUNT  64
+#define BENCHMARK_PERIOD_MS     5000
+
+// Reciprocals in pgl are taken of clip-space w in [near, far] and of edge heights in pixels
+#define BENCHMARK_MIN_INPUT     0.1f
+#define BENCHMARK_MAX_INPUT     100.0f
+
+typedef struct
+{
+    float min;
+    float max;
+} benchmark_range_t;
+
+static Q_TYPE inputs[BENCHMARK_SAMPLE_COUNT];
+static Q_TYPE factors[BENCHMARK_SAMPLE_COUNT];
+static Q_VEC4 vectors[BENCHMARK_SAMPLE_COUNT];
+static Q_MAT4 mvp;
+static Q_MAT4 viewport;
+static volatile Q_TYPE sink;
+
+// Results are folded by XOR, which cannot overflow like a sum
+#define BENCHMARK_FOLD(acc, q)  ((acc) ^= (uint32_t)(q))
+#define BENCHMARK_FOLD4(acc, v) ((acc) ^= (uint32_t)((v).x ^ (v).y ^ (v).z ^ (v).w))
+
+static inline uint32_t benchmark_ticks()
+{
+#if BENCHMARK_CYCLE_COUNTER
+    return m33_hw->dwt_cyccnt;
+#else
+    return time_us_32();
+#endif
+}
+
+static void benchmark_init_ticks()
+{
+#if BENCHMARK_CYCLE_COUNTER
+    m33_hw->demcr |= M33_DEMCR_TRCENA_BITS;
+    m33_hw->dwt_ctrl |= M33_DWT_CTRL_CYCCNTENA_BITS;
+#endif
+}
+
+static void benchmark_fill_inputs()
+{
+    // Logarithmically spaced, so that every magnitude is equally represented
+    const float ratio = powf(BENCHMARK_MAX_INPUT / BENCHMARK_MIN_INPUT, 1.0f / (BENCHMARK_SAMPLE_COUNT - 1));
+    float value = BENCHMARK_MIN_INPUT;
+    for (uint32_t i = 0; i < BENCHMARK_SAMPLE_COUNT; ++i)
+    {
+        inputs[i] = Q_FROM_FLOAT(value);
+        value *= ratio;
+    }
+
+    // Positions of the scene, in view of the camera of main.c, with the w of points and of clip-space vertices
+    for (uint32_t i = 0; i < BENCHMARK_SAMPLE_COUNT; ++i)
+    {
+        const float t = (float)i / BENCHMARK_SAMPLE_COUNT;
+        factors[i] = Q_FROM_FLOAT(2.0f * t - 1.0f);
+        vectors[i] = (Q_VEC4){{
+            Q_FROM_FLOAT(8.0f * sinf(37.0f * t)),
+            Q_FROM_FLOAT(4.0f * cosf(23.0f * t)),
+            Q_FROM_FLOAT(-2.0f - 20.0f * t),
+            Q_FROM_FLOAT(1.0f + 7.0f * t),
+        }};
+    }
+
+    const Q_MAT4 view = q_view(Q_VEC3_ZERO, Q_VEC3_BACKWARD, Q_VEC3_UP);
+    const Q_MAT4 projection = q_perspective(Q_QUARTERPI, Q_ONE, Q_FROM_FLOAT(0.1f), Q_FROM_FLOAT(100.0f));
+    mvp = q_mat4_mul_mat4(projection, view);
+    viewport = q_viewport(0, 0, 240, 240);
+}
+
+static uint32_t benchmark_q_div()
+{
+    Q_TYPE sum = Q_ZERO;
+    const uint32_t start = benchmark_ticks();
+    for (uint32_t r = 0; r < BENCHMARK_REPEAT_COUNT; ++r)
+        for (uint32_t i = 0; i < BENCHMARK_SAMPLE_COUNT; ++i)
+            sum = q_add(sum, q_div(Q_ONE, inputs[i]));
+    const uint32_t elapsed = benchmark_ticks() - start;
+    sink = sum;
+    return elapsed;
+}
+
+static uint32_t benchmark_q_reciprocal()
+{
+    Q_TYPE sum = Q_ZERO;
+    const uint32_t start = benchmark_ticks();
+    for (uint32_t r = 0; r < BENCHMARK_REPEAT_COUNT; ++r)
+        for (uint32_t i = 0; i < BENCHMARK_SAMPLE_COUNT; ++i)
+            sum = q_add(sum, q_reciprocal(inputs[i]));
+    const uint32_t elapsed = benchmark_ticks() - start;
+    sink = sum;
+    return elapsed;
+}
+
+// ------------------------------------- COST TABLE ------------------------------------- //
+
+// The loop and the folding of the results without an operation, included in every other row
+static uint32_t benchmark_loop()
+{
+    uint32_t acc = 0;
+    const uint32_t start = benchmark_ticks();
+    for (uint32_t r = 0; r < BENCHMARK_REPEAT_COUNT; ++r)
+        for (uint32_t i = 0; i < BENCHMARK_SAMPLE_COUNT; ++i)
+            BENCHMARK_FOLD(acc, inputs[i]);
+    const uint32_t elapsed = benchmark_ticks() - start;
+    sink = (Q_TYPE)acc;
+    return elapsed;
+}
+
+static uint32_t benchmark_cost_q_mul()
+{
+    uint32_t acc = 0;
+    const uint32_t start = benchmark_ticks();
+    for (uint32_t r = 0; r < BENCHMARK_REPEAT_COUNT; ++r)
+        for (uint32_t i = 0; i < BENCHMARK_SAMPLE_COUNT; ++i)
+            BENCHMARK_FOLD(acc, q_mul(inputs[i], factors[i]));
+    const uint32_t elapsed = benchmark_ticks() - start;
+    sink = (Q_TYPE)acc;
+    return elapsed;
+}
+
+static uint32_t benchmark_cost_q_div()
+{
+    uint32_t acc = 0;
+    const uint32_t start = benchmark_ticks();
+    for (uint32_t r = 0; r < BENCHMARK_REPEAT_COUNT; ++r)
+        for (uint32_t i = 0; i < BENCHMARK_SAMPLE_COUNT; ++i)
+            BENCHMARK_FOLD(acc, q_div(factors[i], inputs[i]));
+    const uint32_t elapsed = benchmark_ticks() - start;
+    sink = (Q_TYPE)acc;
+    return elapsed;
+}
+
+static uint32_t benchmark_cost_q_reciprocal()
+{
+    uint32_t acc = 0;
+    const uint32_t start = benchmark_ticks();
+    for (uint32_t r = 0; r < BENCHMARK_REPEAT_COUNT; ++r)
+        for (uint32_t i = 0; i < BENCHMARK_SAMPLE_COUNT; ++i)
+            BENCHMARK_FOLD(acc, q_reciprocal(inputs[i]));
+    const uint32_t elapsed = benchmark_ticks() - start;
+    sink = (Q_TYPE)acc;
+    return elapsed;
+}
+
+static uint32_t benchmark_cost_q_vec4_dot()
+{
+    uint32_t acc = 0;
+    const uint32_t start = benchmark_ticks();
+    for (uint32_t r = 0; r < BENCHMARK_REPEAT_COUNT; ++r)
+        for (uint32_t i = 0; i < BENCHMARK_SAMPLE_COUNT; ++i)
+            BENCHMARK_FOLD(acc, q_vec4_dot(vectors[i], vectors[(i + 1) % BENCHMARK_SAMPLE_COUNT]));
+    const uint32_t elapsed = benchmark_ticks() - start;
+    sink = (Q_TYPE)acc;
+    return elapsed;
+}
+
+static uint32_t benchmark_cost_q_vec4_interp()
+{
+    uint32_t acc = 0;
+    const uint32_t start = benchmark_ticks();
+    for (uint32_t r = 0; r < BENCHMARK_REPEAT_COUNT; ++r)
+        for (uint32_t i = 0; i < BENCHMARK_SAMPLE_COUNT; ++i)
+            BENCHMARK_FOLD4(acc, q_vec4_interp(vectors[i], vectors[(i + 1) % BENCHMARK_SAMPLE_COUNT], factors[i]));
+    const uint32_t elapsed = benchmark_ticks() - start;
+    sink = (Q_TYPE)acc;
+    return elapsed;
+}
+
+static uint32_t benchmark_cost_q_mat4_mul_vec4()
+{
+    uint32_t acc = 0;
+    const uint32_t start = benchmark_ticks();
+    for (uint32_t r = 0; r < BENCHMARK_REPEAT_COUNT; ++r)
+        for (uint32_t i = 0; i < BENCHMARK_SAMPLE_COUNT; ++i)
+            BENCHMARK_FOLD4(acc, q_mat4_mul_vec4(mvp, vectors[i]));
+    const uint32_t elapsed = benchmark_ticks() - start;
+    sink = (Q_TYPE)acc;
+    return elapsed;
+}
+
+// A vertex from the vertex shader to the viewport, as in pgl_draw_triangle
+static uint32_t benchmark_cost_vertex()
+{
+    uint32_t acc = 0;
+    const uint32_t start = benchmark_ticks();
+    for (uint32_t r = 0; r < BENCHMARK_REPEAT_COUNT; ++r)
+    {
+        for (uint32_t i = 0; i < BENCHMARK_SAMPLE_COUNT; ++i)
+        {
+            const Q_VEC4 clip = q_mat4_mul_vec4(mvp, vectors[i]);
+            const Q_TYPE inv_depth = q_reciprocal(clip.w);
+            BENCHMARK_FOLD4(acc, q_mat4_mul_vec4(viewport, q_vec4_scale(clip, inv_depth)));
+        }
+    }
+    const uint32_t elapsed = benchmark_ticks() - start;
+    sink = (Q_TYPE)acc;
+    return elapsed;
+}
+
+// An edge against a clip plane, as in pgl_clip_poly_plane
+static uint32_t benchmark_cost_clip_edge()
+{
+    const Q_VEC4 near_plane = {{Q_ZERO, Q_ZERO, Q_ONE, Q_ONE}};
+
+    uint32_t acc = 0;
+    const uint32_t start = benchmark_ticks();
+    for (uint32_t r = 0; r < BENCHMARK_REPEAT_COUNT; ++r)
+    {
+        for (uint32_t i = 0; i < BENCHMARK_SAMPLE_COUNT; ++i)
+        {
+            const Q_VEC4 curr = vectors[i];
+            const Q_VEC4 prev = vectors[(i + 1) % BENCHMARK_SAMPLE_COUNT];
+            const Q_TYPE curr_dot = q_vec4_dot(curr, near_plane);
+            const Q_TYPE prev_dot = q_vec4_dot(prev, near_plane);
+            if (q_ne(curr_dot, prev_dot))
+                BENCHMARK_FOLD4(acc, q_vec4_interp(prev, curr, q_div(curr_dot, q_sub(curr_dot, prev_dot))));
+        }
+    }
+    const uint32_t elapsed = benchmark_ticks() - start;
+    sink = (Q_TYPE)acc;
+    return elapsed;
+}
+
+// The perspective-correct texture coordinates at the end of a sub-span, as in pgl_rasterise_scanline
+static uint32_t benchmark_cost_span_step()
+{
+    uint32_t acc = 0;
+    const uint32_t start = benchmark_ticks();
+    for (uint32_t r = 0; r < BENCHMARK_REPEAT_COUNT; ++r)
+    {
+        for (uint32_t i = 0; i < BENCHMARK_SAMPLE_COUNT; ++i)
+        {
+            const Q_TYPE inv_w = q_reciprocal(vectors[i].w);
+            BENCHMARK_FOLD(acc, q_mul(vectors[i].x, inv_w) ^ q_mul(vectors[i].y, inv_w));
+        }
+    }
+    const uint32_t elapsed = benchmark_ticks() - start;
+    sink = (Q_TYPE)acc;
+    return elapsed;
+}
+
+// The depth of a pixel, as in pgl_depth_map
+static uint32_t benchmark_cost_depth_map()
+{
+    const Q_TYPE near = Q_FROM_FLOAT(0.1f);
+    const Q_TYPE range = q_sub(Q_FROM_FLOAT(100.0f), near);
+
+    uint32_t acc = 0;
+    const uint32_t start = benchmark_ticks();
+    for (uint32_t r = 0; r < BENCHMARK_REPEAT_COUNT; ++r)
+        for (uint32_t i = 0; i < BENCHMARK_SAMPLE_COUNT; ++i)
+            BENCHMARK_FOLD(acc, Q_TO_INT(q_mul_int(q_div(q_sub(inputs[i], near), range), 255)));
+    const uint32_t elapsed = benchmark_ticks() - start;
+    sink = (Q_TYPE)acc;
+    return elapsed;
+}
+
+typedef struct
+{
+    const char* name;
+    uint32_t (*run)();
+} benchmark_cost_t;
+
+static const benchmark_cost_t costs[] = {
+    {"loop",            benchmark_loop},
+    {"q_mul",           benchmark_cost_q_mul},
+    {"q_div",           benchmark_cost_q_div},
+    {"q_reciprocal",    benchmark_cost_q_reciprocal},
+    {"q_vec4_dot",      benchmark_cost_q_vec4_dot},
+    {"q_vec4_interp",   benchmark_cost_q_vec4_interp},
+    {"q_mat4_mul_vec4", benchmark_cost_q_mat4_mul_vec4},
+    {"vertex",          benchmark_cost_vertex},
+    {"clip edge",       benchmark_cost_clip_edge},
+    {"span step",       benchmark_cost_span_step},
+    {"depth map",       benchmark_cost_depth_map},
+};
+
+static void benchmark_print_timing(const char* name, uint32_t ticks)
+{
+    const uint32_t call_count = BENCHMARK_REPEAT_COUNT * BENCHMARK_SAMPLE_COUNT;
+
+#if BENCHMARK_CYCLE_COUNTER
+    const double cycles_per_call = (double)ticks / call_count;
+    const double ns_per_call = cycles_per_call * 1e9 / clock_get_hz(clk_sys);
+#else
+    const double ns_per_call = (double)ticks * 1000.0 / call_count;
+#endif
+
+#if BENCHMARK_CYCLE_COUNTER
+    printf("%-16s %10.1f ns %10.1f cycles\n", name, ns_per_call, cycles_per_call);
+#elif PICO_ON_DEVICE
+    // Estimated from the time, without a cycle counter
+    const double cycles_per_call = ns_per_call * clock_get_hz(clk_sys) / 1e9;
+    printf("%-16s %10.1f ns %10.1f cycles\n", name, ns_per_call, cycles_per_call);
+#else
+    printf("%-16s %10.1f ns\n", name, ns_per_call);
+#endif
+}
+
+typedef struct
+{
+    uint32_t count;
+    uint32_t exact_count;
+    int32_t max_ulp_diff;
+    double max_div_error;
+    double max_reciprocal_error;
+} benchmark_accuracy_t;
+
+static void benchmark_add_accuracy(benchmark_accuracy_t* accuracy, Q_TYPE input)
+{
+    const Q_TYPE div = q_div(Q_ONE, input);
+    const Q_TYPE reciprocal = q_reciprocal(input);
+    const double exact = (1.0 / ((double)input / Q_ONE)) * Q_ONE;
+
+    const int32_t ulp_diff = ABS(reciprocal - div);
+    accuracy->max_ulp_diff = GREATER(accuracy->max_ulp_diff, ulp_diff);
+    accuracy->max_div_error = GREATER(accuracy->max_div_error, fabs(div - exact) / exact);
+    accuracy->max_reciprocal_error = GREATER(accuracy->max_reciprocal_error, fabs(reciprocal - exact) / exact);
+    accuracy->exact_count += (ulp_diff == 0);
+    ++accuracy->count;
+}
+
+static void benchmark_print_accuracy(const char* label, const benchmark_accuracy_t* accuracy)
+{
+    printf("%-16s %6lu %9.1f%% %8ld %12.3e %12.3e\n",
+        label, (unsigned long)accuracy->count,
+        (accuracy->count != 0) ? 100.0 * accuracy->exact_count / accuracy->count : 0.0,
+        (long)accuracy->max_ulp_diff, accuracy->max_div_error, accuracy->max_reciprocal_error);
+}
+
+static void benchmark_print_range_accuracy(benchmark_range_t range)
+{
+    benchmark_accuracy_t accuracy = {0};
+    for (uint32_t i = 0; i < BENCHMARK_SAMPLE_COUNT; ++i)
+    {
+        const double x = (double)inputs[i] / Q_ONE;
+        if (x >= range.min && x < range.max)
+            benchmark_add_accuracy(&accuracy, inputs[i]);
+    }
+
+    char label[32];
+    snprintf(label, sizeof(label), "[%6.1f, %6.1f)", range.min, range.max);
+    benchmark_print_accuracy(label, &accuracy);
+}
+
+// Every power of two whose reciprocal fits in Q_TYPE without rounding to zero, where the steps of Q8_24 fell an ulp short
+static void benchmark_print_power_accuracy()
+{
+    benchmark_accuracy_t accuracy = {0};
+    for (int32_t bit = GREATER(2 * (int32_t)Q_FRAC_BITS - 30, 0); bit <= SMALLER(2 * (int32_t)Q_FRAC_BITS, 30); ++bit)
+        benchmark_add_accuracy(&accuracy, (Q_TYPE)(1u << bit));
+
+    benchmark_print_accuracy("powers of 2", &accuracy);
+}
+
+int main()
+{
+    stdio_init_all();
+    benchmark_init_ticks();
+    benchmark_fill_inputs();
+
+    static const benchmark_range_t ranges[] = {
+        {  0.1f,   1.0f},
+        {  1.0f,  10.0f},
+        { 10.0f, 100.1f},
+    };
+
+    while (true)
+    {
+        printf("\n---------------- q_div(Q_ONE, x) vs q_reciprocal(x), %u fractional bits ----------------\n", Q_FRAC_BITS);
+
+        printf("\n%-16s %13s\n", "operation", "time/call");
+        benchmark_print_timing("q_div", benchmark_q_div());
+        benchmark_print_timing("q_reciprocal", benchmark_q_reciprocal());
+
+        printf("\n%-16s %6s %10s %8s %12s %12s\n", "input range", "count", "same", "max ulp", "div rel err", "recip rel err");
+        FOR_EACH(i, ranges)
+            benchmark_print_range_accuracy(ranges[i]);
+        benchmark_print_power_accuracy();
+
+        // The Q format is chosen at build time, build once per format to compare them
+        printf("\n---------------- cost table, %u fractional bits ----------------\n", Q_FRAC_BITS);
+        printf("\n%-16s %13s\n", "operation", "time/call");
+        FOR_EACH(i, costs)
+            benchmark_print_timing(costs[i].name, costs[i].run());
+
+        sleep_ms(BENCHMARK_PERIOD_MS);
+    }
+
+    return 0;
+}
@@ -0,0 +1,165 @@
+#include <math.h>
+#include <stdio.h>
+#include <pico/stdlib.h>
+
+#include "benchmark_scene.h"
+
+#if !defined(PGL_STATS)
+    #error "The meshlet check counts the triangles reaching the pipeline and requires PGL_STATS!"
+#endif
+
+// Cones whose test lands this close to the cutoff may go either way in fixed point, their meshlets are left out
+#define MESHLET_CHECK_MARGIN       0.05f
+#define MESHLET_CHECK_MAX_MESHLETS 256
+
+// Directions of the eyes around an object, the faces and the corners of a cube
+static const float meshlet_check_directions[][3] = {
+    { 1.0f,  0.0f,  0.0f}, {-1.0f,  0.0f,  0.0f}, { 0.0f,  1.0f,  0.0f}, { 0.0f, -1.0f,  0.0f}, { 0.0f,  0.0f,  1.0f}, { 0.0f,  0.0f, -1.0f},
+    { 1.0f,  1.0f,  1.0f}, { 1.0f,  1.0f, -1.0f}, { 1.0f, -1.0f,  1.0f}, { 1.0f, -1.0f, -1.0f},
+    {-1.0f,  1.0f,  1.0f}, {-1.0f,  1.0f, -1.0f}, {-1.0f, -1.0f,  1.0f}, {-1.0f, -1.0f, -1.0f},
+};
+
+// Distances of the eyes in radii of the object, the sphere of a meshlet stays inside the frustum from 3 radii on
+static const float meshlet_check_radii[] = {3.0f, 10.0f, 40.0f, 160.0f};
+
+// Copies the meshlets of the mesh but those with the eye at the edge of their cones, and returns how many triangles of
+// the copies lie in meshlets whose cones do not hold the eye, computed in floating point
+static uint32_t meshlet_check_select(const mesh_t* mesh, const float eye[3], pgl_meshlet_t* meshlets, uint16_t* meshlet_count)
+{
+    uint32_t triangle_count = 0;
+    *meshlet_count = 0;
+    for (uint16_t m = 0; m < mesh->meshlet_count; ++m)
+    {
+        const pgl_meshlet_t* meshlet = &mesh->meshlets[m];
+        const float cutoff = Q_TO_FLOAT(meshlet->cone_cutoff);
+        const float offset[3] = {
+            Q_TO_FLOAT(meshlet->cone_apex.x) - eye[0],
+            Q_TO_FLOAT(meshlet->cone_apex.y) - eye[1],
+            Q_TO_FLOAT(meshlet->cone_apex.z) - eye[2],
+        };
+        const float along = offset[0] * Q_TO_FLOAT(meshlet->cone_axis.x) + offset[1] * Q_TO_FLOAT(meshlet->cone_axis.y) + offset[2] * Q_TO_FLOAT(meshlet->cone_axis.z);
+        const float length = sqrtf(offset[0] * offset[0] + offset[1] * offset[1] + offset[2] * offset[2]);
+        const float cosine = along / length;
+
+        // Without a cone, the cutoff lies above any cosine
+        if (fabsf(cosine - cutoff) < MESHLET_CHECK_MARGIN)
+            continue;
+
+        meshlets[(*meshlet_count)++] = *meshlet;
+        if (cosine < cutoff)
+            triangle_count += meshlet->triangle_count;
+    }
+    return triangle_count;
+}
+
+// Draws the mesh of every model of the farm from eyes close by and far away, and compares the triangles left by the cone
+// test of pgl_draw_packed_meshlets with a floating point one. A small model far away puts the eye hundreds of units out
+// in the space of its packed vertices, where the squares of the test overflowed Q8_24. Prints a "MESHLET CHECK" line per
+// model and returns 1 on any difference.
+int main()
+{
+    stdio_init_all();
+    pgl_init();
+    pgl_viewport(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT);
+
+    scene_t scene;
+    farm_scene_build(&scene);
+
+    uint32_t failures = 0;
+    for (uint32_t i = 0; i < scene.object_count; ++i)
+    {
+        const object_t* object = &scene.objects[i];
+        const mesh_t* mesh = &object->model.mesh;
+
+        // Only the first object of every model, and only meshes split into packed meshlets
+        bool seen = false;
+        for (uint32_t j = 0; j < i; ++j)
+            seen = seen || (scene.objects[j].model.mesh.meshlets == mesh->meshlets);
+        if (seen || mesh->meshlets == NULL || mesh->packed_vertices == NULL || mesh->meshlet_count > MESHLET_CHECK_MAX_MESHLETS)
+            continue;
+
+        // The model matrix of model_draw, with the bounds of the packed positions folded in
+        const Q_VEC3 scale = object->transform.scale;
+        const Q_VEC3 scaled_origin = {{q_mul(scale.x, mesh->origin.x), q_mul(scale.y, mesh->origin.y), q_mul(scale.z, mesh->origin.z)}};
+        const Q_VEC3 scaled_extent = {{q_mul(scale.x, mesh->extent.x), q_mul(scale.y, mesh->extent.y), q_mul(scale.z, mesh->extent.z)}};
+        const Q_VEC3 centre = q_vec3_add(object->transform.position, q_quat_rotate_vec3(object->transform.rotation, scaled_origin));
+        const Q_VEC3 axes[3] = {
+            q_quat_rotate_vec3(object->transform.rotation, Q_VEC3_RIGHT),
+            q_quat_rotate_vec3(object->transform.rotation, Q_VEC3_UP),
+            q_quat_rotate_vec3(object->transform.rotation, Q_VEC3_BACKWARD),
+        };
+        const float extent[3] = {Q_TO_FLOAT(scaled_extent.x), Q_TO_FLOAT(scaled_extent.y), Q_TO_FLOAT(scaled_extent.z)};
+        const float radius = Q_TO_FLOAT(q_mul(object->model.radius, GREATER(GREATER(ABS(scale.x), ABS(scale.y)), ABS(scale.z))));
+
+        uint32_t eye_count = 0;
+        uint32_t left_out = 0;
+        uint32_t mismatches = 0;
+        for (uint32_t r = 0; r < COUNT_OF(meshlet_check_radii); ++r)
+        {
+            // The far plane clips the whole object beyond it
+            const float distance = meshlet_check_radii[r] * radius;
+            if (distance + radius > Q_TO_FLOAT(scene.camera.camera.far))
+                continue;
+
+            for (uint32_t d = 0; d < COUNT_OF(meshlet_check_directions); ++d)
+            {
+                const float* direction = meshlet_check_directions[d];
+                const float norm = sqrtf(direction[0] * direction[0] + direction[1] * direction[1] + direction[2] * direction[2]);
+                const float target[3] = {Q_TO_FLOAT(centre.x), Q_TO_FLOAT(centre.y), Q_TO_FLOAT(centre.z)};
+                const float position[3] = {
+                    target[0] + direction[0] / norm * distance,
+                    target[1] + direction[1] / norm * distance,
+                    target[2] + direction[2] / norm * distance,
+                };
+
+                // Straight up or down, the camera is turned a little so that looking at the target stays defined
+                const float look_target[3] = {target[0], target[1], target[2] + ((direction[0] == 0.0f && direction[2] == 0.0f) ? 0.01f * distance : 0.0f)};
+                benchmark_look_at(position, look_target, 0.0f, &scene.camera.transform);
+
+                // The eye in the space of the packed vertices
+                float eye[3];
+                for (uint32_t axis = 0; axis < 3; ++axis)
+                {
+                    const float along = (position[0] - target[0]) * Q_TO_FLOAT(axes[axis].x) +
+                                        (position[1] - target[1]) * Q_TO_FLOAT(axes[axis].y) +
+                                        (position[2] - target[2]) * Q_TO_FLOAT(axes[axis].z);
+                    eye[axis] = along / extent[axis];
+                }
+
+                pgl_meshlet_t meshlets[MESHLET_CHECK_MAX_MESHLETS];
+                uint16_t meshlet_count;
+                const uint32_t expected = meshlet_check_select(mesh, eye, meshlets, &meshlet_count);
+                left_out += mesh->meshlet_count - meshlet_count;
+                ++eye_count;
+
+                swapchain_request_display_image();
+                while (!pgl_request_draw_image())
+                    swapchain_request_display_image();
+
+                camera_set_view_proj(&scene.camera);
+                pgl_bind_texture(&object->model.texture);
+                pgl_model(centre, object->transform.rotation, scaled_extent);
+                pgl_draw_packed_meshlets(mesh->packed_vertices, meshlets, meshlet_count, mesh->meshlet_indices);
+                pgl_resolve();
+                swapchain_swap_images();
+
+                uint32_t triangle_count = 0;
+                for (uint core = 0; core < NUM_CORES; ++core)
+                    triangle_count += pgl_stats(core).triangles_in;
+
+                if (triangle_count != expected)
+                {
+                    printf("MESHLET MISMATCH object %lu eye %.2f %.2f %.2f: %lu triangles instead of %lu\n", (unsigned long)i,
+                        position[0], position[1], position[2], (unsigned long)triangle_count, (unsigned long)expected);
+                    ++mismatches;
+                }
+            }
+        }
+
+        printf("MESHLET CHECK object %lu: %lu meshlets, %lu eyes, %lu meshlets left out at the edge of a cone, %lu mismatches\n", (unsigned long)i,
+            (unsigned long)mesh->meshlet_count, (unsigned long)eye_count, (unsigned long)left_out, (unsigned long)mismatches);
+        failures += mismatches;
+    }
+
+    return (failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,214 @@
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pico/stdlib.h>
+
+#include "benchmark_scene.h"
+
+#define BENCHMARK_FRAME_COUNT   120
+#define BENCHMARK_WARMUP_FRAMES 4
+#define BENCHMARK_PERIOD_MS     5000
+
+typedef struct
+{
+    float position[3];
+    float target[3];
+} benchmark_key_t;
+
+// The camera moves through the keys at a constant rate, looking at the interpolated target
+typedef struct
+{
+    const char* name;
+    const benchmark_key_t* keys;
+    uint32_t key_count;
+} benchmark_path_t;
+
+// Circles the farm looking at its centre
+static const benchmark_key_t benchmark_orbit_keys[] = {
+    {{ -3.0f, 4.0f,   8.0f}, {-3.0f, 0.0f, -12.0f}},
+    {{-23.0f, 4.0f, -12.0f}, {-3.0f, 0.0f, -12.0f}},
+    {{ -3.0f, 4.0f, -32.0f}, {-3.0f, 0.0f, -12.0f}},
+    {{ 17.0f, 4.0f, -12.0f}, {-3.0f, 0.0f, -12.0f}},
+    {{ -3.0f, 4.0f,   8.0f}, {-3.0f, 0.0f, -12.0f}},
+};
+
+// Walks through the woods, then through the house, so that the triangles cross the near plane
+static const benchmark_key_t benchmark_near_plane_keys[] = {
+    {{  2.0f, 1.5f,   0.0f}, {  2.0f, 1.5f, -10.0f}},
+    {{  2.0f, 1.5f, -28.0f}, {  2.0f, 1.5f, -38.0f}},
+    {{-18.0f, 2.0f,   2.0f}, {-18.0f, 2.0f,  -8.0f}},
+    {{-18.0f, 2.0f, -14.0f}, {-18.0f, 2.0f, -24.0f}},
+};
+
+// Looks along the rows of trees, sheep and buildings from low down, where the most surfaces overlap
+static const benchmark_key_t benchmark_overdraw_keys[] = {
+    {{ 26.0f, 1.0f, -18.0f}, {-18.0f, 1.0f, -12.0f}},
+    {{ 26.0f, 1.0f, -12.0f}, {-18.0f, 1.0f,  -6.0f}},
+    {{ 12.0f, 1.0f,   6.0f}, {  6.0f, 1.0f, -30.0f}},
+};
+
+// Looks away from the farm, so that only the fixed cost of a frame remains
+static const benchmark_key_t benchmark_empty_keys[] = {
+    {{0.0f, 2.0f, 8.0f}, {  0.0f, 2.0f, 20.0f}},
+    {{0.0f, 2.0f, 8.0f}, { 10.0f, 8.0f, 16.0f}},
+};
+
+static const benchmark_path_t benchmark_paths[] = {
+    {"orbit",      benchmark_orbit_keys,      COUNT_OF(benchmark_orbit_keys)},
+    {"near_plane", benchmark_near_plane_keys, COUNT_OF(benchmark_near_plane_keys)},
+    {"overdraw",   benchmark_overdraw_keys,   COUNT_OF(benchmark_overdraw_keys)},
+    {"empty",      benchmark_empty_keys,      COUNT_OF(benchmark_empty_keys)},
+};
+
+typedef struct
+{
+    uint32_t frame_us[BENCHMARK_FRAME_COUNT];
+    uint64_t triangle_count;
+#if defined(PGL_STATS)
+    pgl_stats_t stats; // Summed over the cores and the frames
+#endif
+} benchmark_result_t;
+
+static void benchmark_camera_transform(const benchmark_path_t* path, uint32_t frame, transform_component_t* transform)
+{
+    const float t = (float)frame / (BENCHMARK_FRAME_COUNT - 1) * (path->key_count - 1);
+    const uint32_t key = SMALLER((uint32_t)t, path->key_count - 2);
+    const float s = t - key;
+
+    float position[3], target[3];
+    for (uint32_t i = 0; i < 3; ++i)
+    {
+        position[i] = path->keys[key].position[i] + s * (path->keys[key + 1].position[i] - path->keys[key].position[i]);
+        target[i]   = path->keys[key].target[i]   + s * (path->keys[key + 1].target[i]   - path->keys[key].target[i]);
+    }
+    benchmark_look_at(position, target, 0.0f, transform);
+}
+
+// Returns the time of the frame in microseconds, or 0 when no draw image was available
+static uint32_t benchmark_draw_frame(scene_t* scene, uint32_t* triangle_count)
+{
+    // There is no display to consume the images, release the last one right away
+    swapchain_request_display_image();
+    if (!pgl_request_draw_image())
+        return 0;
+
+    const uint64_t start_us = time_us_64();
+    pgl_clear_colours(COLOUR_BLACK);
+    pgl_clear_depths(DEPTH_FURTHEST);
+    *triangle_count = scene_draw(scene);
+    pgl_resolve();
+    const uint32_t frame_us = (uint32_t)(time_us_64() - start_us);
+    swapchain_swap_images();
+
+    return GREATER(frame_us, 1u);
+}
+
+static void benchmark_run_path(const benchmark_path_t* path, benchmark_result_t* result)
+{
+    *result = (benchmark_result_t){0};
+
+    // Every path starts from the same level of detail and with the texture cache warmed up at its first view
+    scene_t scene;
+    farm_scene_build(&scene);
+    uint32_t triangle_count;
+    benchmark_camera_transform(path, 0, &scene.camera.transform);
+    for (uint32_t i = 0; i < BENCHMARK_WARMUP_FRAMES; ++i)
+        benchmark_draw_frame(&scene, &triangle_count);
+
+    for (uint32_t frame = 0; frame < BENCHMARK_FRAME_COUNT; ++frame)
+    {
+        benchmark_camera_transform(path, frame, &scene.camera.transform);
+
+        uint32_t frame_us;
+        while ((frame_us = benchmark_draw_frame(&scene, &triangle_count)) == 0)
+            ;
+
+        result->frame_us[frame] = frame_us;
+        result->triangle_count += triangle_count;
+
+#if defined(PGL_STATS)
+        for (uint core = 0; core < NUM_CORES; ++core)
+        {
+            const pgl_stats_t stats = pgl_stats(core);
+            result->stats.vertices_shaded       += stats.vertices_shaded;
+            result->stats.triangles_in          += stats.triangles_in;
+            result->stats.triangles_rejected    += stats.triangles_rejected;
+            result->stats.triangles_clipped     += stats.triangles_clipped;
+            result->stats.clipped_triangles_out += stats.clipped_triangles_out;
+            result->stats.triangles_culled      += stats.triangles_culled;
+            result->stats.triangles_degenerate  += stats.triangles_degenerate;
+            result->stats.fragments_tested      += stats.fragments_tested;
+            result->stats.fragments_passed      += stats.fragments_passed;
+            result->stats.texels_fetched        += stats.texels_fetched;
+            result->stats.lock_acquisitions     += stats.lock_acquisitions;
+            result->stats.fragments_overflowed  += stats.fragments_overflowed;
+        }
+#endif
+    }
+}
+
+static int benchmark_compare_us(const void* a, const void* b)
+{
+    const uint32_t x = *(const uint32_t*)a;
+    const uint32_t y = *(const uint32_t*)b;
+    return (x > y) - (x < y);
+}
+
+// Prints a "BENCH <json>" line, which tools/bench_compare.py compares against a baseline
+static void benchmark_report(const benchmark_path_t* path, benchmark_result_t* result)
+{
+    uint64_t total_us = 0;
+    for (uint32_t frame = 0; frame < BENCHMARK_FRAME_COUNT; ++frame)
+        total_us += result->frame_us[frame];
+
+    qsort(result->frame_us, BENCHMARK_FRAME_COUNT, sizeof(result->frame_us[0]), benchmark_compare_us);
+    const uint32_t p99_index = (BENCHMARK_FRAME_COUNT * 99 + 99) / 100 - 1;
+
+    printf("BENCH {\"path\": \"%s\", \"frames\": %u, \"min_us\": %lu, \"avg_us\": %lu, \"p99_us\": %lu, \"max_us\": %lu, \"triangles\": %lu",
+        path->name, BENCHMARK_FRAME_COUNT, (unsigned long)result->frame_us[0], (unsigned long)(total_us / BENCHMARK_FRAME_COUNT),
+        (unsigned long)result->frame_us[p99_index], (unsigned long)result->frame_us[BENCHMARK_FRAME_COUNT - 1],
+        (unsigned long)(result->triangle_count / BENCHMARK_FRAME_COUNT));
+
+#if defined(PGL_STATS)
+    // Per frame averages
+    const pgl_stats_t* stats = &result->stats;
+    printf(", \"stats\": {\"vertices_shaded\": %lu, \"triangles_in\": %lu, \"triangles_rejected\": %lu, \"triangles_clipped\": %lu, "
+        "\"clipped_triangles_out\": %lu, \"triangles_culled\": %lu, \"triangles_degenerate\": %lu, \"fragments_tested\": %lu, "
+        "\"fragments_passed\": %lu, \"texels_fetched\": %lu, \"lock_acquisitions\": %lu, \"fragments_overflowed\": %lu}",
+        (unsigned long)(stats->vertices_shaded / BENCHMARK_FRAME_COUNT), (unsigned long)(stats->triangles_in / BENCHMARK_FRAME_COUNT),
+        (unsigned long)(stats->triangles_rejected / BENCHMARK_FRAME_COUNT), (unsigned long)(stats->triangles_clipped / BENCHMARK_FRAME_COUNT),
+        (unsigned long)(stats->clipped_triangles_out / BENCHMARK_FRAME_COUNT), (unsigned long)(stats->triangles_culled / BENCHMARK_FRAME_COUNT),
+        (unsigned long)(stats->triangles_degenerate / BENCHMARK_FRAME_COUNT), (unsigned long)(stats->fragments_tested / BENCHMARK_FRAME_COUNT),
+        (unsigned long)(stats->fragments_passed / BENCHMARK_FRAME_COUNT), (unsigned long)(stats->texels_fetched / BENCHMARK_FRAME_COUNT),
+        (unsigned long)(stats->lock_acquisitions / BENCHMARK_FRAME_COUNT), (unsigned long)(stats->fragments_overflowed / BENCHMARK_FRAME_COUNT));
+#endif
+
+    printf("}\n");
+}
+
+int main()
+{
+    stdio_init_all();
+    pgl_init();
+    pgl_viewport(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT);
+
+    static benchmark_result_t result;
+
+    while (true)
+    {
+        for (uint32_t i = 0; i < COUNT_OF(benchmark_paths); ++i)
+        {
+            benchmark_run_path(&benchmark_paths[i], &result);
+            benchmark_report(&benchmark_paths[i], &result);
+        }
+
+#if PICO_ON_DEVICE
+        // Repeated for the serial monitor to catch a run
+        sleep_ms(BENCHMARK_PERIOD_MS);
+#else
+        break;
+#endif
+    }
+
+    return 0;
+}
@@ -0,0 +1,118 @@
+
+#include <stdio.h>
+#include <math.h>
+#include <pico/stdlib.h>
+
+#if PICO_ON_DEVICE
+    #include <hardware/structs/xip_ctrl.h>
+#endif
+
+#include "benchmark_scene.h"
+#include "models/scene_models.h"
+
+#define BENCHMARK_FRAME_COUNT   90
+#define BENCHMARK_PERIOD_MS     5000
+
+// The camera circles the centre of the scene
+#define BENCHMARK_CENTRE_X      (-3.0f)
+#define BENCHMARK_CENTRE_Z      (-10.0f)
+#define BENCHMARK_RADIUS        14.0f
+
+// The camera rolls up to this angle, so that scanlines cross the textures diagonally
+#define BENCHMARK_MAX_ROLL      0.7853982f
+
+typedef struct
+{
+    uint64_t total_us;
+    uint32_t min_us;
+    uint32_t max_us;
+    uint32_t cache_hits;
+    uint32_t cache_accesses;
+} benchmark_result_t;
+
+// Circles the scene facing its centre while rolling back and forth
+static void benchmark_camera_transform(uint32_t frame, transform_component_t* transform)
+{
+    const float t = (float)frame / BENCHMARK_FRAME_COUNT;
+    const float angle = 2.0f * (float)M_PI * t;
+
+    transform->position = (Q_VEC3){{
+        Q_FROM_FLOAT(BENCHMARK_CENTRE_X + BENCHMARK_RADIUS * sinf(angle)),
+        Q_FROM_INT(2),
+        Q_FROM_FLOAT(BENCHMARK_CENTRE_Z + BENCHMARK_RADIUS * cosf(angle)),
+    }};
+
+    const Q_QUAT yaw  = q_quat_angle_axis(Q_FROM_FLOAT(angle), Q_VEC3_UP);
+    const Q_QUAT roll = q_quat_angle_axis(Q_FROM_FLOAT(BENCHMARK_MAX_ROLL * sinf(4.0f * (float)M_PI * t)), Q_VEC3_FORWARD);
+    transform->rotation = q_quat_mul_quat(yaw, roll);
+}
+
+static benchmark_result_t benchmark_camera_path(scene_t* scene)
+{
+    benchmark_result_t result = {.min_us = UINT32_MAX};
+
+#if PICO_ON_DEVICE
+    // Writing any value clears the counters of the flash cache
+    xip_ctrl_hw->ctr_hit = 0;
+    xip_ctrl_hw->ctr_acc = 0;
+#endif
+
+    for (uint32_t frame = 0; frame < BENCHMARK_FRAME_COUNT; ++frame)
+    {
+        benchmark_camera_transform(frame, &scene->camera.transform);
+
+        // There is no display to consume the images, release the last one right away
+        swapchain_request_display_image();
+        if (!pgl_request_draw_image())
+            continue;
+
+        const uint64_t start_us = time_us_64();
+        pgl_clear_colours(COLOUR_BLACK);
+        pgl_clear_depths(DEPTH_FURTHEST);
+        scene_draw(scene);
+        pgl_resolve();
+        const uint32_t frame_us = (uint32_t)(time_us_64() - start_us);
+        swapchain_swap_images();
+
+        result.total_us += frame_us;
+        result.min_us = SMALLER(result.min_us, frame_us);
+        result.max_us = GREATER(result.max_us, frame_us);
+    }
+
+#if PICO_ON_DEVICE
+    result.cache_hits = xip_ctrl_hw->ctr_hit;
+    result.cache_accesses = xip_ctrl_hw->ctr_acc;
+#endif
+
+    return result;
+}
+
+int main()
+{
+    stdio_init_all();
+    pgl_init();
+    pgl_viewport(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT);
+
+    scene_t scene;
+    farm_scene_build(&scene);
+
+    // Rebuild with and without PGL_MORTON_TEXTURES, which applies tools/swizzle.py to the models, to compare the layouts
+    const char* layout = (scene_model01.texture.layout == PGL_TEXTURE_LAYOUT_MORTON) ? "Morton" : "row-major";
+
+    while (true)
+    {
+        const benchmark_result_t result = benchmark_camera_path(&scene);
+
+        printf("\n---------------- %s textures, %u frames of a rotating camera ----------------\n", layout, BENCHMARK_FRAME_COUNT);
+        printf("frame time: %lu us average, %lu us min, %lu us max\n",
+            (unsigned long)(result.total_us / BENCHMARK_FRAME_COUNT), (unsigned long)result.min_us, (unsigned long)result.max_us);
+#if PICO_ON_DEVICE
+        printf("flash cache: %lu hits of %lu accesses (%.1f%%)\n", (unsigned long)result.cache_hits, (unsigned long)result.cache_accesses,
+            (result.cache_accesses != 0) ? 100.0 * result.cache_hits / result.cache_accesses : 0.0);
+#endif
+
+        sleep_ms(BENCHMARK_PERIOD_MS);
+    }
+
+    return 0;
+}
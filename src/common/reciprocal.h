@@ -0,0 +1,135 @@
+
+#ifndef PICO_ENGINE_COMMON_RECIPROCAL_H
+#define PICO_ENGINE_COMMON_RECIPROCAL_H
+
+#include <stdint.h>
+#include "fixed_point.h"
+#include "macros.h"
+
+// q_reciprocal(x) is a faster q_div(Q_ONE, x) for the hot paths of the renderer.
+// q_div needs a 64-bit division, which is done in software on both RP2040 and RP2350.
+//   Q24_8  -> 2^16 / x, a single 32-bit division (exact)
+//   Q16_16 -> 2^32 / x, a single 32-bit division of 2^32 - 1 and a correction (exact)
+//   Q8_24  -> 2^48 / x, normalisation, a table lookup, two Newton-Raphson steps and a correction (exact)
+// Results that do not fit in Q_TYPE, including the reciprocal of zero, saturate to +/-Q_MAX.
+
+#if PICO_RP2040
+    // The SIO divider of the calling core, without saving its state for interrupts
+    #include <hardware/divider.h>
+    #define RECIPROCAL_UDIV(a, b) hw_divider_u32_quotient_inlined((a), (b))
+#else
+    // A single UDIV instruction on RP2350
+    #define RECIPROCAL_UDIV(a, b) ((a) / (b))
+#endif
+
+#if defined(Q8_24)
+
+// 1 / d in Q1.15 at the middle of [0.5 + i / 512, 0.5 + (i + 1) / 512)
+static const uint16_t reciprocal_table[256] = {
+    0xFF80u, 0xFE82u, 0xFD86u, 0xFC8Cu, 0xFB94u, 0xFA9Eu, 0xF9A9u, 0xF8B7u,
+    0xF7C6u, 0xF6D7u, 0xF5EAu, 0xF4FFu, 0xF415u, 0xF32Du, 0xF247u, 0xF163u,
+    0xF080u, 0xEF9Fu, 0xEEBFu, 0xEDE1u, 0xED05u, 0xEC2Au, 0xEB51u, 0xEA7Au,
+    0xE9A4u, 0xE8CFu, 0xE7FCu, 0xE72Bu, 0xE65Bu, 0xE58Cu, 0xE4BFu, 0xE3F4u,
+    0xE329u, 0xE260u, 0xE199u, 0xE0D3u, 0xE00Eu, 0xDF4Bu, 0xDE88u, 0xDDC8u,
+    0xDD08u, 0xDC4Au, 0xDB8Du, 0xDAD1u, 0xDA17u, 0xD95Eu, 0xD8A6u, 0xD7EFu,
+    0xD73Au, 0xD685u, 0xD5D2u, 0xD520u, 0xD46Fu, 0xD3BFu, 0xD311u, 0xD263u,
+    0xD1B7u, 0xD10Cu, 0xD062u, 0xCFB9u, 0xCF11u, 0xCE6Au, 0xCDC4u, 0xCD1Fu,
+    0xCC7Bu, 0xCBD8u, 0xCB36u, 0xCA96u, 0xC9F6u, 0xC957u, 0xC8B9u, 0xC81Cu,
+    0xC780u, 0xC6E5u, 0xC64Bu, 0xC5B2u, 0xC51Au, 0xC482u, 0xC3ECu, 0xC357u,
+    0xC2C2u, 0xC22Eu, 0xC19Bu, 0xC109u, 0xC078u, 0xBFE8u, 0xBF59u, 0xBECAu,
+    0xBE3Cu, 0xBDAFu, 0xBD23u, 0xBC98u, 0xBC0Du, 0xBB83u, 0xBAFBu, 0xBA72u,
+    0xB9EBu, 0xB964u, 0xB8DEu, 0xB859u, 0xB7D5u, 0xB751u, 0xB6CEu, 0xB64Cu,
+    0xB5CBu, 0xB54Au, 0xB4CAu, 0xB44Bu, 0xB3CCu, 0xB34Eu, 0xB2D1u, 0xB254u,
+    0xB1D8u, 0xB15Du, 0xB0E3u, 0xB069u, 0xAFF0u, 0xAF77u, 0xAEFFu, 0xAE88u,
+    0xAE11u, 0xAD9Bu, 0xAD26u, 0xACB1u, 0xAC3Du, 0xABC9u, 0xAB56u, 0xAAE4u,
+    0xAA72u, 0xAA01u, 0xA990u, 0xA920u, 0xA8B1u, 0xA842u, 0xA7D3u, 0xA766u,
+    0xA6F8u, 0xA68Cu, 0xA620u, 0xA5B4u, 0xA549u, 0xA4DFu, 0xA475u, 0xA40Cu,
+    0xA3A3u, 0xA33Au, 0xA2D3u, 0xA26Bu, 0xA204u, 0xA19Eu, 0xA138u, 0xA0D3u,
+    0xA06Eu, 0xA00Au, 0x9FA6u, 0x9F43u, 0x9EE0u, 0x9E7Eu, 0x9E1Cu, 0x9DBAu,
+    0x9D59u, 0x9CF9u, 0x9C99u, 0x9C39u, 0x9BDAu, 0x9B7Cu, 0x9B1Du, 0x9AC0u,
+    0x9A62u, 0x9A05u, 0x99A9u, 0x994Du, 0x98F1u, 0x9896u, 0x983Bu, 0x97E1u,
+    0x9787u, 0x972Eu, 0x96D5u, 0x967Cu, 0x9624u, 0x95CCu, 0x9574u, 0x951Du,
+    0x94C7u, 0x9470u, 0x941Bu, 0x93C5u, 0x9370u, 0x931Bu, 0x92C7u, 0x9273u,
+    0x921Fu, 0x91CCu, 0x9179u, 0x9127u, 0x90D5u, 0x9083u, 0x9032u, 0x8FE1u,
+    0x8F90u, 0x8F40u, 0x8EF0u, 0x8EA0u, 0x8E51u, 0x8E02u, 0x8DB3u, 0x8D65u,
+    0x8D17u, 0x8CC9u, 0x8C7Cu, 0x8C2Fu, 0x8BE2u, 0x8B96u, 0x8B4Au, 0x8AFFu,
+    0x8AB3u, 0x8A68u, 0x8A1Eu, 0x89D3u, 0x8989u, 0x8940u, 0x88F6u, 0x88ADu,
+    0x8864u, 0x881Cu, 0x87D3u, 0x878Cu, 0x8744u, 0x86FDu, 0x86B6u, 0x866Fu,
+    0x8628u, 0x85E2u, 0x859Cu, 0x8557u, 0x8511u, 0x84CCu, 0x8488u, 0x8443u,
+    0x83FFu, 0x83BBu, 0x8377u, 0x8334u, 0x82F1u, 0x82AEu, 0x826Bu, 0x8229u,
+    0x81E7u, 0x81A5u, 0x8164u, 0x8123u, 0x80E2u, 0x80A1u, 0x8060u, 0x8020u,
+};
+
+static inline uint32_t reciprocal_magnitude(uint32_t m)
+{
+    if (m == 0)
+        return (uint32_t)Q_MAX;
+
+    // m = d * 2^(32 - n), where d is in [0.5, 1) and stored in Q0.32
+    const uint32_t n = __builtin_clz(m);
+    const uint32_t d = m << n;
+
+    // y ~ 1 / d in Q1.31, refined by y = y * (2 - d * y)
+    uint32_t y = (uint32_t)reciprocal_table[(d >> 23) & 0xFFu] << 16;
+
+    #pragma GCC unroll 2
+    for (uint32_t i = 0; i < 2; ++i)
+    {
+        const uint32_t dy = (uint32_t)(((uint64_t)d * y) >> 32);
+        y = (uint32_t)(((uint64_t)y * (0u - dy)) >> 31);
+    }
+
+    // 1 / x = y * 2^(n + 2 * Q_FRAC_BITS - 63)
+    const int32_t shift = (int32_t)n + 2 * Q_FRAC_BITS - 63;
+    if (shift >= 0)
+        return (uint32_t)Q_MAX;
+
+    // The steps land within an ulp of 2^48 / m on either side, an ulp short on exact powers of two,
+    // which the product with m corrects like the remainder does for Q16_16
+    uint64_t quotient = y >> -shift;
+    const uint64_t product = quotient * m;
+    if (product > (1ull << (2 * Q_FRAC_BITS)))
+        --quotient;
+    else if (product + m <= (1ull << (2 * Q_FRAC_BITS)))
+        ++quotient;
+
+    return (uint32_t)SMALLER(quotient, (uint64_t)Q_MAX);
+}
+
+#elif defined(Q16_16)
+
+static inline uint32_t reciprocal_magnitude(uint32_t m)
+{
+    if (m <= 2)
+        return (uint32_t)Q_MAX;
+
+    // floor(2^32 / m) is one more than floor((2^32 - 1) / m) only if m divides 2^32
+    uint32_t quotient = RECIPROCAL_UDIV(UINT32_MAX, m);
+    if (UINT32_MAX - quotient * m == m - 1)
+        ++quotient;
+
+    return quotient;
+}
+
+#elif defined(Q24_8)
+
+static inline uint32_t reciprocal_magnitude(uint32_t m)
+{
+    if (m == 0)
+        return (uint32_t)Q_MAX;
+
+    return RECIPROCAL_UDIV(1u << 16, m);
+}
+
+#endif
+
+static inline Q_TYPE q_reciprocal(Q_TYPE x)
+{
+    const uint32_t magnitude = (x < Q_ZERO) ? (0u - (uint32_t)x) : (uint32_t)x;
+    const Q_TYPE reciprocal = (Q_TYPE)reciprocal_magnitude(magnitude);
+    return (x < Q_ZERO) ? -reciprocal : reciprocal;
+}
+
+#undef RECIPROCAL_UDIV
+
+#endif // PICO_ENGINE_COMMON_RECIPROCAL_H
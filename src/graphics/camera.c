@@ -1,6 +1,14 @@
 
+#include <math.h>
 #include "camera.h"
 
+#define CAMERA_OFFSET_LIMIT Q_FROM_INT(4) // Three squares of it still fit in Q8_24
+
+void camera_init(camera_t* camera)
+{
+    camera->half_width_scale = Q_FROM_FLOAT(tanf(Q_TO_FLOAT(camera->camera.fovw) * 0.5f));
+}
+
 void camera_set_view_proj(const camera_t* camera)
 {
     const Q_VEC3 backward = q_quat_rotate_vec3(camera->transform.rotation, Q_VEC3_BACKWARD);
@@ -9,3 +17,19 @@ void camera_set_view_proj(const camera_t* camera)
     pgl_projection(camera->camera.fovw, camera->camera.near, camera->camera.far);
 }
 
+Q_TYPE camera_screen_size(const camera_t* camera, Q_VEC3 centre, Q_TYPE radius)
+{
+    // The offset is halved until its squares fit, and the ratio to the radius is halved as many times
+    Q_VEC3 offset = q_vec3_sub(centre, camera->transform.position);
+    uint32_t shift = 0;
+    for (Q_TYPE largest = GREATER(GREATER(ABS(offset.x), ABS(offset.y)), ABS(offset.z)); largest > CAMERA_OFFSET_LIMIT; largest >>= 1)
+        ++shift;
+    offset = (Q_VEC3){{offset.x >> shift, offset.y >> shift, offset.z >> shift}};
+
+    const Q_TYPE half_width = q_mul(q_vec3_length(offset), camera->half_width_scale);
+    if (q_le(half_width, radius >> shift))
+        return Q_ONE;
+
+    return q_div(radius, half_width) >> shift;
+}
+
@@ -9,8 +9,15 @@ typedef struct camera
 {
     transform_component_t transform;
     camera_component_t camera;
+    Q_TYPE half_width_scale; // tan(fovw / 2), the half width of the view over the distance, set by camera_init
 } camera_t;
 
+// Precomputes what camera_screen_size needs from the field of view, call it again after changing the field of view
+void camera_init(camera_t* camera);
 void camera_set_view_proj(const camera_t* camera);
 
+// Returns the diameter of the sphere projected on the screen over the width of the viewport, Q_ONE when the camera is inside it.
+// It depends on the distance alone, so turning the camera does not change the levels of detail.
+Q_TYPE camera_screen_size(const camera_t* camera, Q_VEC3 centre, Q_TYPE radius);
+
 #endif // PICO_ENGINE_GRAPHICS_CAMERA_H
@@ -7,10 +7,28 @@
 typedef struct
 {
     const pgl_vertex_t* vertices;
+    const pgl_packed_vertex_t* packed_vertices; // Replaces vertices when they are packed by tools/pack_vertices.py
     const uint16_t* indices;
+    const pgl_meshlet_t* meshlets;    // Replace indices when the mesh is split by tools/meshlets.py
+    const uint8_t* meshlet_indices;
     uint16_t vertex_count;
     uint16_t index_count;
+    uint16_t meshlet_count;
+    Q_VEC3 origin; // The packed positions are in [-1, 1], scaled by extent around origin
+    Q_VEC3 extent;
 } mesh_t;
 
+// Triangles submitted by drawing the mesh, before any culling
+static inline uint32_t mesh_triangle_count(const mesh_t* mesh)
+{
+    if (mesh->meshlets == NULL)
+        return mesh->index_count / 3;
+
+    uint32_t triangle_count = 0;
+    for (uint16_t i = 0; i < mesh->meshlet_count; ++i)
+        triangle_count += mesh->meshlets[i].triangle_count;
+    return triangle_count;
+}
+
 #endif // PICO_ENGINE_MESH_MESH_H
 
@@ -1,9 +1,63 @@
 
 #include "model.h"
 
-void model_draw(const model_t* model, const transform_component_t* transform)
+static void model_draw_unpacked(const mesh_t* mesh)
 {
-    pgl_model(transform->position, transform->rotation, transform->scale);
-    pgl_bind_texture(model->texture.texels, model->texture.width_bits, model->texture.height_bits);
-    pgl_draw(model->mesh.vertices, model->mesh.indices, model->mesh.index_count);
+    if (mesh->meshlets == NULL)
+        pgl_draw(mesh->vertices, mesh->indices, mesh->index_count);
+    else
+        pgl_draw_meshlets(mesh->vertices, mesh->meshlets, mesh->meshlet_count, mesh->meshlet_indices);
+}
+
+static void model_draw_packed(const mesh_t* mesh)
+{
+    if (mesh->meshlets == NULL)
+        pgl_draw_packed(mesh->packed_vertices, mesh->indices, mesh->index_count);
+    else
+        pgl_draw_packed_meshlets(mesh->packed_vertices, mesh->meshlets, mesh->meshlet_count, mesh->meshlet_indices);
+}
+
+uint32_t model_select_lod(const model_t* model, Q_TYPE screen_size, uint32_t current_lod)
+{
+    uint32_t lod = SMALLER(current_lod, model->lod_count);
+
+    // Coarser while the model is clearly smaller than the threshold of the next level
+    while (lod < model->lod_count && q_lt(screen_size, q_mul(model->lods[lod].max_screen_size, Q_ONE - MODEL_LOD_HYSTERESIS)))
+        ++lod;
+
+    // Finer while it is clearly larger than the threshold of the current one
+    while (lod > 0 && q_gt(screen_size, q_mul(model->lods[lod - 1].max_screen_size, Q_ONE + MODEL_LOD_HYSTERESIS)))
+        --lod;
+
+    return lod;
+}
+
+uint32_t model_draw(const model_t* model, const transform_component_t* transform, uint32_t lod)
+{
+    const mesh_t* mesh = (lod == 0) ? &model->mesh : &model->lods[lod - 1].mesh;
+    pgl_bind_texture(&model->texture);
+
+    if (mesh->packed_vertices == NULL)
+    {
+        pgl_model(transform->position, transform->rotation, transform->scale);
+        model_draw_unpacked(mesh);
+        return mesh_triangle_count(mesh);
+    }
+
+    // Folds the bounds of the packed positions into the model matrix, so unpacking a vertex costs only shifts
+    // T * R * S * T(origin) * S(extent) = T(position + R * S * origin) * R * S(scale * extent)
+    const Q_VEC3 scaled_origin = {{
+        q_mul(transform->scale.x, mesh->origin.x),
+        q_mul(transform->scale.y, mesh->origin.y),
+        q_mul(transform->scale.z, mesh->origin.z),
+    }};
+    const Q_VEC3 scaled_extent = {{
+        q_mul(transform->scale.x, mesh->extent.x),
+        q_mul(transform->scale.y, mesh->extent.y),
+        q_mul(transform->scale.z, mesh->extent.z),
+    }};
+
+    pgl_model(q_vec3_add(transform->position, q_quat_rotate_vec3(transform->rotation, scaled_origin)), transform->rotation, scaled_extent);
+    model_draw_packed(mesh);
+    return mesh_triangle_count(mesh);
 }
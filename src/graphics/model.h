@@ -6,12 +6,29 @@
 #include "texture.h"
 #include "common/components.h"
 
+// A level changes only once the screen size is this fraction past its threshold, so objects at a threshold do not pop
+#define MODEL_LOD_HYSTERESIS Q_FROM_FLOAT(0.1f)
+
+// A simplified mesh of the model, generated by tools/lod.py
+typedef struct
+{
+    mesh_t mesh;
+    Q_TYPE max_screen_size; // Used while the model covers less than this fraction of the width of the viewport
+} model_lod_t;
+
 typedef struct model
 {
     mesh_t mesh;
     texture_t texture;
+    const model_lod_t* lods; // From the most to the least detailed, or NULL
+    uint16_t lod_count;
+    Q_TYPE radius;           // Bounding sphere around the origin of the mesh, for the level selection
 } model_t;
 
-void model_draw(const model_t* model, const transform_component_t* transform);
+// Returns the level of detail for the screen size, 0 for the mesh of the model and i for lods[i - 1]
+uint32_t model_select_lod(const model_t* model, Q_TYPE screen_size, uint32_t current_lod);
+
+// Returns the number of triangles submitted
+uint32_t model_draw(const model_t* model, const transform_component_t* transform, uint32_t lod);
 
 #endif // PICO_ENGINE_GRAPHICS_MODEL_H
@@ -1,22 +1,41 @@
 
 #include "scene.h"
+#include "trace/trace.h"
 
 void scene_init(scene_t* scene, camera_t camera)
 {
     scene->object_count = 0;
     scene->camera = camera;
+    camera_init(&scene->camera);
 }
 
 void scene_add_object(scene_t* scene, object_t object)
 {
     if (scene->object_count == SCENE_MAX_OBJECT_COUNT) return;
+    scene->object_lods[scene->object_count] = 0;
     scene->objects[scene->object_count++] = object;
 }
 
-void scene_draw(const scene_t* scene)
+uint32_t scene_draw(scene_t* scene)
 {
+    TRACE_BEGIN(TRACE_ZONE_SCENE);
     camera_set_view_proj(&scene->camera);
+
+    uint32_t triangle_count = 0;
     for (uint32_t i = 0; i < scene->object_count; ++i)
-        model_draw(&scene->objects[i].model, &scene->objects[i].transform);
+    {
+        const object_t* object = &scene->objects[i];
+        uint32_t* lod = &scene->object_lods[i];
+        if (object->model.lod_count > 0)
+        {
+            const Q_VEC3 scale = object->transform.scale;
+            const Q_TYPE radius = q_mul(object->model.radius, GREATER(GREATER(ABS(scale.x), ABS(scale.y)), ABS(scale.z)));
+            const Q_TYPE screen_size = camera_screen_size(&scene->camera, object->transform.position, radius);
+            *lod = model_select_lod(&object->model, screen_size, *lod);
+        }
+        triangle_count += model_draw(&object->model, &object->transform, *lod);
+    }
+    TRACE_END(TRACE_ZONE_SCENE);
+    return triangle_count;
 }
 
@@ -10,12 +10,14 @@
 typedef struct scene
 {
     object_t objects[SCENE_MAX_OBJECT_COUNT];
+    uint32_t object_lods[SCENE_MAX_OBJECT_COUNT]; // Levels of detail of the last frame
     camera_t camera;
     uint32_t object_count;
 } scene_t;
 
 void scene_init(scene_t* scene, camera_t camera);
 void scene_add_object(scene_t* scene, object_t object);
-void scene_draw(const scene_t* scene);
+// Selects the level of detail of every object and returns the number of triangles submitted
+uint32_t scene_draw(scene_t* scene);
 
 #endif // PICO_ENGINE_GRAPHICS_SCENE_H
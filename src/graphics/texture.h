@@ -2,13 +2,27 @@
 #ifndef PICO_ENGINE_GRAPHICS_TEXTURE_H
 #define PICO_ENGINE_GRAPHICS_TEXTURE_H
 
-#include "colour/colour.h"
+#include "pgl/pgl.h"
 
+// Mip chains are generated by tools/mipmap.py, indexed formats by tools/quantise.py and atlases by tools/atlas.py
+typedef pgl_texture_t texture_t;
+
+// Texels of an atlas holding one of the packed textures
 typedef struct
 {
-    const colour_t* texels;
+    uint16_t x;
+    uint16_t y;
     uint16_t width_bits;
     uint16_t height_bits;
-} texture_t;
+} texture_region_t;
+
+// Maps the texture coordinates of a packed texture into the atlas, the offline tool already did it for the meshes
+static inline Q_VEC2 texture_region_map(const texture_t* atlas, const texture_region_t* region, Q_VEC2 tex_coord)
+{
+    return (Q_VEC2){{
+        (Q_TYPE)((((int64_t)region->x << Q_FRAC_BITS) + ((int64_t)tex_coord.u << region->width_bits)) >> atlas->width_bits),
+        (Q_TYPE)((((int64_t)region->y << Q_FRAC_BITS) + ((int64_t)tex_coord.v << region->height_bits)) >> atlas->height_bits),
+    }};
+}
 
 #endif // PICO_ENGINE_GRAPHICS_TEXTURE_H
@@ -0,0 +1,149 @@
+#include "interp.h"
+
+typedef struct
+{
+    uint32_t shift_mask[2];
+    uint32_t lane[2];
+    uintptr_t full;
+} interp_results_t;
+
+_Thread_local interp_hw_t host_interp_hw[NUM_INTERPOLATORS];
+
+static inline uint32_t interp_mask(uint32_t ctrl)
+{
+    const uint32_t lsb = (ctrl & SIO_INTERP0_CTRL_LANE0_MASK_LSB_BITS) >> SIO_INTERP0_CTRL_LANE0_MASK_LSB_LSB;
+    const uint32_t msb = (ctrl & SIO_INTERP0_CTRL_LANE0_MASK_MSB_BITS) >> SIO_INTERP0_CTRL_LANE0_MASK_MSB_LSB;
+    return (UINT32_MAX >> (31u - msb)) & (UINT32_MAX << lsb);
+}
+
+static inline uint32_t interp_sign_extend(uint32_t value, uint32_t ctrl)
+{
+    const uint32_t msb = (ctrl & SIO_INTERP0_CTRL_LANE0_MASK_MSB_BITS) >> SIO_INTERP0_CTRL_LANE0_MASK_MSB_LSB;
+    if ((ctrl & SIO_INTERP0_CTRL_LANE0_SIGNED_BITS) && (value & (1u << msb)))
+        value |= ~(UINT32_MAX >> (31u - msb));
+    return value;
+}
+
+static inline bool interp_is_signed(uint32_t ctrl)
+{
+    return (ctrl & SIO_INTERP0_CTRL_LANE0_SIGNED_BITS) != 0;
+}
+
+static void interp_evaluate(const interp_hw_t* interp, interp_results_t* results)
+{
+    uint32_t raw[2];
+    for (uint lane = 0; lane < 2; ++lane)
+    {
+        const uint32_t ctrl = interp->ctrl[lane];
+        const uint32_t input = (ctrl & SIO_INTERP0_CTRL_LANE0_CROSS_INPUT_BITS) ? interp->accum[1 - lane] : interp->accum[lane];
+        const uint32_t shift = (ctrl & SIO_INTERP0_CTRL_LANE0_SHIFT_BITS) >> SIO_INTERP0_CTRL_LANE0_SHIFT_LSB;
+
+        raw[lane] = input;
+        results->shift_mask[lane] = interp_sign_extend((input >> shift) & interp_mask(ctrl), ctrl);
+    }
+
+    const uint32_t base0 = (uint32_t)interp->base[0];
+    const uint32_t base1 = (uint32_t)interp->base[1];
+
+    for (uint lane = 0; lane < 2; ++lane)
+    {
+        const bool add_raw = (interp->ctrl[lane] & SIO_INTERP0_CTRL_LANE0_ADD_RAW_BITS) != 0;
+        results->lane[lane] = (uint32_t)interp->base[lane] + (add_raw ? raw[lane] : results->shift_mask[lane]);
+    }
+    results->full = interp->base[2] + results->shift_mask[0] + results->shift_mask[1];
+
+    if (interp == interp0 && (interp->ctrl[0] & SIO_INTERP0_CTRL_LANE0_BLEND_BITS))
+    {
+        // Lane 1 interpolates between BASE0 and BASE1 by the 8 LSBs of its shift and mask value
+        const uint32_t alpha = results->shift_mask[1] & 0xFFu;
+        if (interp_is_signed(interp->ctrl[1]))
+        {
+            const int64_t delta = (int64_t)(int32_t)base1 - (int32_t)base0;
+            results->lane[1] = (uint32_t)((int32_t)base0 + (int32_t)((delta * alpha) >> 8));
+        }
+        else
+        {
+            const int64_t delta = (int64_t)base1 - base0;
+            results->lane[1] = base0 + (uint32_t)((delta * alpha) >> 8);
+        }
+        results->lane[0] = alpha;
+        results->full = interp->base[2] + results->shift_mask[0];
+    }
+    else if (interp == interp1 && (interp->ctrl[0] & SIO_INTERP1_CTRL_LANE0_CLAMP_BITS))
+    {
+        // Lane 0 clamps its shift and mask value between BASE0 and BASE1, without adding BASE0
+        const uint32_t value = results->shift_mask[0];
+        if (interp_is_signed(interp->ctrl[0]))
+        {
+            const int32_t clamped = (int32_t)value < (int32_t)base0 ? (int32_t)base0 :
+                                    (int32_t)value > (int32_t)base1 ? (int32_t)base1 : (int32_t)value;
+            results->lane[0] = (uint32_t)clamped;
+        }
+        else
+        {
+            results->lane[0] = value < base0 ? base0 : value > base1 ? base1 : value;
+        }
+    }
+}
+
+static inline uint32_t interp_force_bits(const interp_hw_t* interp, uint lane, uint32_t value)
+{
+    // FORCE_MSB only alters what the processor reads, not what is written back to the accumulators
+    const uint32_t bits = (interp->ctrl[lane] & SIO_INTERP0_CTRL_LANE0_FORCE_MSB_BITS) >> SIO_INTERP0_CTRL_LANE0_FORCE_MSB_LSB;
+    return value | (bits << 28);
+}
+
+static inline void interp_write_back(interp_hw_t* interp, const interp_results_t* results)
+{
+    const bool cross0 = (interp->ctrl[0] & SIO_INTERP0_CTRL_LANE0_CROSS_RESULT_BITS) != 0;
+    const bool cross1 = (interp->ctrl[1] & SIO_INTERP0_CTRL_LANE0_CROSS_RESULT_BITS) != 0;
+    interp->accum[0] = cross0 ? results->lane[1] : results->lane[0];
+    interp->accum[1] = cross1 ? results->lane[0] : results->lane[1];
+}
+
+void interp_set_base_both(interp_hw_t* interp, uint32_t value)
+{
+    const uint32_t halves[2] = {value & 0xFFFFu, value >> 16};
+    for (uint lane = 0; lane < 2; ++lane)
+    {
+        const bool extend = interp_is_signed(interp->ctrl[lane]) && (halves[lane] & 0x8000u);
+        interp->base[lane] = extend ? (halves[lane] | 0xFFFF0000u) : halves[lane];
+    }
+}
+
+uint32_t interp_get_raw(interp_hw_t* interp, uint lane)
+{
+    interp_results_t results;
+    interp_evaluate(interp, &results);
+    return results.shift_mask[lane];
+}
+
+uint32_t interp_peek_lane_result(interp_hw_t* interp, uint lane)
+{
+    interp_results_t results;
+    interp_evaluate(interp, &results);
+    return interp_force_bits(interp, lane, results.lane[lane]);
+}
+
+uint32_t interp_pop_lane_result(interp_hw_t* interp, uint lane)
+{
+    interp_results_t results;
+    interp_evaluate(interp, &results);
+    interp_write_back(interp, &results);
+    return interp_force_bits(interp, lane, results.lane[lane]);
+}
+
+uintptr_t interp_peek_full_result(interp_hw_t* interp)
+{
+    interp_results_t results;
+    interp_evaluate(interp, &results);
+    return results.full;
+}
+
+uintptr_t interp_pop_full_result(interp_hw_t* interp)
+{
+    interp_results_t results;
+    interp_evaluate(interp, &results);
+    interp_write_back(interp, &results);
+    return results.full;
+}
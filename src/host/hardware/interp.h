@@ -0,0 +1,192 @@
+#ifndef PICO_ENGINE_HOST_HARDWARE_INTERP_H
+#define PICO_ENGINE_HOST_HARDWARE_INTERP_H
+
+// Bit-exact emulation of the SIO interpolators with the API of the SDK's hardware/interp.h.
+// Every thread owns its own pair of interpolators, just like every core does on device.
+// BASE2 and the full result are pointer-sized, so that texel addresses survive on 64-bit hosts.
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <pico/stdlib.h>
+
+#define NUM_INTERPOLATORS 2
+
+#define SIO_INTERP0_CTRL_LANE0_SHIFT_LSB         0u
+#define SIO_INTERP0_CTRL_LANE0_SHIFT_BITS        0x0000001Fu
+#define SIO_INTERP0_CTRL_LANE0_MASK_LSB_LSB      5u
+#define SIO_INTERP0_CTRL_LANE0_MASK_LSB_BITS     0x000003E0u
+#define SIO_INTERP0_CTRL_LANE0_MASK_MSB_LSB      10u
+#define SIO_INTERP0_CTRL_LANE0_MASK_MSB_BITS     0x00007C00u
+#define SIO_INTERP0_CTRL_LANE0_SIGNED_BITS       0x00008000u
+#define SIO_INTERP0_CTRL_LANE0_CROSS_INPUT_BITS  0x00010000u
+#define SIO_INTERP0_CTRL_LANE0_CROSS_RESULT_BITS 0x00020000u
+#define SIO_INTERP0_CTRL_LANE0_ADD_RAW_BITS      0x00040000u
+#define SIO_INTERP0_CTRL_LANE0_FORCE_MSB_LSB     19u
+#define SIO_INTERP0_CTRL_LANE0_FORCE_MSB_BITS    0x00180000u
+#define SIO_INTERP0_CTRL_LANE0_BLEND_BITS        0x00200000u
+#define SIO_INTERP1_CTRL_LANE0_CLAMP_BITS        0x00400000u
+
+typedef struct
+{
+    uint32_t accum[2];
+    uintptr_t base[3];
+    uint32_t ctrl[2];
+} interp_hw_t;
+
+typedef struct
+{
+    uint32_t ctrl;
+} interp_config;
+
+typedef struct
+{
+    uint32_t accum[2];
+    uintptr_t base[3];
+    uint32_t ctrl[2];
+} interp_hw_save_t;
+
+extern _Thread_local interp_hw_t host_interp_hw[NUM_INTERPOLATORS];
+
+#define interp0 (&host_interp_hw[0])
+#define interp1 (&host_interp_hw[1])
+
+static inline interp_config interp_default_config()
+{
+    // No shift, full 32-bit mask, everything else disabled
+    const interp_config config = {
+        .ctrl = 31u << SIO_INTERP0_CTRL_LANE0_MASK_MSB_LSB,
+    };
+    return config;
+}
+
+static inline void interp_config_set_field(interp_config* config, uint32_t bits, uint32_t value)
+{
+    config->ctrl = (config->ctrl & ~bits) | (value & bits);
+}
+
+static inline void interp_config_set_shift(interp_config* config, uint shift)
+{
+    interp_config_set_field(config, SIO_INTERP0_CTRL_LANE0_SHIFT_BITS, shift << SIO_INTERP0_CTRL_LANE0_SHIFT_LSB);
+}
+
+static inline void interp_config_set_mask(interp_config* config, uint mask_lsb, uint mask_msb)
+{
+    interp_config_set_field(config, SIO_INTERP0_CTRL_LANE0_MASK_LSB_BITS, mask_lsb << SIO_INTERP0_CTRL_LANE0_MASK_LSB_LSB);
+    interp_config_set_field(config, SIO_INTERP0_CTRL_LANE0_MASK_MSB_BITS, mask_msb << SIO_INTERP0_CTRL_LANE0_MASK_MSB_LSB);
+}
+
+static inline void interp_config_set_cross_input(interp_config* config, bool cross_input)
+{
+    interp_config_set_field(config, SIO_INTERP0_CTRL_LANE0_CROSS_INPUT_BITS, cross_input ? UINT32_MAX : 0u);
+}
+
+static inline void interp_config_set_cross_result(interp_config* config, bool cross_result)
+{
+    interp_config_set_field(config, SIO_INTERP0_CTRL_LANE0_CROSS_RESULT_BITS, cross_result ? UINT32_MAX : 0u);
+}
+
+static inline void interp_config_set_signed(interp_config* config, bool _signed)
+{
+    interp_config_set_field(config, SIO_INTERP0_CTRL_LANE0_SIGNED_BITS, _signed ? UINT32_MAX : 0u);
+}
+
+static inline void interp_config_set_add_raw(interp_config* config, bool add_raw)
+{
+    interp_config_set_field(config, SIO_INTERP0_CTRL_LANE0_ADD_RAW_BITS, add_raw ? UINT32_MAX : 0u);
+}
+
+// Only meaningful for lane 0 of interp0
+static inline void interp_config_set_blend(interp_config* config, bool blend)
+{
+    interp_config_set_field(config, SIO_INTERP0_CTRL_LANE0_BLEND_BITS, blend ? UINT32_MAX : 0u);
+}
+
+// Only meaningful for lane 0 of interp1
+static inline void interp_config_set_clamp(interp_config* config, bool clamp)
+{
+    interp_config_set_field(config, SIO_INTERP1_CTRL_LANE0_CLAMP_BITS, clamp ? UINT32_MAX : 0u);
+}
+
+static inline void interp_config_set_force_bits(interp_config* config, uint bits)
+{
+    interp_config_set_field(config, SIO_INTERP0_CTRL_LANE0_FORCE_MSB_BITS, bits << SIO_INTERP0_CTRL_LANE0_FORCE_MSB_LSB);
+}
+
+static inline void interp_set_config(interp_hw_t* interp, uint lane, interp_config* config)
+{
+    interp->ctrl[lane] = config->ctrl;
+}
+
+static inline interp_config interp_get_config(interp_hw_t* interp, uint lane)
+{
+    const interp_config config = {
+        .ctrl = interp->ctrl[lane],
+    };
+    return config;
+}
+
+static inline void interp_set_force_bits(interp_hw_t* interp, uint lane, uint bits)
+{
+    interp->ctrl[lane] = (interp->ctrl[lane] & ~SIO_INTERP0_CTRL_LANE0_FORCE_MSB_BITS) | 
+        ((bits << SIO_INTERP0_CTRL_LANE0_FORCE_MSB_LSB) & SIO_INTERP0_CTRL_LANE0_FORCE_MSB_BITS);
+}
+
+static inline void interp_save(interp_hw_t* interp, interp_hw_save_t* saver)
+{
+    for (uint i = 0; i < 2; ++i)
+    {
+        saver->accum[i] = interp->accum[i];
+        saver->ctrl[i] = interp->ctrl[i];
+    }
+    for (uint i = 0; i < 3; ++i)
+        saver->base[i] = interp->base[i];
+}
+
+static inline void interp_restore(interp_hw_t* interp, interp_hw_save_t* saver)
+{
+    for (uint i = 0; i < 2; ++i)
+    {
+        interp->accum[i] = saver->accum[i];
+        interp->ctrl[i] = saver->ctrl[i];
+    }
+    for (uint i = 0; i < 3; ++i)
+        interp->base[i] = saver->base[i];
+}
+
+static inline void interp_set_base(interp_hw_t* interp, uint lane, uintptr_t value)
+{
+    interp->base[lane] = (lane == 2) ? value : (uint32_t)value;
+}
+
+static inline uintptr_t interp_get_base(interp_hw_t* interp, uint lane)
+{
+    return interp->base[lane];
+}
+
+void interp_set_base_both(interp_hw_t* interp, uint32_t value);
+
+static inline void interp_set_accumulator(interp_hw_t* interp, uint lane, uint32_t value)
+{
+    interp->accum[lane] = value;
+}
+
+static inline uint32_t interp_get_accumulator(interp_hw_t* interp, uint lane)
+{
+    return interp->accum[lane];
+}
+
+// The SDK spells it this way
+static inline void interp_add_accumulater(interp_hw_t* interp, uint lane, uint32_t value)
+{
+    interp->accum[lane] += value;
+}
+
+uint32_t interp_get_raw(interp_hw_t* interp, uint lane);
+
+uint32_t interp_peek_lane_result(interp_hw_t* interp, uint lane);
+uint32_t interp_pop_lane_result(interp_hw_t* interp, uint lane);
+
+uintptr_t interp_peek_full_result(interp_hw_t* interp);
+uintptr_t interp_pop_full_result(interp_hw_t* interp);
+
+#endif // PICO_ENGINE_HOST_HARDWARE_INTERP_H
@@ -0,0 +1,67 @@
+
+#include "input_camera.h"
+#include "device/input.h"
+#include "common/macros.h"
+
+#define Q_PHYSICS_UPDATE_PERIOD Q_FROM_FLOAT(INPUT_PHYSICS_UPDATE_PERIOD_US / 1000000.0f)
+
+static const uint input_camera_keys[] = {
+    INPUT_KEY_A, INPUT_KEY_B, INPUT_KEY_X, INPUT_KEY_Y, INPUT_KEY_FORWARD, INPUT_KEY_BACKWARD, INPUT_KEY_LEFT, INPUT_KEY_RIGHT, INPUT_KEY_CTRL,
+};
+
+input_state_t input_camera_sample_keys()
+{
+    input_state_t state = 0;
+    for (uint32_t i = 0; i < COUNT_OF(input_camera_keys); ++i)
+        if (input_key_pressed(input_camera_keys[i]))
+            state |= 1u << input_camera_keys[i];
+
+    // Held with CTRL, X and Y record and replay the keys in main.c instead of moving the camera
+    if (input_state_pressed(state, INPUT_KEY_CTRL))
+        state &= ~((1u << INPUT_KEY_X) | (1u << INPUT_KEY_Y));
+    return state;
+}
+
+void input_camera_step(input_state_t state, transform_component_t* transform)
+{
+    const Q_TYPE lin_speed = Q_FROM_INT(12);
+    const Q_TYPE ang_speed = q_mul_int(Q_2_PI, 3);
+
+    const Q_TYPE delta_speed = q_mul(lin_speed, Q_PHYSICS_UPDATE_PERIOD);
+    const Q_TYPE delta_angle = q_mul(ang_speed, Q_PHYSICS_UPDATE_PERIOD);
+
+    Q_VEC3 delta_position = Q_VEC3_ZERO;
+    Q_QUAT delta_rotation = Q_QUAT_IDENTITY;
+
+    if (input_state_pressed(state, INPUT_KEY_FORWARD))
+        delta_position = q_vec3_add(delta_position, Q_VEC3_FORWARD);
+    if (input_state_pressed(state, INPUT_KEY_BACKWARD))
+        delta_position = q_vec3_add(delta_position, Q_VEC3_BACKWARD);
+    if (input_state_pressed(state, INPUT_KEY_X))
+        delta_position = q_vec3_add(delta_position, Q_VEC3_UP);
+    if (input_state_pressed(state, INPUT_KEY_Y))
+        delta_position = q_vec3_add(delta_position, Q_VEC3_DOWN);
+
+    if (input_state_pressed(state, INPUT_KEY_LEFT))
+    {
+        if (input_state_pressed(state, INPUT_KEY_B))
+            delta_rotation = q_quat_mul_quat(delta_rotation, q_quat_angle_axis(delta_angle, Q_VEC3_UP));
+        else
+            delta_position = q_vec3_add(delta_position, Q_VEC3_LEFT);
+    }
+
+    if (input_state_pressed(state, INPUT_KEY_RIGHT))
+    {
+        if (input_state_pressed(state, INPUT_KEY_B))
+            delta_rotation = q_quat_mul_quat(delta_rotation, q_quat_angle_axis(delta_angle, Q_VEC3_DOWN));
+        else
+            delta_position = q_vec3_add(delta_position, Q_VEC3_RIGHT);
+    }
+
+    if (q_ne(delta_position.x, Q_ZERO) || q_ne(delta_position.y, Q_ZERO) || q_ne(delta_position.z, Q_ZERO))
+        delta_position = q_vec3_scale(q_vec3_normalise(delta_position), delta_speed);
+
+    delta_position = q_quat_rotate_vec3(transform->rotation, delta_position);
+    transform->position = q_vec3_add(delta_position, transform->position);
+    transform->rotation = q_quat_mul_quat(delta_rotation, transform->rotation);
+}
@@ -0,0 +1,15 @@
+
+#ifndef PICO_ENGINE_INPUT_INPUT_CAMERA_H
+#define PICO_ENGINE_INPUT_INPUT_CAMERA_H
+
+#include "input_log.h"
+
+#define INPUT_PHYSICS_UPDATE_PERIOD_US 20000
+
+// Returns the keys held now, but X and Y while CTRL is held
+input_state_t input_camera_sample_keys();
+
+// Moves and turns the camera by the keys held during a physics tick of INPUT_PHYSICS_UPDATE_PERIOD_US
+void input_camera_step(input_state_t state, transform_component_t* transform);
+
+#endif // PICO_ENGINE_INPUT_INPUT_CAMERA_H
@@ -0,0 +1,87 @@
+
+#include <stdio.h>
+#include "input_log.h"
+
+void input_log_init(input_log_t* log, input_log_event_t* events, uint32_t capacity)
+{
+    *log = (input_log_t){0};
+    log->events = events;
+    log->capacity = capacity;
+}
+
+void input_log_record(input_log_t* log, const transform_component_t* start)
+{
+    log->event_count = 0;
+    log->tick_count = 0;
+    log->start = *start;
+
+    log->mode = INPUT_LOG_RECORDING;
+    log->tick = 0;
+    log->state = 0;
+}
+
+void input_log_replay(input_log_t* log, transform_component_t* start)
+{
+    *start = log->start;
+
+    log->mode = INPUT_LOG_REPLAYING;
+    log->tick = 0;
+    log->next_event = 0;
+    log->state = 0;
+}
+
+void input_log_stop(input_log_t* log)
+{
+    if (log->mode == INPUT_LOG_RECORDING)
+        log->tick_count = log->tick;
+    log->mode = INPUT_LOG_IDLE;
+}
+
+input_state_t input_log_step(input_log_t* log, input_state_t live_state)
+{
+    switch (log->mode)
+    {
+        case INPUT_LOG_RECORDING:
+        {
+            if (live_state != log->state)
+            {
+                if (log->event_count == log->capacity)
+                {
+                    input_log_stop(log);
+                    return live_state;
+                }
+                log->events[log->event_count++] = (input_log_event_t){log->tick, live_state};
+                log->state = live_state;
+            }
+            ++log->tick;
+            return live_state;
+        }
+        case INPUT_LOG_REPLAYING:
+        {
+            if (log->tick == log->tick_count)
+            {
+                input_log_stop(log);
+                return 0;
+            }
+            while (log->next_event < log->event_count && log->events[log->next_event].tick == log->tick)
+                log->state = log->events[log->next_event++].state;
+            ++log->tick;
+            return log->state;
+        }
+        default:
+            return live_state;
+    }
+}
+
+void input_log_dump(const input_log_t* log)
+{
+    const Q_TYPE* start = (const Q_TYPE*)&log->start;
+    printf("INPUT START");
+    for (uint32_t i = 0; i < sizeof(log->start) / sizeof(Q_TYPE); ++i)
+        printf(" %08lx", (unsigned long)(uint32_t)start[i]);
+    printf("\n");
+
+    for (uint32_t i = 0; i < log->event_count; ++i)
+        printf("INPUT KEYS %lx %lx\n", (unsigned long)log->events[i].tick, (unsigned long)log->events[i].state);
+    printf("INPUT END %lx\n", (unsigned long)log->tick_count);
+}
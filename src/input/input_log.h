@@ -0,0 +1,65 @@
+
+#ifndef PICO_ENGINE_INPUT_INPUT_LOG_H
+#define PICO_ENGINE_INPUT_INPUT_LOG_H
+
+#include <pico/stdlib.h>
+#include "common/components.h"
+
+// The keys held during a physics tick, a bit per GPIO of the INPUT_KEY_* of device/input.h
+typedef uint32_t input_state_t;
+
+static inline bool input_state_pressed(input_state_t state, uint key)
+{
+    return (state >> key) & 1u;
+}
+
+// The keys changed to the state at the tick
+typedef struct
+{
+    uint32_t tick;
+    input_state_t state;
+} input_log_event_t;
+
+typedef enum
+{
+    INPUT_LOG_IDLE,
+    INPUT_LOG_RECORDING,
+    INPUT_LOG_REPLAYING,
+} input_log_mode_t;
+
+// Records the key states of the physics ticks into an event buffer, an event per change, and replays them.
+// With the camera transform at the start of the recording, a replay drives the physics through the same states.
+typedef struct
+{
+    input_log_event_t* events;
+    uint32_t capacity;
+    uint32_t event_count;
+    uint32_t tick_count; // Ticks of the recording
+    transform_component_t start;
+
+    input_log_mode_t mode;
+    uint32_t tick;       // Ticks recorded or replayed so far
+    uint32_t next_event; // The next event to replay
+    input_state_t state;
+} input_log_t;
+
+void input_log_init(input_log_t* log, input_log_event_t* events, uint32_t capacity);
+
+// Starts a recording from the camera transform, dropping the previous one
+void input_log_record(input_log_t* log, const transform_component_t* start);
+
+// Starts replaying the recording from its first tick and returns the camera transform to start from
+void input_log_replay(input_log_t* log, transform_component_t* start);
+
+// Ends a recording or a replay
+void input_log_stop(input_log_t* log);
+
+// Called once per physics tick with the keys held. Records them, or returns the recorded ones while replaying.
+// A recording ends when the buffer is full and a replay after its last tick, where the log returns to idle.
+input_state_t input_log_step(input_log_t* log, input_state_t live_state);
+
+// Prints the recording as "INPUT START <Q values of the camera transform in memory order>", "INPUT KEYS <tick> <state>"
+// lines of its events and "INPUT END <tick count>", all hexadecimal. The pico-engine-input-replay target replays it.
+void input_log_dump(const input_log_t* log);
+
+#endif // PICO_ENGINE_INPUT_INPUT_LOG_H
@@ -6,8 +6,57 @@
 
 #include "device/lcd.h"
 #include "device/input.h"
+#include "input/input_camera.h"
 #include "graphics/scene.h"
-#include "models/scene_models.h"
+#include "models/farm_scene.h"
+#include "trace/trace.h"
+#include "trace/log.h"
+#include "trace/histogram.h"
+
+#define REPORT_PERIOD_US 1000000
+
+// The most entries a frame writes into the log: the report, with the counters of each core, and an INPUT FRAME line
+#define FRAME_LOG_ENTRY_COUNT (3 + 3 * NUM_CORES + 1)
+#if LOG_ENTRY_COUNT < FRAME_LOG_ENTRY_COUNT
+    #error "LOG_ENTRY_COUNT must hold the log entries of a frame!"
+#endif
+
+#if defined(PGL_CAPTURE)
+#include "pgl/capture.h"
+
+#define CAPTURE_FRAME_COUNT 4
+#endif
+
+#if defined(INPUT_LOG_EVENT_COUNT)
+static input_log_event_t input_log_events[INPUT_LOG_EVENT_COUNT];
+#endif
+
+static histogram_t frame_histogram;
+
+// Writes the frame rate and the frame times since start into the log, with the counters of the last frame
+static void report_frames(uint32_t frame_count, uint32_t period_us, uint32_t triangle_count)
+{
+    LOG("FPS: %lu - Triangles: %lu", (uint32_t)((uint64_t)frame_count * 1000000 / period_us), triangle_count);
+    LOG("Frame Time: %lu frames - avg %lu us - p50 %lu us - p90 %lu us - p99 %lu us - max %lu us",
+        frame_histogram.count, histogram_average(&frame_histogram), histogram_percentile(&frame_histogram, 50),
+        histogram_percentile(&frame_histogram, 90), histogram_percentile(&frame_histogram, 99), frame_histogram.max_us);
+#if defined(PGL_TEXTURE_CACHE_BYTES)
+    const pgl_texture_cache_stats_t cache_stats = pgl_texture_cache_stats();
+    LOG("Texture Cache: %lu/%lu hits - %lu copies - %lu evictions - %lu bytes resident",
+        cache_stats.hits, cache_stats.requests, cache_stats.copies, cache_stats.evictions, cache_stats.resident_bytes);
+#endif
+#if defined(PGL_STATS)
+    for (uint core = 0; core < NUM_CORES; ++core)
+    {
+        const pgl_stats_t stats = pgl_stats(core);
+        LOG("Core %lu: %lu vertices - %lu triangles, %lu rejected, %lu clipped into %lu",
+            core, stats.vertices_shaded, stats.triangles_in, stats.triangles_rejected, stats.triangles_clipped, stats.clipped_triangles_out);
+        LOG("Core %lu: %lu culled, %lu degenerate - %lu/%lu fragments passed - %lu texels",
+            core, stats.triangles_culled, stats.triangles_degenerate, stats.fragments_passed, stats.fragments_tested, stats.texels_fetched);
+        LOG("Core %lu: %lu locks - %lu fragments overflowed", core, stats.lock_acquisitions, stats.fragments_overflowed);
+    }
+#endif
+}
 
 static void configure_clock() 
 {
@@ -29,49 +78,6 @@ static void configure_clock()
 #endif
 }
 
-#define PHYSICS_UPDATE_PERIOD_US 20000
-#define Q_PHYSICS_UPDATE_PERIOD  Q_FROM_FLOAT(PHYSICS_UPDATE_PERIOD_US / 1000000.0f)
-
-static void process_input(Q_VEC3* delta_position, Q_QUAT* delta_rotation)
-{
-    const Q_TYPE lin_speed = Q_FROM_INT(12);
-    const Q_TYPE ang_speed = q_mul_int(Q_2_PI, 3);
-
-    const Q_TYPE delta_speed = q_mul(lin_speed, Q_PHYSICS_UPDATE_PERIOD);
-    const Q_TYPE delta_angle = q_mul(ang_speed, Q_PHYSICS_UPDATE_PERIOD);
-
-    *delta_position = Q_VEC3_ZERO;
-    *delta_rotation = Q_QUAT_IDENTITY;
-
-    if (input_key_pressed(INPUT_KEY_FORWARD))
-        *delta_position = q_vec3_add(*delta_position, Q_VEC3_FORWARD);
-    if (input_key_pressed(INPUT_KEY_BACKWARD))
-        *delta_position = q_vec3_add(*delta_position, Q_VEC3_BACKWARD);
-    if (input_key_pressed(INPUT_KEY_X))
-        *delta_position = q_vec3_add(*delta_position, Q_VEC3_UP);
-    if (input_key_pressed(INPUT_KEY_Y))
-        *delta_position = q_vec3_add(*delta_position, Q_VEC3_DOWN);
-
-    if (input_key_pressed(INPUT_KEY_LEFT))
-    {
-        if (input_key_pressed(INPUT_KEY_B))
-            *delta_rotation = q_quat_mul_quat(*delta_rotation, q_quat_angle_axis(delta_angle, Q_VEC3_UP));
-        else
-            *delta_position = q_vec3_add(*delta_position, Q_VEC3_LEFT);
-    }
-
-    if (input_key_pressed(INPUT_KEY_RIGHT))
-    {
-        if (input_key_pressed(INPUT_KEY_B))
-            *delta_rotation = q_quat_mul_quat(*delta_rotation, q_quat_angle_axis(delta_angle, Q_VEC3_DOWN));
-        else
-            *delta_position = q_vec3_add(*delta_position, Q_VEC3_RIGHT);
-    }
-
-    if (q_ne(delta_position->x, Q_ZERO) || q_ne(delta_position->y, Q_ZERO) || q_ne(delta_position->z, Q_ZERO))
-        *delta_position = q_vec3_scale(q_vec3_normalise(*delta_position), delta_speed);
-}
-
 int main()
 {
     stdio_init_all();
@@ -83,36 +89,33 @@ int main()
     pgl_viewport(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT);
 
     scene_t scene;
-    scene_init(&scene, (camera_t){
-        .transform = {{{Q_ZERO, Q_ZERO, Q_ZERO}}, Q_QUAT_IDENTITY, Q_VEC3_ONE},
-        .camera = {Q_QUARTERPI, Q_FROM_FLOAT(0.1f), Q_FROM_FLOAT(100.0f)},
-    });
-
-    scene_add_object(&scene, (object_t){{{{Q_FROM_INT( 0), Q_FROM_INT(0), Q_FROM_INT(-12)}}, Q_QUAT_IDENTITY, q_vec3_upscale_int(Q_VEC3_ONE, 8)}, scene_model01}); // Woods
-    scene_add_object(&scene, (object_t){{{{Q_FROM_INT( 0), Q_FROM_INT(0), Q_FROM_INT(-24)}}, Q_QUAT_IDENTITY, q_vec3_upscale_int(Q_VEC3_ONE, 8)}, scene_model01}); // Woods
-    scene_add_object(&scene, (object_t){{{{Q_FROM_INT(12), Q_FROM_INT(0), Q_FROM_INT(-24)}}, Q_QUAT_IDENTITY, q_vec3_upscale_int(Q_VEC3_ONE, 8)}, scene_model01}); // Woods
-    scene_add_object(&scene, (object_t){{{{Q_FROM_INT(12), Q_FROM_INT(0), Q_FROM_INT(-12)}}, Q_QUAT_IDENTITY, q_vec3_upscale_int(Q_VEC3_ONE, 8)}, scene_model01}); // Woods
-
-    scene_add_object(&scene, (object_t){{{{Q_FROM_INT(12), Q_FROM_FLOAT(-1.5f), Q_FROM_INT(-10)}}, Q_QUAT_IDENTITY, q_vec3_upscale_int(Q_VEC3_ONE, 1)}, scene_model02}); // Sheep
-    scene_add_object(&scene, (object_t){{{{Q_FROM_INT(12), Q_FROM_FLOAT(-1.5f), Q_FROM_INT(-12)}}, Q_QUAT_IDENTITY, q_vec3_upscale_int(Q_VEC3_ONE, 1)}, scene_model02}); // Sheep
-    scene_add_object(&scene, (object_t){{{{Q_FROM_INT(10), Q_FROM_FLOAT(-1.5f), Q_FROM_INT(-12)}}, Q_QUAT_IDENTITY, q_vec3_upscale_int(Q_VEC3_ONE, 1)}, scene_model02}); // Sheep
-    scene_add_object(&scene, (object_t){{{{Q_FROM_INT(10), Q_FROM_FLOAT(-1.5f), Q_FROM_INT(-10)}}, Q_QUAT_IDENTITY, q_vec3_upscale_int(Q_VEC3_ONE, 1)}, scene_model02}); // Sheep
-
-    scene_add_object(&scene, (object_t){{{{Q_FROM_INT(6), Q_FROM_FLOAT(-1.5f), Q_FROM_INT(-16)}}, Q_QUAT_IDENTITY, q_vec3_upscale_int(Q_VEC3_ONE, 1)}, scene_model02}); // Sheep
-    scene_add_object(&scene, (object_t){{{{Q_FROM_INT(4), Q_FROM_FLOAT(-1.5f), Q_FROM_INT(-12)}}, Q_QUAT_IDENTITY, q_vec3_upscale_int(Q_VEC3_ONE, 1)}, scene_model02}); // Sheep
-    scene_add_object(&scene, (object_t){{{{Q_FROM_INT(8), Q_FROM_FLOAT(-1.5f), Q_FROM_INT(-18)}}, Q_QUAT_IDENTITY, q_vec3_upscale_int(Q_VEC3_ONE, 1)}, scene_model02}); // Sheep
-    scene_add_object(&scene, (object_t){{{{Q_FROM_INT(2), Q_FROM_FLOAT(-1.5f), Q_FROM_INT(-14)}}, Q_QUAT_IDENTITY, q_vec3_upscale_int(Q_VEC3_ONE, 1)}, scene_model02}); // Sheep
-    
-    scene_add_object(&scene, (object_t){{{{Q_FROM_INT(-10), Q_FROM_INT(2), Q_FROM_INT(-7)}}, Q_QUAT_IDENTITY, q_vec3_upscale_int(Q_VEC3_ONE, 4)}, scene_model03}); // Windmill
-
-    scene_add_object(&scene, (object_t){{{{Q_FROM_INT(-10), Q_FROM_INT(-2), Q_FROM_INT(-3)}}, Q_QUAT_IDENTITY, q_vec3_upscale_int(Q_VEC3_ONE, 2)}, scene_model04}); // Pool
-    
-    scene_add_object(&scene, (object_t){{{{Q_FROM_INT(-18), Q_FROM_INT(0), Q_FROM_INT(-7)}}, Q_QUAT_IDENTITY, q_vec3_upscale_int(Q_VEC3_ONE, 4)}, scene_model05}); // House 
+    farm_scene_build(&scene);
 
     uint32_t prev_time_us = time_us_32();
     uint32_t lag_us = 0;
-    uint32_t prev_frame_time_us = prev_time_us;
+    uint32_t report_time_us = prev_time_us;
+    uint32_t report_frame_count = 0;
+    uint32_t triangle_count = 0;
+    histogram_reset(&frame_histogram);
+#if defined(TRACE_EVENT_COUNT)
+    bool dump_key_was_pressed = false;
+#endif
+#if defined(PGL_DEBUG_VIEWS)
+    pgl_debug_view_t debug_view = PGL_DEBUG_VIEW_NONE;
+    bool debug_keys_were_pressed = false;
+#endif
+#if defined(PGL_CAPTURE)
+    bool capture_keys_were_pressed = false;
+#endif
+#if defined(INPUT_LOG_EVENT_COUNT)
+    input_log_t input_log;
+    input_log_init(&input_log, input_log_events, INPUT_LOG_EVENT_COUNT);
+    bool record_keys_were_pressed = false;
+    bool replay_keys_were_pressed = false;
+    bool input_dump_pending = false;
+#endif
 
+    TRACE_BEGIN(TRACE_ZONE_SWAPCHAIN_WAIT);
     while (true)
     {
         const uint32_t curr_time_us = time_us_32();
@@ -122,36 +125,153 @@ int main()
 
         // ------------------------------------------- INPUT ------------------------------------------- //
 
-        while (lag_us >= PHYSICS_UPDATE_PERIOD_US)
+        while (lag_us >= INPUT_PHYSICS_UPDATE_PERIOD_US)
         {
-            Q_VEC3 delta_local_position;
-            Q_QUAT delta_local_rotation;
-            process_input(&delta_local_position, &delta_local_rotation);
-        
-            Q_VEC3* position = &scene.camera.transform.position;
-            Q_QUAT* rotation = &scene.camera.transform.rotation;
-
-            delta_local_position = q_quat_rotate_vec3(*rotation, delta_local_position);
-            *position = q_vec3_add(delta_local_position, *position);
-            *rotation = q_quat_mul_quat(delta_local_rotation, *rotation);
-
-            lag_us -= PHYSICS_UPDATE_PERIOD_US;
+#if defined(INPUT_LOG_EVENT_COUNT)
+            // A replay advances a tick per frame instead, so every replay renders the same frames at any frame rate
+            if (input_log.mode == INPUT_LOG_REPLAYING)
+            {
+                lag_us = 0;
+                break;
+            }
+
+            // A recording that fills the buffer ends by itself
+            const bool recording = (input_log.mode == INPUT_LOG_RECORDING);
+            const input_state_t state = input_log_step(&input_log, input_camera_sample_keys());
+            if (recording && input_log.mode != INPUT_LOG_RECORDING)
+                input_dump_pending = true;
+#else
+            const input_state_t state = input_camera_sample_keys();
+#endif
+            input_camera_step(state, &scene.camera.transform);
+
+            lag_us -= INPUT_PHYSICS_UPDATE_PERIOD_US;
         }
 
         // ------------------------------------------- RENDER ------------------------------------------- //
 
         if (pgl_request_draw_image())
         {
-            const uint32_t dt_frame_us = curr_time_us - prev_frame_time_us;
-            prev_frame_time_us = curr_time_us;
-            const uint32_t fps = 1000000 / dt_frame_us;
-            printf("FPS: %lu - Delta Time: %lu us\n", fps, dt_frame_us);
+            TRACE_END(TRACE_ZONE_SWAPCHAIN_WAIT);
+            TRACE_BEGIN(TRACE_ZONE_FRAME);
+
+#if defined(PGL_DEBUG_VIEWS)
+            // Pressing X and Y together, which cancel each other's movement, cycles through the debug views
+            const bool debug_keys_pressed = input_key_pressed(INPUT_KEY_X) && input_key_pressed(INPUT_KEY_Y);
+            if (debug_keys_pressed && !debug_keys_were_pressed)
+            {
+                debug_view = (pgl_debug_view_t)((debug_view + 1) % PGL_DEBUG_VIEW_COUNT);
+                pgl_debug_view(debug_view);
+            }
+            debug_keys_were_pressed = debug_keys_pressed;
+#endif
+
+#if defined(INPUT_LOG_EVENT_COUNT)
+            const bool was_replaying = (input_log.mode == INPUT_LOG_REPLAYING);
+            if (was_replaying)
+                input_camera_step(input_log_step(&input_log, 0), &scene.camera.transform);
+            const bool replaying = (input_log.mode == INPUT_LOG_REPLAYING);
+#endif
+
+            // Only the work of the frame is timed, from the clears to the resolve like pico-engine-input-replay does
+            const uint32_t frame_start_us = time_us_32();
 
             pgl_clear_colours(COLOUR_BLACK);
             pgl_clear_depths(DEPTH_FURTHEST);
-            scene_draw(&scene);
+            triangle_count = scene_draw(&scene);
+            pgl_resolve();
 
+            const uint32_t frame_us = time_us_32() - frame_start_us;
             swapchain_swap_images();
+            TRACE_END(TRACE_ZONE_FRAME);
+
+            histogram_add(&frame_histogram, frame_us);
+            ++report_frame_count;
+            if (curr_time_us - report_time_us >= REPORT_PERIOD_US)
+            {
+                report_frames(report_frame_count, curr_time_us - report_time_us, triangle_count);
+                report_time_us = curr_time_us;
+                report_frame_count = 0;
+            }
+
+#if defined(INPUT_LOG_EVENT_COUNT)
+            // The same lines as pico-engine-input-replay prints on the host
+            if (replaying)
+                LOG("INPUT FRAME %lu %lu", input_log.tick - 1, frame_us);
+
+            // The frames of a replay that ended are printed at once, so that none waits for the next pause of the display
+            if (was_replaying && !replaying)
+                log_flush(UINT32_MAX);
+#endif
+
+#if defined(TRACE_EVENT_COUNT)
+            // Pressing A dumps the frames recorded since the last dump, core 1 is idle until the next frame
+            const bool dump_key_pressed = input_key_pressed(INPUT_KEY_A);
+            if (dump_key_pressed && !dump_key_was_pressed)
+                trace_dump();
+            dump_key_was_pressed = dump_key_pressed;
+#endif
+#if defined(PGL_CAPTURE)
+            // Pressing CTRL and B together, neither of which moves the camera, captures the pgl calls of the next frames
+            // for the replay tool
+            const bool capture_keys_pressed = input_key_pressed(INPUT_KEY_CTRL) && input_key_pressed(INPUT_KEY_B);
+            if (capture_keys_pressed && !capture_keys_were_pressed)
+                pgl_capture_frames(CAPTURE_FRAME_COUNT);
+            capture_keys_were_pressed = capture_keys_pressed;
+#endif
+#if defined(INPUT_LOG_EVENT_COUNT)
+            // Pressing CTRL and X together starts a recording of the keys and ends it, which dumps it over stdio while
+            // the display is busy. A new recording waits for the dump of the last one.
+            // Pressing CTRL and Y together replays the recording from where it started, or stops the replay.
+            // input_camera_sample_keys leaves X and Y out while CTRL is held, so neither moves the camera.
+            const bool record_keys_pressed = input_key_pressed(INPUT_KEY_CTRL) && input_key_pressed(INPUT_KEY_X);
+            if (record_keys_pressed && !record_keys_were_pressed)
+            {
+                if (input_log.mode == INPUT_LOG_RECORDING)
+                {
+                    input_log_stop(&input_log);
+                    input_dump_pending = true;
+                }
+                else if (!input_dump_pending)
+                {
+                    input_log_stop(&input_log);
+                    input_log_record(&input_log, &scene.camera.transform);
+                }
+            }
+            record_keys_were_pressed = record_keys_pressed;
+
+            const bool replay_keys_pressed = input_key_pressed(INPUT_KEY_CTRL) && input_key_pressed(INPUT_KEY_Y);
+            if (replay_keys_pressed && !replay_keys_were_pressed)
+            {
+                if (input_log.mode == INPUT_LOG_IDLE && input_log.tick_count != 0)
+                    input_log_replay(&input_log, &scene.camera.transform);
+                else if (input_log.mode == INPUT_LOG_REPLAYING)
+                {
+                    input_log_stop(&input_log);
+                    log_flush(UINT32_MAX);
+                }
+            }
+            replay_keys_were_pressed = replay_keys_pressed;
+#endif
+
+            // Frames slower than the display never wait for it, so the log is printed here once the next frame could
+            // overflow it, rather than dropping entries
+            if (log_free_entries() < FRAME_LOG_ENTRY_COUNT)
+                log_flush(UINT32_MAX);
+            TRACE_BEGIN(TRACE_ZONE_SWAPCHAIN_WAIT);
+        }
+        else
+        {
+            // The display still holds the other image, print the whole log in the meantime
+            log_flush(UINT32_MAX);
+#if defined(INPUT_LOG_EVENT_COUNT)
+            // and the recording that ended, a line per event
+            if (input_dump_pending)
+            {
+                input_log_dump(&input_log);
+                input_dump_pending = false;
+            }
+#endif
         }
     }
 
@@ -0,0 +1,29 @@
+#include "farm_scene.h"
+#include "scene_models.h"
+
+void farm_scene_build(scene_t* scene)
+{
+    scene_init(scene, (camera_t){
+        .transform = {{{Q_ZERO, Q_ZERO, Q_ZERO}}, Q_QUAT_IDENTITY, Q_VEC3_ONE},
+        .camera = {Q_QUARTERPI, Q_FROM_FLOAT(0.1f), Q_FROM_FLOAT(100.0f)},
+    });
+
+    scene_add_object(scene, (object_t){{{{Q_FROM_INT( 0), Q_FROM_INT(0), Q_FROM_INT(-12)}}, Q_QUAT_IDENTITY, q_vec3_upscale_int(Q_VEC3_ONE, 8)}, scene_model01}); // Woods
+    scene_add_object(scene, (object_t){{{{Q_FROM_INT( 0), Q_FROM_INT(0), Q_FROM_INT(-24)}}, Q_QUAT_IDENTITY, q_vec3_upscale_int(Q_VEC3_ONE, 8)}, scene_model01}); // Woods
+    scene_add_object(scene, (object_t){{{{Q_FROM_INT(12), Q_FROM_INT(0), Q_FROM_INT(-24)}}, Q_QUAT_IDENTITY, q_vec3_upscale_int(Q_VEC3_ONE, 8)}, scene_model01}); // Woods
+    scene_add_object(scene, (object_t){{{{Q_FROM_INT(12), Q_FROM_INT(0), Q_FROM_INT(-12)}}, Q_QUAT_IDENTITY, q_vec3_upscale_int(Q_VEC3_ONE, 8)}, scene_model01}); // Woods
+
+    scene_add_object(scene, (object_t){{{{Q_FROM_INT(12), Q_FROM_FLOAT(-1.5f), Q_FROM_INT(-10)}}, Q_QUAT_IDENTITY, q_vec3_upscale_int(Q_VEC3_ONE, 1)}, scene_model02}); // Sheep
+    scene_add_object(scene, (object_t){{{{Q_FROM_INT(12), Q_FROM_FLOAT(-1.5f), Q_FROM_INT(-12)}}, Q_QUAT_IDENTITY, q_vec3_upscale_int(Q_VEC3_ONE, 1)}, scene_model02}); // Sheep
+    scene_add_object(scene, (object_t){{{{Q_FROM_INT(10), Q_FROM_FLOAT(-1.5f), Q_FROM_INT(-12)}}, Q_QUAT_IDENTITY, q_vec3_upscale_int(Q_VEC3_ONE, 1)}, scene_model02}); // Sheep
+    scene_add_object(scene, (object_t){{{{Q_FROM_INT(10), Q_FROM_FLOAT(-1.5f), Q_FROM_INT(-10)}}, Q_QUAT_IDENTITY, q_vec3_upscale_int(Q_VEC3_ONE, 1)}, scene_model02}); // Sheep
+
+    scene_add_object(scene, (object_t){{{{Q_FROM_INT(6), Q_FROM_FLOAT(-1.5f), Q_FROM_INT(-16)}}, Q_QUAT_IDENTITY, q_vec3_upscale_int(Q_VEC3_ONE, 1)}, scene_model02}); // Sheep
+    scene_add_object(scene, (object_t){{{{Q_FROM_INT(4), Q_FROM_FLOAT(-1.5f), Q_FROM_INT(-12)}}, Q_QUAT_IDENTITY, q_vec3_upscale_int(Q_VEC3_ONE, 1)}, scene_model02}); // Sheep
+    scene_add_object(scene, (object_t){{{{Q_FROM_INT(8), Q_FROM_FLOAT(-1.5f), Q_FROM_INT(-18)}}, Q_QUAT_IDENTITY, q_vec3_upscale_int(Q_VEC3_ONE, 1)}, scene_model02}); // Sheep
+    scene_add_object(scene, (object_t){{{{Q_FROM_INT(2), Q_FROM_FLOAT(-1.5f), Q_FROM_INT(-14)}}, Q_QUAT_IDENTITY, q_vec3_upscale_int(Q_VEC3_ONE, 1)}, scene_model02}); // Sheep
+
+    scene_add_object(scene, (object_t){{{{Q_FROM_INT(-10), Q_FROM_INT(2), Q_FROM_INT(-7)}}, Q_QUAT_IDENTITY, q_vec3_upscale_int(Q_VEC3_ONE, 4)}, scene_model03}); // Windmill
+    scene_add_object(scene, (object_t){{{{Q_FROM_INT(-10), Q_FROM_INT(-2), Q_FROM_INT(-3)}}, Q_QUAT_IDENTITY, q_vec3_upscale_int(Q_VEC3_ONE, 2)}, scene_model04}); // Pool
+    scene_add_object(scene, (object_t){{{{Q_FROM_INT(-18), Q_FROM_INT(0), Q_FROM_INT(-7)}}, Q_QUAT_IDENTITY, q_vec3_upscale_int(Q_VEC3_ONE, 4)}, scene_model05}); // House
+}
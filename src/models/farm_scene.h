@@ -0,0 +1,10 @@
+
+#ifndef PICO_ENGINE_MODELS_FARM_SCENE_H
+#define PICO_ENGINE_MODELS_FARM_SCENE_H
+
+#include "graphics/scene.h"
+
+// Builds the farm of the models with the camera at the origin, the scene of main.c and the benchmarks
+void farm_scene_build(scene_t* scene);
+
+#endif // PICO_ENGINE_MODELS_FARM_SCENE_H
@@ -10,4 +10,10 @@ extern const model_t scene_model03;
 extern const model_t scene_model04;
 extern const model_t scene_model05;
 
+#if !defined(Q24_8)
+// Regions of scene_texture01 to scene_texture05 in the atlas shared by the models,
+// Q24_8 builds keep the textures apart since 8 fractional bits cannot address every texel of the atlas
+extern const texture_region_t scene_atlas_regions[];
+#endif
+
 #endif // PICO_GAME_ENGINE_MODELS_SCENE_MODELS_H
@@ -0,0 +1,383 @@
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pico/stdlib.h>
+#include "capture.h"
+
+#if defined(PGL_CAPTURE)
+
+#define PGL_CAPTURE_LINE_BYTES 32
+
+typedef struct
+{
+    const void* data;
+    uint32_t size;
+} pgl_capture_resource_t;
+
+static struct
+{
+    uint32_t requested_frames;
+    uint32_t remaining_frames; // Non-zero while recording
+
+    pgl_capture_resource_t resources[PGL_CAPTURE_MAX_RESOURCES];
+    uint32_t resource_count;
+
+#if PICO_ON_DEVICE
+    uint8_t line[PGL_CAPTURE_LINE_BYTES];
+    uint32_t line_size;
+#else
+    FILE* file;
+#endif
+
+    // The last state set before the capture, written when it starts
+    Q_VEC3 model[2]; // Position and scale
+    Q_QUAT rotation;
+    Q_VEC3 view[3];  // Eye, backward and up
+    Q_TYPE projection[3];
+    uint32_t viewport[4];
+    bool has_model, has_view, has_projection, has_viewport;
+} capture;
+
+// ------------------------------------- SINK ------------------------------------- //
+
+static bool pgl_capture_open()
+{
+#if PICO_ON_DEVICE
+    capture.line_size = 0;
+    return true;
+#else
+    const char* path = getenv("PGL_CAPTURE_FILE");
+    capture.file = fopen((path != NULL) ? path : "capture.pglc", "wb");
+    return (capture.file != NULL);
+#endif
+}
+
+#if PICO_ON_DEVICE
+static void pgl_capture_flush_line()
+{
+    if (capture.line_size == 0)
+        return;
+
+    printf("PGLC ");
+    for (uint32_t i = 0; i < capture.line_size; ++i)
+        printf("%02x", capture.line[i]);
+    printf("\n");
+    capture.line_size = 0;
+}
+#endif
+
+static void pgl_capture_write(const void* data, uint32_t size)
+{
+#if PICO_ON_DEVICE
+    const uint8_t* bytes = (const uint8_t*)data;
+    for (uint32_t i = 0; i < size; ++i)
+    {
+        capture.line[capture.line_size++] = bytes[i];
+        if (capture.line_size == PGL_CAPTURE_LINE_BYTES)
+            pgl_capture_flush_line();
+    }
+#else
+    fwrite(data, 1, size, capture.file);
+#endif
+}
+
+static void pgl_capture_close()
+{
+#if PICO_ON_DEVICE
+    pgl_capture_flush_line();
+#else
+    fclose(capture.file);
+    capture.file = NULL;
+#endif
+}
+
+static void pgl_capture_write_u8(uint8_t value)
+{
+    pgl_capture_write(&value, 1);
+}
+
+static void pgl_capture_write_u16(uint16_t value)
+{
+    const uint8_t bytes[2] = {(uint8_t)value, (uint8_t)(value >> 8)};
+    pgl_capture_write(bytes, sizeof(bytes));
+}
+
+static void pgl_capture_write_u32(uint32_t value)
+{
+    const uint8_t bytes[4] = {(uint8_t)value, (uint8_t)(value >> 8), (uint8_t)(value >> 16), (uint8_t)(value >> 24)};
+    pgl_capture_write(bytes, sizeof(bytes));
+}
+
+// Writes the Q values of a vector, a quaternion or an array of them in memory order
+static void pgl_capture_write_values(const void* values, uint32_t size)
+{
+    for (uint32_t i = 0; i < size / sizeof(Q_TYPE); ++i)
+        pgl_capture_write_u32((uint32_t)((const Q_TYPE*)values)[i]);
+}
+
+// ------------------------------------- RESOURCES ------------------------------------- //
+
+// Returns the id of the data, writing it first if it has not been written with at least size bytes yet
+static uint16_t pgl_capture_resource(const void* data, uint32_t size)
+{
+    if (data == NULL)
+        return PGL_CAPTURE_NULL;
+
+    for (uint32_t id = 0; id < capture.resource_count; ++id)
+        if (capture.resources[id].data == data && capture.resources[id].size >= size)
+            return (uint16_t)id;
+
+    // The replay fails on the missing resource, which tells more than a silently wrong frame
+    if (capture.resource_count == PGL_CAPTURE_MAX_RESOURCES)
+        return PGL_CAPTURE_NULL;
+
+    const uint16_t id = (uint16_t)capture.resource_count++;
+    capture.resources[id] = (pgl_capture_resource_t){data, size};
+
+    pgl_capture_write_u8(PGL_CAPTURE_RECORD_RESOURCE);
+    pgl_capture_write_u16(id);
+    pgl_capture_write_u32(size);
+    pgl_capture_write(data, size);
+    return id;
+}
+
+static uint32_t pgl_capture_bits_per_texel(uint format)
+{
+    switch (format)
+    {
+        case PGL_TEXTURE_FORMAT_INDEX8: return 8;
+        case PGL_TEXTURE_FORMAT_INDEX4: return 4;
+        default:                        return 8 * sizeof(colour_t);
+    }
+}
+
+// ------------------------------------- RECORDS ------------------------------------- //
+
+static void pgl_capture_write_model()
+{
+    pgl_capture_write_u8(PGL_CAPTURE_RECORD_MODEL);
+    pgl_capture_write_values(&capture.model[0], sizeof(Q_VEC3));
+    pgl_capture_write_values(&capture.rotation, sizeof(Q_QUAT));
+    pgl_capture_write_values(&capture.model[1], sizeof(Q_VEC3));
+}
+
+static void pgl_capture_write_view()
+{
+    pgl_capture_write_u8(PGL_CAPTURE_RECORD_VIEW);
+    pgl_capture_write_values(capture.view, sizeof(capture.view));
+}
+
+static void pgl_capture_write_projection()
+{
+    pgl_capture_write_u8(PGL_CAPTURE_RECORD_PROJECTION);
+    pgl_capture_write_values(capture.projection, sizeof(capture.projection));
+}
+
+static void pgl_capture_write_viewport()
+{
+    pgl_capture_write_u8(PGL_CAPTURE_RECORD_VIEWPORT);
+    for (uint32_t i = 0; i < COUNT_OF(capture.viewport); ++i)
+        pgl_capture_write_u32(capture.viewport[i]);
+}
+
+static void pgl_capture_begin()
+{
+    capture.remaining_frames = capture.requested_frames;
+    capture.requested_frames = 0;
+    capture.resource_count = 0;
+
+    pgl_capture_write(PGL_CAPTURE_MAGIC, 4);
+    pgl_capture_write_u8(PGL_CAPTURE_VERSION);
+    pgl_capture_write_u8(Q_FRAC_BITS);
+    pgl_capture_write_u8(sizeof(colour_t));
+    pgl_capture_write_u8(sizeof(depth_t));
+    pgl_capture_write_u16(SCREEN_WIDTH);
+    pgl_capture_write_u16(SCREEN_HEIGHT);
+
+    // The frames may depend on the state set before them
+    if (capture.has_model)
+        pgl_capture_write_model();
+    if (capture.has_view)
+        pgl_capture_write_view();
+    if (capture.has_projection)
+        pgl_capture_write_projection();
+    if (capture.has_viewport)
+        pgl_capture_write_viewport();
+}
+
+void pgl_capture_frames(uint32_t frame_count)
+{
+    if (capture.remaining_frames == 0)
+        capture.requested_frames = frame_count;
+}
+
+void pgl_capture_model(Q_VEC3 position, Q_QUAT rotation, Q_VEC3 scale)
+{
+    capture.model[0] = position;
+    capture.rotation = rotation;
+    capture.model[1] = scale;
+    capture.has_model = true;
+
+    if (capture.remaining_frames != 0)
+        pgl_capture_write_model();
+}
+
+void pgl_capture_view(Q_VEC3 eye, Q_VEC3 backward, Q_VEC3 up)
+{
+    capture.view[0] = eye;
+    capture.view[1] = backward;
+    capture.view[2] = up;
+    capture.has_view = true;
+
+    if (capture.remaining_frames != 0)
+        pgl_capture_write_view();
+}
+
+void pgl_capture_projection(Q_TYPE fovw, Q_TYPE near, Q_TYPE far)
+{
+    capture.projection[0] = fovw;
+    capture.projection[1] = near;
+    capture.projection[2] = far;
+    capture.has_projection = true;
+
+    if (capture.remaining_frames != 0)
+        pgl_capture_write_projection();
+}
+
+void pgl_capture_viewport(int32_t x, int32_t y, uint32_t width, uint32_t height)
+{
+    capture.viewport[0] = (uint32_t)x;
+    capture.viewport[1] = (uint32_t)y;
+    capture.viewport[2] = width;
+    capture.viewport[3] = height;
+    capture.has_viewport = true;
+
+    if (capture.remaining_frames != 0)
+        pgl_capture_write_viewport();
+}
+
+void pgl_capture_clear_colours(colour_t colour)
+{
+    if (capture.remaining_frames == 0)
+        return;
+
+    pgl_capture_write_u8(PGL_CAPTURE_RECORD_CLEAR_COLOURS);
+    pgl_capture_write_u32(colour);
+}
+
+void pgl_capture_clear_depths(depth_t depth)
+{
+    if (capture.remaining_frames == 0)
+        return;
+
+    pgl_capture_write_u8(PGL_CAPTURE_RECORD_CLEAR_DEPTHS);
+    pgl_capture_write_u32(depth);
+}
+
+void pgl_capture_request_draw_image(bool received)
+{
+    if (!received)
+        return;
+
+    if (capture.remaining_frames == 0)
+    {
+        if (capture.requested_frames == 0 || !pgl_capture_open())
+            return;
+        pgl_capture_begin();
+    }
+
+    pgl_capture_write_u8(PGL_CAPTURE_RECORD_FRAME);
+}
+
+void pgl_capture_bind_texture(const pgl_texture_t* texture)
+{
+    if (capture.remaining_frames == 0)
+        return;
+
+    // The sizes follow the levels that pgl_bind_texture sets up
+    const uint32_t bits_per_texel = pgl_capture_bits_per_texel(texture->format);
+    const uint32_t min_width_bits = (texture->format == PGL_TEXTURE_FORMAT_INDEX4) ? 1 : 0;
+    uint32_t level_count = (texture->mipmaps != NULL) ? texture->level_count : 1;
+    level_count = SMALLER(level_count, SMALLER(texture->width_bits - min_width_bits, texture->height_bits) + 1u);
+
+    uint32_t mipmap_size = 0;
+    for (uint32_t i = 1; i < level_count; ++i)
+        mipmap_size += ((1u << (texture->width_bits + texture->height_bits - 2 * i)) * bits_per_texel + 7) / 8;
+
+    const uint32_t palette_size = (texture->format == PGL_TEXTURE_FORMAT_COLOUR) ? 0 : (1u << bits_per_texel) * sizeof(colour_t);
+
+    const uint16_t texels  = pgl_capture_resource(texture->texels, ((1u << (texture->width_bits + texture->height_bits)) * bits_per_texel + 7) / 8);
+    const uint16_t mipmaps = (mipmap_size != 0) ? pgl_capture_resource(texture->mipmaps, mipmap_size) : PGL_CAPTURE_NULL;
+    const uint16_t palette = (palette_size != 0) ? pgl_capture_resource(texture->palette, palette_size) : PGL_CAPTURE_NULL;
+
+    pgl_capture_write_u8(PGL_CAPTURE_RECORD_BIND_TEXTURE);
+    pgl_capture_write_u16(texels);
+    pgl_capture_write_u16(mipmaps);
+    pgl_capture_write_u16(palette);
+    pgl_capture_write_u16(texture->width_bits);
+    pgl_capture_write_u16(texture->height_bits);
+    pgl_capture_write_u16(texture->level_count);
+    pgl_capture_write_u16(texture->format);
+    pgl_capture_write_u16(texture->layout);
+}
+
+void pgl_capture_draw(const void* vertices, bool packed, const uint16_t* indices, uint16_t index_count)
+{
+    if (capture.remaining_frames == 0)
+        return;
+
+    uint32_t vertex_count = 0;
+    for (uint32_t i = 0; i < index_count; ++i)
+        vertex_count = GREATER(vertex_count, indices[i] + 1u);
+    const uint32_t vertex_size = packed ? sizeof(pgl_packed_vertex_t) : sizeof(pgl_vertex_t);
+
+    const uint16_t vertex_id = pgl_capture_resource(vertices, vertex_count * vertex_size);
+    const uint16_t index_id  = pgl_capture_resource(indices, index_count * sizeof(uint16_t));
+
+    pgl_capture_write_u8(PGL_CAPTURE_RECORD_DRAW);
+    pgl_capture_write_u8(packed);
+    pgl_capture_write_u16(vertex_id);
+    pgl_capture_write_u16(index_id);
+    pgl_capture_write_u16(index_count);
+}
+
+void pgl_capture_draw_meshlets(const void* vertices, bool packed, const pgl_meshlet_t* meshlets, uint16_t meshlet_count, const uint8_t* indices)
+{
+    if (capture.remaining_frames == 0)
+        return;
+
+    uint32_t vertex_count = 0;
+    uint32_t index_count = 0;
+    for (uint32_t m = 0; m < meshlet_count; ++m)
+    {
+        vertex_count = GREATER(vertex_count, (uint32_t)meshlets[m].vertex_offset + meshlets[m].vertex_count);
+        index_count  = GREATER(index_count,  (uint32_t)meshlets[m].index_offset + 3u * meshlets[m].triangle_count);
+    }
+    const uint32_t vertex_size = packed ? sizeof(pgl_packed_vertex_t) : sizeof(pgl_vertex_t);
+
+    const uint16_t vertex_id  = pgl_capture_resource(vertices, vertex_count * vertex_size);
+    const uint16_t meshlet_id = pgl_capture_resource(meshlets, meshlet_count * sizeof(pgl_meshlet_t));
+    const uint16_t index_id   = pgl_capture_resource(indices, index_count);
+
+    pgl_capture_write_u8(PGL_CAPTURE_RECORD_DRAW_MESHLETS);
+    pgl_capture_write_u8(packed);
+    pgl_capture_write_u16(vertex_id);
+    pgl_capture_write_u16(meshlet_id);
+    pgl_capture_write_u16(meshlet_count);
+    pgl_capture_write_u16(index_id);
+}
+
+void pgl_capture_resolve()
+{
+    if (capture.remaining_frames == 0)
+        return;
+
+    pgl_capture_write_u8(PGL_CAPTURE_RECORD_RESOLVE);
+    if (--capture.remaining_frames == 0)
+    {
+        pgl_capture_write_u8(PGL_CAPTURE_RECORD_END);
+        pgl_capture_close();
+    }
+}
+
+#endif // PGL_CAPTURE
@@ -0,0 +1,52 @@
+
+#ifndef PICO_ENGINE_PGL_CAPTURE_H
+#define PICO_ENGINE_PGL_CAPTURE_H
+
+#include "pgl.h"
+
+// A capture starts with the magic, the version, Q_FRAC_BITS, the sizes of colour_t and depth_t as bytes
+// and the screen width and height as 16-bit values. Then come the records, each a type byte followed by
+// its fields, all little-endian. The data a call refers to is written once as a resource record before
+// the first call that refers to it, the calls refer to it by its id.
+#define PGL_CAPTURE_MAGIC           "PGLC"
+#define PGL_CAPTURE_VERSION         1
+#define PGL_CAPTURE_MAX_RESOURCES   256
+#define PGL_CAPTURE_NULL            UINT16_MAX // The id of a NULL pointer
+
+typedef enum
+{
+    PGL_CAPTURE_RECORD_RESOURCE,      // u16 id, u32 size, the bytes
+    PGL_CAPTURE_RECORD_FRAME,         // pgl_request_draw_image received an image
+    PGL_CAPTURE_RECORD_MODEL,         // position, rotation and scale as Q values in the memory order of Q_VEC3 and Q_QUAT
+    PGL_CAPTURE_RECORD_VIEW,          // eye, backward and up as 9 Q values
+    PGL_CAPTURE_RECORD_PROJECTION,    // fovw, near and far as 3 Q values
+    PGL_CAPTURE_RECORD_VIEWPORT,      // i32 x, i32 y, u32 width, u32 height
+    PGL_CAPTURE_RECORD_CLEAR_COLOURS, // u32 colour
+    PGL_CAPTURE_RECORD_CLEAR_DEPTHS,  // u32 depth
+    PGL_CAPTURE_RECORD_BIND_TEXTURE,  // u16 ids of the texels, the mipmaps and the palette, then the other fields as u16
+    PGL_CAPTURE_RECORD_DRAW,          // u8 packed, u16 ids of the vertices and the indices, u16 index count
+    PGL_CAPTURE_RECORD_DRAW_MESHLETS, // u8 packed, u16 ids of the vertices and the meshlets, u16 meshlet count, u16 id of the indices
+    PGL_CAPTURE_RECORD_RESOLVE,
+    PGL_CAPTURE_RECORD_END,
+} pgl_capture_record_t;
+
+// Records the pgl calls of the next frame_count frames, from the next pgl_request_draw_image that receives an image
+// to the pgl_resolve of the last frame. On device the capture is streamed over stdio as "PGLC <hex>" lines, on the
+// host it is written to the file named by the PGL_CAPTURE_FILE environment variable, capture.pglc by default.
+// The pico-engine-capture-replay target replays either on the host.
+void pgl_capture_frames(uint32_t frame_count);
+
+// Called by pgl on entry to the calls of pgl.h
+void pgl_capture_model(Q_VEC3 position, Q_QUAT rotation, Q_VEC3 scale);
+void pgl_capture_view(Q_VEC3 eye, Q_VEC3 backward, Q_VEC3 up);
+void pgl_capture_projection(Q_TYPE fovw, Q_TYPE near, Q_TYPE far);
+void pgl_capture_viewport(int32_t x, int32_t y, uint32_t width, uint32_t height);
+void pgl_capture_clear_colours(colour_t colour);
+void pgl_capture_clear_depths(depth_t depth);
+void pgl_capture_request_draw_image(bool received);
+void pgl_capture_bind_texture(const pgl_texture_t* texture);
+void pgl_capture_draw(const void* vertices, bool packed, const uint16_t* indices, uint16_t index_count);
+void pgl_capture_draw_meshlets(const void* vertices, bool packed, const pgl_meshlet_t* meshlets, uint16_t meshlet_count, const uint8_t* indices);
+void pgl_capture_resolve();
+
+#endif // PICO_ENGINE_PGL_CAPTURE_H
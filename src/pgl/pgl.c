@@ -1,14 +1,103 @@
 
 #include <pico/multicore.h>
 #include "pgl.h"
+#include "common/reciprocal.h"
+#include "trace/trace.h"
+#include "capture.h"
+
+#if defined(PGL_DEBUG_VIEWS) && PICO_ON_DEVICE
+    #include <hardware/structs/systick.h>
+#elif defined(PGL_DEBUG_VIEWS)
+    #include <time.h>
+#endif
 
 // ------------------------------------- TYPES ------------------------------------- //
 
-#define CLIP_POLY_MAX_VERTEX    8
+#define CLIP_POLY_MAX_VERTEX    9 // Each of the 6 planes adds at most one vertex to the triangle
 #define CLIP_BUFFER_SIZE        8
 
 #define CORE1_TRIANGLE_DRAW_COMMAND   1
-#define CORE1_TEXTURE_CONFIG_COMMAND  2
+#define CORE1_RESOLVE_COMMAND         2
+#define CORE1_MESHLET_DRAW_COMMAND    3
+
+#define PGL_TEXTURE_MAX_LEVELS 16
+#define PGL_MESHLET_EYE_LIMIT    Q_FROM_INT(64) // Leaves room for the apexes, which lie within a few units
+#define PGL_MESHLET_OFFSET_LIMIT Q_FROM_INT(4)  // Three squares of it still fit in Q8_24
+#define PGL_MORTON_TABLE_BITS  8
+
+// Texture coordinates are perspective-correct at every PGL_AFFINE_SPAN_LENGTH pixels
+// and interpolated affinely in between by the interpolator
+#ifndef PGL_AFFINE_SPAN_LENGTH
+    #define PGL_AFFINE_SPAN_LENGTH 16
+#endif
+
+// Core 0 alone draws and resolves with PGL_SINGLE_CORE. The cores do not race on the pixels then, so the image of a
+// frame is the same in every run, which the golden images need.
+#if defined(PGL_SINGLE_CORE)
+    #define PGL_CORE_COUNT 1
+#else
+    #define PGL_CORE_COUNT NUM_CORES
+#endif
+
+#if defined(PGL_DEFERRED_TEXTURING) && defined(PGL_SPAN_BUFFER)
+    #error "PGL_DEFERRED_TEXTURING and PGL_SPAN_BUFFER cannot be used together!"
+#endif
+
+#if defined(PGL_DEFERRED_TEXTURING) || defined(PGL_SPAN_BUFFER)
+    #define PGL_PRIMITIVE_PLANES
+
+    #ifndef PGL_PRIMITIVE_COUNT
+        #define PGL_PRIMITIVE_COUNT 2048
+    #endif
+
+    #if PGL_PRIMITIVE_COUNT >= UINT16_MAX
+        #error "PGL_PRIMITIVE_COUNT is too large to be addressed by 16-bit primitive ids!"
+    #endif
+
+    #define PGL_PRIMITIVE_NONE UINT16_MAX
+#endif
+
+#if defined(PGL_DEFERRED_TEXTURING)
+    #if !defined(RGB565)
+        #error "PGL_DEFERRED_TEXTURING stores primitive ids in the colour buffer and requires RGB565!"
+    #endif
+
+    #define PGL_DEFERRED_MASK_WORDS ((SCREEN_WIDTH + 31) / 32)
+#endif
+
+#if defined(PGL_SPAN_BUFFER)
+    #ifndef PGL_SPAN_COUNT
+        #define PGL_SPAN_COUNT 8192
+    #endif
+
+    #if PGL_SPAN_COUNT >= UINT16_MAX
+        #error "PGL_SPAN_COUNT is too large to be addressed by 16-bit span indices!"
+    #endif
+
+    #define PGL_SPAN_NONE UINT16_MAX
+#endif
+
+// Each core counts into its own statistics, so the counters need no lock
+#if defined(PGL_STATS)
+    #define PGL_STATS_ADD(counter, value) (context.stats[get_core_num()].counter += (value))
+#else
+    #define PGL_STATS_ADD(counter, value) ((void)0)
+#endif
+
+#if defined(PGL_DEBUG_VIEWS)
+    #define PGL_DEBUG_TILE_SIZE    16
+    #define PGL_DEBUG_TILE_ROWS    ((SCREEN_HEIGHT + PGL_DEBUG_TILE_SIZE - 1) / PGL_DEBUG_TILE_SIZE)
+    #define PGL_DEBUG_TILE_COLUMNS ((SCREEN_WIDTH  + PGL_DEBUG_TILE_SIZE - 1) / PGL_DEBUG_TILE_SIZE)
+    #define PGL_DEBUG_MAX_COUNT    255
+    #define PGL_DEBUG_TICK_MASK    0x00FFFFFFu // SysTick is a 24-bit counter
+
+    // Times the rasterisation or the resolve of [left, right] of a row for PGL_DEBUG_VIEW_TILE_TIME
+    #define PGL_DEBUG_TIME_BEGIN()             const uint32_t debug_start_ticks = pgl_debug_ticks()
+    #define PGL_DEBUG_TIME_END(y, left, right) pgl_debug_add_ticks((y), (left), (right), pgl_debug_ticks() - debug_start_ticks)
+#else
+    #define PGL_DEBUG_TIME_BEGIN()             ((void)0)
+    #define PGL_DEBUG_TIME_END(y, left, right) ((void)0)
+#endif
 
 typedef struct
 {
@@ -37,11 +126,67 @@ typedef struct
     Q_TYPE inv_depth;
 } pgl_rast_vertex_t;
 
+// A single mip level of the bound texture
+typedef struct
+{
+    const void* texels;
+    const colour_t* palette;
+    uint8_t width_bits;
+    uint8_t height_bits;
+    uint8_t format;
+    uint8_t layout;
+    uint8_t coord_shift; // Texture coordinates are shifted left by it when the texel offsets need more than Q_FRAC_BITS bits
+} pgl_texture_level_t;
+
+#if defined(PGL_PRIMITIVE_PLANES)
+// Screen-space planes of u/w, v/w and 1/w, evaluated relative to (x, y)
+typedef struct
+{
+    pgl_texture_level_t level;
+    Q_TYPE u, dudx, dudy;
+    Q_TYPE v, dvdx, dvdy;
+    Q_TYPE w, dwdx, dwdy;
+    int16_t x, y;
+} pgl_primitive_t;
+#endif
+
+#if defined(PGL_SPAN_BUFFER)
+// Horizontal run of pixels [left, right] where the primitive is visible
 typedef struct
 {
+    int16_t left, right;
+    uint16_t primitive;
+    uint16_t next;
+} pgl_span_t;
+#endif
+
+typedef struct
+{
+#if !defined(PGL_SPAN_BUFFER)
     depth_t depths[SCREEN_HEIGHT][SCREEN_WIDTH];
+#endif
     swapchain_image_t* draw_image;
 
+#if defined(PGL_PRIMITIVE_PLANES)
+    pgl_primitive_t primitives[PGL_PRIMITIVE_COUNT];
+    uint32_t primitive_count;
+    pgl_primitive_t candidates[NUM_CORES];
+    uint16_t active_primitives[NUM_CORES];
+#endif
+
+#if defined(PGL_DEFERRED_TEXTURING)
+    // A set bit means that the colour buffer holds a primitive id instead of a colour
+    uint32_t deferred_mask[SCREEN_HEIGHT][PGL_DEFERRED_MASK_WORDS];
+#endif
+
+#if defined(PGL_SPAN_BUFFER)
+    pgl_span_t spans[PGL_SPAN_COUNT];
+    uint16_t span_heads[SCREEN_HEIGHT];
+    uint16_t span_free;
+    uint32_t span_free_count;
+    uint32_t span_count;
+#endif
+
     Q_MAT4 model;
     Q_MAT4 view;
     Q_MAT4 projection;
@@ -50,15 +195,56 @@ typedef struct
     Q_TYPE near;
     Q_TYPE far;
 
+    // The inputs of the model and view matrices, the meshlet culling works in the space of the vertices
+    Q_VEC3 model_position;
+    Q_QUAT model_rotation;
+    Q_VEC3 model_scale;
+    Q_VEC3 eye;
+    // Lengths of the normals of the side planes of the frustum in the view space
+    Q_TYPE frustum_x_norm;
+    Q_TYPE frustum_y_norm;
+
     spin_lock_t* spin_lock;
 
+    // The texture the levels are set up for, models sharing an atlas bind it once
+    pgl_texture_t texture;
+    pgl_texture_level_t levels[PGL_TEXTURE_MAX_LEVELS];
+    uint level_count;
+    // The level that interp0 of each core is programmed for
+    pgl_texture_level_t bound_levels[NUM_CORES];
+
+    // Only one of them is set, by pgl_draw, pgl_draw_packed or their meshlet variants
     const pgl_vertex_t* vertices;
+    const pgl_packed_vertex_t* packed_vertices;
     const uint16_t* indices;
     uint16_t index_count;
+
+    const pgl_meshlet_t* meshlets;
+    const uint8_t* meshlet_indices;
+    uint16_t meshlet_count;
+    Q_VEC3 meshlet_eye;          // The eye in the space of the vertices, halved meshlet_eye_shift times
+    uint32_t meshlet_eye_shift;
+    Q_TYPE meshlet_radius_scale; // The largest scale of the model matrix
+
+#if defined(PGL_STATS)
+    // Counted by each core in the current frame, latched by pgl_resolve
+    pgl_stats_t stats[NUM_CORES];
+    pgl_stats_t frame_stats[NUM_CORES];
+#endif
+
+#if defined(PGL_DEBUG_VIEWS)
+    // The view of the current frame is latched from the requested one by pgl_clear_colours
+    pgl_debug_view_t debug_view;
+    pgl_debug_view_t requested_debug_view;
+    // Counted by each core in the current frame
+    uint32_t debug_tile_ticks[NUM_CORES][PGL_DEBUG_TILE_ROWS][PGL_DEBUG_TILE_COLUMNS];
+#endif
 } pgl_context_t;
 
 static pgl_context_t context = {
+#if !defined(PGL_SPAN_BUFFER)
     .depths = {{DEPTH_FURTHEST}},
+#endif
     .draw_image = NULL,
 
     .model      = Q_MAT4_ZERO,
@@ -71,13 +257,31 @@ static pgl_context_t context = {
 
     .spin_lock = NULL,
 
+    .level_count = 0,
+
     .vertices = NULL,
     .indices = NULL,
     .index_count = 0,
+
+    .meshlets = NULL,
+    .meshlet_count = 0,
 };
 
 // ------------------------------------- CLIP ------------------------------------- // 
 
+// The distance of a clip-space position inside a plane, 64 bits wide since the sum of two coordinates of a vertex far
+// behind the eye can leave the range of Q8_24 and land on the wrong side
+static inline int64_t pgl_clip_distance(Q_VEC4 position, const pgl_clip_plane_t* plane)
+{
+    return ((int64_t)position.x * plane->normal.x + (int64_t)position.y * plane->normal.y +
+            (int64_t)position.z * plane->normal.z + (int64_t)position.w * plane->normal.w) >> Q_FRAC_BITS;
+}
+
+static inline Q_TYPE pgl_clip_lerp(Q_TYPE from, Q_TYPE to, Q_TYPE t)
+{
+    return (Q_TYPE)(from + (((int64_t)to - from) * t >> Q_FRAC_BITS));
+}
+
 static void pgl_clip_poly_plane(
     const pgl_clip_poly_t* restrict in,
     const pgl_clip_plane_t* plane,
@@ -95,151 +299,1069 @@ static void pgl_clip_poly_plane(
 
         prev_index = curr_index++;
 
-        const Q_TYPE curr_dot = q_vec4_dot(curr->position, plane->normal);
-        const Q_TYPE prev_dot = q_vec4_dot(prev->position, plane->normal);
+        const int64_t curr_dot = pgl_clip_distance(curr->position, plane);
+        const int64_t prev_dot = pgl_clip_distance(prev->position, plane);
 
-        const bool curr_inside = q_gt(curr_dot, Q_ZERO);
-        const bool prev_inside = q_gt(prev_dot, Q_ZERO);
+        const bool curr_inside = (curr_dot > 0);
+        const bool prev_inside = (prev_dot > 0);
 
         if (curr_inside != prev_inside)
         {
-            const Q_TYPE t  = q_div(curr_dot, q_sub(curr_dot, prev_dot));
-            out->verts[out->count++] = (pgl_clip_vertex_t){
-                .position  = q_vec4_interp(prev->position,  curr->position,  t),
-                .tex_coord = q_vec2_interp(prev->tex_coord, curr->tex_coord, t),
-            };
+            // The distances have opposite signs, so t lies in [0, 1] from curr to prev
+            const Q_TYPE t = (Q_TYPE)((curr_dot * (1 << Q_FRAC_BITS)) / (curr_dot - prev_dot));
+            out->verts[out->count++] = (pgl_clip_vertex_t){
+                .position  = {{
+                    pgl_clip_lerp(curr->position.x, prev->position.x, t),
+                    pgl_clip_lerp(curr->position.y, prev->position.y, t),
+                    pgl_clip_lerp(curr->position.z, prev->position.z, t),
+                    pgl_clip_lerp(curr->position.w, prev->position.w, t),
+                }},
+                .tex_coord = {{
+                    pgl_clip_lerp(curr->tex_coord.u, prev->tex_coord.u, t),
+                    pgl_clip_lerp(curr->tex_coord.v, prev->tex_coord.v, t),
+                }},
+            };
+        }
+        
+        if (curr_inside)
+            out->verts[out->count++] = *curr;
+    }
+}
+
+static uint32_t pgl_clip(const pgl_clip_triangle_t* restrict clip_triangle, pgl_clip_triangle_t* restrict triangle_out)
+{
+    static const pgl_clip_plane_t planes[] = {
+        {{ Q_ZERO,  Q_ZERO,   Q_ONE, Q_ONE}}, // Near     : +Z + W > 0.0
+        {{  Q_ONE,  Q_ZERO,  Q_ZERO, Q_ONE}}, // Left     : +X + W > 0.0
+        {{Q_M_ONE,  Q_ZERO,  Q_ZERO, Q_ONE}}, // Right    : -X + W > 0.0
+        {{ Q_ZERO,   Q_ONE,  Q_ZERO, Q_ONE}}, // Bottom   : +Y + W > 0.0
+        {{ Q_ZERO, Q_M_ONE,  Q_ZERO, Q_ONE}}, // Top      : -Y + W > 0.0
+        {{ Q_ZERO,  Q_ZERO, Q_M_ONE, Q_ONE}}, // Far      : -Z + W > 0.0
+    };
+
+    // Bit i of an outcode is set when the vertex is outside plane i
+    uint32_t outcodes[3] = {0, 0, 0};
+    for (uint32_t i = 0; i < COUNT_OF(planes); ++i)
+    {
+        for (uint32_t j = 0; j < 3; ++j)
+        {
+            if (pgl_clip_distance(clip_triangle->verts[j].position, &planes[i]) <= 0)
+                outcodes[j] |= 1u << i;
+        }
+    }
+
+    // The clipping passes would drop all of the vertices, or keep them in the same order
+    if ((outcodes[0] & outcodes[1] & outcodes[2]) != 0)
+    {
+        PGL_STATS_ADD(triangles_rejected, 1);
+        return 0;
+    }
+    if ((outcodes[0] | outcodes[1] | outcodes[2]) == 0)
+    {
+        triangle_out[0] = *clip_triangle;
+        return 1;
+    }
+
+    pgl_clip_poly_t poly0;
+    pgl_clip_poly_t poly1;
+    poly0.verts[0] = clip_triangle->verts[0];
+    poly0.verts[1] = clip_triangle->verts[1];
+    poly0.verts[2] = clip_triangle->verts[2];
+    poly0.count = 3;
+
+    pgl_clip_poly_t* poly_in  = &poly0;
+    pgl_clip_poly_t* poly_out = &poly1;
+
+    for (uint32_t i = 0; i < COUNT_OF(planes) && poly_in->count > 0; ++i)
+    {
+        pgl_clip_poly_plane(poly_in, &planes[i], poly_out);
+        SWAP(&poly_in, &poly_out);
+    }
+
+    uint32_t triangle_count = 0;
+    for (uint32_t i = 1; i + 1 < poly_in->count; ++i)
+    {
+        triangle_out[triangle_count++] = (pgl_clip_triangle_t){
+            poly_in->verts[0], 
+            poly_in->verts[i], 
+            poly_in->verts[i + 1],
+        };
+    }
+
+    PGL_STATS_ADD(triangles_clipped, 1);
+    PGL_STATS_ADD(clipped_triangles_out, triangle_count);
+    return triangle_count;
+}
+
+// ------------------------------------- TESTS ------------------------------------- //
+
+static inline depth_t pgl_depth_map(Q_TYPE q_depth)
+{
+    const Q_TYPE ratio = q_div(q_sub(q_depth, context.near), q_sub(context.far, context.near));
+    const depth_t depth = Q_TO_INT(q_add(q_mul_int(ratio, DEPTH_RANGE), Q_FROM_INT(DEPTH_NEAREST)));
+    return depth;
+}
+
+#if !defined(PGL_SPAN_BUFFER)
+static inline bool pgl_depth_test_passed(const depth_t* depth_in_buffer, depth_t depth)
+{
+    // Depth Test -> LESS
+    return (depth < *depth_in_buffer);
+}
+#endif
+
+static inline bool pgl_face_is_culled(Q_VEC2 v0_xy_ndc, Q_VEC2 v1_xy_ndc, Q_VEC2 v2_xy_ndc)
+{
+    // Front Face -> CCW and Cull Face -> BACK
+    const Q_VEC2 edge01 = q_vec2_sub(v1_xy_ndc, v0_xy_ndc);
+    const Q_VEC2 edge02 = q_vec2_sub(v2_xy_ndc, v0_xy_ndc);
+    const Q_TYPE area   = q_vec2_cross(edge01, edge02);
+    return (area < Q_ZERO);
+}
+
+// Returns twice the signed area of the triangle between the vertices snapped to pixels. A triangle whose snapped vertices
+// coincide or lie on a line has none and encloses no pixel. The scanlines would still draw the pixels along it, so it is
+// discarded before the texture level and the setup divide by the area.
+static inline int32_t pgl_triangle_snapped_area(const pgl_rast_vertex_t* vert0, const pgl_rast_vertex_t* vert1, const pgl_rast_vertex_t* vert2)
+{
+    return (vert1->x - vert0->x) * (vert2->y - vert0->y) - (vert2->x - vert0->x) * (vert1->y - vert0->y);
+}
+
+static bool pgl_meshlet_is_culled(const pgl_meshlet_t* meshlet)
+{
+    // Every triangle faces away from an eye inside the cone, which holds in any space since the model matrix is affine.
+    // Both sides of the test scale with the offset, which is halved like the eye and then until its squares fit.
+    const uint32_t eye_shift = context.meshlet_eye_shift;
+    Q_VEC3 apex_offset = {{
+        (meshlet->cone_apex.x >> eye_shift) - context.meshlet_eye.x,
+        (meshlet->cone_apex.y >> eye_shift) - context.meshlet_eye.y,
+        (meshlet->cone_apex.z >> eye_shift) - context.meshlet_eye.z,
+    }};
+    uint32_t offset_shift = 0;
+    for (Q_TYPE largest = GREATER(GREATER(ABS(apex_offset.x), ABS(apex_offset.y)), ABS(apex_offset.z)); largest > PGL_MESHLET_OFFSET_LIMIT; largest >>= 1)
+        ++offset_shift;
+    apex_offset = (Q_VEC3){{apex_offset.x >> offset_shift, apex_offset.y >> offset_shift, apex_offset.z >> offset_shift}};
+    if (q_ge(q_vec3_dot(apex_offset, meshlet->cone_axis), q_mul(meshlet->cone_cutoff, q_vec3_length(apex_offset))))
+        return true;
+
+    // The sphere grows by the largest scale, which keeps the test conservative for non-uniform scales
+    const Q_TYPE radius = q_mul(meshlet->radius, context.meshlet_radius_scale);
+    const Q_VEC4 view_centre = q_mat4_mul_vec4(context.view, q_mat4_mul_vec4(context.model, q_homogeneous_point(meshlet->centre)));
+    if (q_gt(q_sub(view_centre.z, radius), -context.near) || q_lt(q_add(view_centre.z, radius), -context.far))
+        return true;
+
+    // The distances to the side planes, clip.x <= clip.w and so on, scaled by the lengths of their normals
+    const Q_VEC4 clip_centre = q_mat4_mul_vec4(context.projection, view_centre);
+    const Q_TYPE x_limit = q_mul(radius, context.frustum_x_norm);
+    const Q_TYPE y_limit = q_mul(radius, context.frustum_y_norm);
+    return q_gt(q_sub( clip_centre.x, clip_centre.w), x_limit) ||
+           q_gt(q_sub(-clip_centre.x, clip_centre.w), x_limit) ||
+           q_gt(q_sub( clip_centre.y, clip_centre.w), y_limit) ||
+           q_gt(q_sub(-clip_centre.y, clip_centre.w), y_limit);
+}
+
+// ------------------------------------- TEXTURE ------------------------------------- //
+
+static inline uint pgl_texture_bits_per_texel(uint format)
+{
+    switch (format)
+    {
+        case PGL_TEXTURE_FORMAT_INDEX4: return 4;
+        case PGL_TEXTURE_FORMAT_INDEX8: return 8;
+        default:                        return 8 * sizeof(colour_t);
+    }
+}
+
+static void pgl_set_texture_lane(uint lane, int32_t shift, int32_t mask_lsb, int32_t mask_msb)
+{
+    interp_config cfg = interp_default_config();
+    interp_config_set_add_raw(&cfg, true);
+    if (mask_lsb <= mask_msb)
+    {
+        interp_config_set_shift(&cfg, shift);
+        interp_config_set_mask(&cfg, mask_lsb, mask_msb);
+    }
+    else
+    {
+        // The level is a single texel wide (or tall), shifting bit 31 out and masking only bit 31 gives 0
+        interp_config_set_shift(&cfg, 31);
+        interp_config_set_mask(&cfg, 31, 31);
+    }
+    interp_set_config(interp0, lane, &cfg);
+}
+
+// log2 of the bytes per texel, -1 when two texels share a byte
+static int32_t pgl_texture_bpp_shift(uint format)
+{
+    switch (format)
+    {
+        case PGL_TEXTURE_FORMAT_INDEX4: return -1;
+        case PGL_TEXTURE_FORMAT_INDEX8: return  0;
+#if defined(RGB332)
+        default:                        return  0; // log2(1 byte)
+#elif defined(RGB565)
+        default:                        return  1; // log2(2 bytes)
+#endif
+    }
+}
+
+static void pgl_bind_texture_internal(const pgl_texture_level_t* level)
+{
+    const int32_t width_bits  = level->width_bits;
+    const int32_t height_bits = level->height_bits;
+    const int32_t bpp_shift   = pgl_texture_bpp_shift(level->format);
+    const int32_t frac_bits   = Q_FRAC_BITS + level->coord_shift;
+
+    if (level->layout == PGL_TEXTURE_LAYOUT_MORTON)
+    {
+        // The lanes give the texel coordinates (x, y), which are interleaved by pgl_morton_offset
+        pgl_set_texture_lane(0, frac_bits - width_bits, 0, width_bits - 1);
+        pgl_set_texture_lane(1, frac_bits - height_bits, 0, height_bits - 1);
+        interp_set_base(interp0, 2, (uintptr_t)level->texels);
+        return;
+    }
+
+    pgl_set_texture_lane(0, frac_bits - width_bits - bpp_shift, GREATER(bpp_shift, 0), width_bits + bpp_shift - 1);
+    pgl_set_texture_lane(1, frac_bits - height_bits - width_bits - bpp_shift, width_bits + bpp_shift, width_bits + height_bits + bpp_shift - 1);
+
+    interp_set_base(interp0, 2, (uintptr_t)level->texels);
+}
+
+static inline void pgl_bind_texture_level(const pgl_texture_level_t* level)
+{
+    pgl_texture_level_t* bound_level = &context.bound_levels[get_core_num()];
+    if (bound_level->texels != level->texels)
+    {
+        pgl_bind_texture_internal(level);
+        *bound_level = *level;
+    }
+}
+
+// REQUIREMENT: The snapped area of the triangle is not zero
+// Picks the level with about one texel per pixel from the ratio of the texel-space to the screen-space area of the triangle
+static const pgl_texture_level_t* pgl_select_texture_level(int32_t screen_area, Q_VEC2 tex_coord0, Q_VEC2 tex_coord1, Q_VEC2 tex_coord2)
+{
+    if (context.level_count <= 1)
+        return &context.levels[0];
+
+    const int64_t tex_area = 
+        (int64_t)q_sub(tex_coord1.u, tex_coord0.u) * q_sub(tex_coord2.v, tex_coord0.v) - 
+        (int64_t)q_sub(tex_coord2.u, tex_coord0.u) * q_sub(tex_coord1.v, tex_coord0.v);
+
+    if (tex_area == 0)
+        return &context.levels[0];
+
+    // tex_area has 2 * Q_FRAC_BITS fractional bits and the base level has 2^(width_bits + height_bits) texels
+    const int32_t log2_tex_area = (63 - __builtin_clzll((uint64_t)ABS(tex_area))) - 2 * Q_FRAC_BITS + context.levels[0].width_bits + context.levels[0].height_bits;
+    const int32_t log2_screen_area = 31 - __builtin_clz((uint32_t)ABS(screen_area));
+
+    // Every level quarters the area
+    const int32_t level = (log2_tex_area - log2_screen_area) / 2;
+    return &context.levels[CLAMP(level, 0, (int32_t)context.level_count - 1)];
+}
+
+// Returns the colour of the texel, given its address popped from interp0 and
+// the u accumulator it was popped with, which selects the nibble of INDEX4 texels
+static inline colour_t pgl_fetch_texel(const pgl_texture_level_t* level, uintptr_t address, Q_TYPE u)
+{
+    switch (level->format)
+    {
+        case PGL_TEXTURE_FORMAT_INDEX4:
+        {
+            const uint32_t nibble_shift = ((u >> (Q_FRAC_BITS + level->coord_shift - level->width_bits)) & 1) << 2;
+            return level->palette[(*(const uint8_t*)address >> nibble_shift) & 0xF];
+        }
+        case PGL_TEXTURE_FORMAT_INDEX8:
+            return level->palette[*(const uint8_t*)address];
+        default:
+            return *(const colour_t*)address;
+    }
+}
+
+// The bits of i spread to the even bits, filled by pgl_init
+static uint16_t pgl_morton_table[1 << PGL_MORTON_TABLE_BITS];
+
+static void pgl_init_morton_table()
+{
+    for (uint32_t i = 0; i < COUNT_OF(pgl_morton_table); ++i)
+    {
+        uint32_t spread = 0;
+        for (uint32_t bit = 0; bit < PGL_MORTON_TABLE_BITS; ++bit)
+            spread |= ((i >> bit) & 1) << (2 * bit);
+        pgl_morton_table[i] = (uint16_t)spread;
+    }
+}
+
+// Returns the index of the texel (x, y) in a Morton texture, square_bits is the smaller of width_bits and height_bits
+static inline uint32_t pgl_morton_offset(uint32_t x, uint32_t y, uint32_t square_bits)
+{
+    const uint32_t square_mask = (1u << square_bits) - 1;
+    const uint32_t square = (x | y) >> square_bits;
+    return pgl_morton_table[x & square_mask] | (pgl_morton_table[y & square_mask] << 1) | (square << (2 * square_bits));
+}
+
+static inline colour_t pgl_fetch_morton_texel(const pgl_texture_level_t* level, uint32_t offset)
+{
+    switch (level->format)
+    {
+        case PGL_TEXTURE_FORMAT_INDEX4:
+        {
+            const uint8_t pair = ((const uint8_t*)level->texels)[offset >> 1];
+            return level->palette[(pair >> ((offset & 1) << 2)) & 0xF];
+        }
+        case PGL_TEXTURE_FORMAT_INDEX8:
+            return level->palette[((const uint8_t*)level->texels)[offset]];
+        default:
+            return ((const colour_t*)level->texels)[offset];
+    }
+}
+
+// REQUIREMENT: u and v must be non-negative
+static colour_t pgl_sample_texture(Q_TYPE u, Q_TYPE v) 
+{
+    const pgl_texture_level_t* level = &context.bound_levels[get_core_num()];
+    PGL_STATS_ADD(texels_fetched, 1);
+    // The integer bits shifted out are masked off by the interpolator anyway
+    u = (Q_TYPE)((uint32_t)u << level->coord_shift);
+    v = (Q_TYPE)((uint32_t)v << level->coord_shift);
+
+    interp_set_accumulator(interp0, 0, u);
+    interp_set_accumulator(interp0, 1, v);
+
+    if (level->layout == PGL_TEXTURE_LAYOUT_MORTON)
+    {
+        const uint32_t square_bits = SMALLER(level->width_bits, level->height_bits);
+        return pgl_fetch_morton_texel(level, pgl_morton_offset(interp_get_raw(interp0, 0), interp_get_raw(interp0, 1), square_bits));
+    }
+
+    // equivalent to
+    // uint32_t x = (accum0 >> (Q_FRAC_BITS - width_bits))  & ((1 << width_bits)  - 1);
+    // uint32_t y = (accum1 >> (Q_FRAC_BITS - height_bits)) & ((1 << height_bits) - 1);
+    // const colour_t* *address = texture + ((x + (y << width_bits)) << bpp_shift);
+    // return *address;
+
+    return pgl_fetch_texel(level, interp_pop_full_result(interp0), u);
+}
+
+// REQUIREMENT: u and v must be non-negative
+// su and sv may be negative, the accumulators wrap around and the texture repeats
+static void pgl_multisample_texture(Q_TYPE u, Q_TYPE v, Q_TYPE su, Q_TYPE sv, colour_t *output, uint32_t count) 
+{
+    const pgl_texture_level_t* level = &context.bound_levels[get_core_num()];
+    PGL_STATS_ADD(texels_fetched, count);
+    const uint coord_shift = level->coord_shift;
+
+    // The integer bits shifted out are masked off by the interpolator anyway
+    interp_set_accumulator(interp0, 0, (uint32_t)u << coord_shift);
+    interp_set_base(interp0, 0, (uint32_t)su << coord_shift);
+    interp_set_accumulator(interp0, 1, (uint32_t)v << coord_shift);
+    interp_set_base(interp0, 1, (uint32_t)sv << coord_shift);
+
+    if (level->layout == PGL_TEXTURE_LAYOUT_MORTON)
+    {
+        const uint32_t square_bits = SMALLER(level->width_bits, level->height_bits);
+        for (uint32_t i = 0; i < count; ++i) 
+        {
+            const uint32_t x = interp_get_raw(interp0, 0);
+            const uint32_t y = interp_get_raw(interp0, 1);
+            interp_pop_full_result(interp0);
+            output[i] = pgl_fetch_morton_texel(level, pgl_morton_offset(x, y, square_bits));
+        }
+    }
+    else if (level->format == PGL_TEXTURE_FORMAT_COLOUR)
+    {
+        for (uint32_t i = 0; i < count; ++i) 
+        {
+            // equivalent to
+            // uint32_t x = (accum0 >> (Q_FRAC_BITS - width_bits))  & ((1 << width_bits)  - 1);
+            // uint32_t y = (accum1 >> (Q_FRAC_BITS - height_bits)) & ((1 << height_bits) - 1);
+            // const colour_t* *address = texture + ((x + (y << width_bits)) << bpp_shift);
+            // output[i] = *address;
+            // accum0 = su + accum0;
+            // accum1 = sv + accum1;
+
+            // popping the result advances to the next iteration
+            output[i] = *(const colour_t*)interp_pop_full_result(interp0);
+        }
+    }
+    else if (level->format == PGL_TEXTURE_FORMAT_INDEX8)
+    {
+        for (uint32_t i = 0; i < count; ++i) 
+            output[i] = level->palette[*(const uint8_t*)interp_pop_full_result(interp0)];
+    }
+    else
+    {
+        for (uint32_t i = 0; i < count; ++i) 
+        {
+            const Q_TYPE u_accum = (Q_TYPE)interp_get_accumulator(interp0, 0);
+            output[i] = pgl_fetch_texel(level, interp_pop_full_result(interp0), u_accum);
+        }
+    }
+}
+
+// Textures count pixels from the perspective-correct coordinates of the first pixel (u0, v0)
+// towards the ones of the pixel after the last (u1, v1)
+static inline void pgl_texture_affine_span(Q_TYPE u0, Q_TYPE v0, Q_TYPE u1, Q_TYPE v1, colour_t* output, int32_t count)
+{
+    const Q_TYPE su = q_sub(u1, u0) / count;
+    const Q_TYPE sv = q_sub(v1, v0) / count;
+    pgl_multisample_texture(u0, v0, su, sv, output, count);
+}
+
+// ------------------------------------- SHADERS ------------------------------------- //
+
+// Packed positions have 15 fractional bits and packed texture coordinates 16
+#if defined(Q24_8)
+    #define PGL_UNPACK_POSITION(p)  ((Q_TYPE)(p) >> (15 - Q_FRAC_BITS))
+    #define PGL_UNPACK_TEX_COORD(t) ((Q_TYPE)((t) >> (16 - Q_FRAC_BITS)))
+#else
+    #define PGL_UNPACK_POSITION(p)  ((Q_TYPE)(p) * (1 << (Q_FRAC_BITS - 15)))
+    #define PGL_UNPACK_TEX_COORD(t) ((Q_TYPE)(t) << (Q_FRAC_BITS - 16))
+#endif
+
+static inline pgl_vertex_t pgl_fetch_vertex(uint16_t index)
+{
+    if (context.packed_vertices == NULL)
+        return context.vertices[index];
+
+    const pgl_packed_vertex_t* packed = &context.packed_vertices[index];
+    return (pgl_vertex_t){
+        .position = {{
+            PGL_UNPACK_POSITION(packed->position[0]),
+            PGL_UNPACK_POSITION(packed->position[1]),
+            PGL_UNPACK_POSITION(packed->position[2]),
+        }},
+        .tex_coord = {{
+            PGL_UNPACK_TEX_COORD(packed->tex_coord[0]),
+            PGL_UNPACK_TEX_COORD(packed->tex_coord[1]),
+        }},
+    };
+}
+
+static pgl_clip_vertex_t pgl_vertex_shader(pgl_vertex_t vertex)
+{
+    const Q_VEC4 point = q_homogeneous_point(vertex.position);
+    const Q_VEC4 pos_out = q_mat4_mul_vec4(context.projection, q_mat4_mul_vec4(context.view, q_mat4_mul_vec4(context.model, point)));
+
+    const pgl_clip_vertex_t clip_vertex = {
+        .position = pos_out,
+        .tex_coord = vertex.tex_coord,
+    };
+    return clip_vertex;
+}
+
+static inline colour_t pgl_fragment_shader(Q_TYPE u, Q_TYPE v)
+{
+    return pgl_sample_texture(u, v);
+}
+
+// ------------------------------------- DEBUG VIEWS ------------------------------------- //
+
+#if defined(PGL_DEBUG_VIEWS)
+
+static const colour_t pgl_debug_heat_colours[] = {
+    COLOUR_BLACK, COLOUR_DARKBLUE, COLOUR_BLUE, COLOUR_CYAN, COLOUR_GREEN, COLOUR_YELLOW, COLOUR_ORANGE, COLOUR_RED, COLOUR_WHITE,
+};
+
+// Each core has its own SysTick, which counts down the processor clock on device. On the host the ticks are nanoseconds
+// of the monotonic clock, as most spans take less than the microsecond of time_us_32.
+static void pgl_debug_init_ticks()
+{
+#if PICO_ON_DEVICE
+    systick_hw->rvr = PGL_DEBUG_TICK_MASK;
+    systick_hw->cvr = 0;
+    systick_hw->csr = (1u << 2) | (1u << 0); // CLKSOURCE (processor clock) | ENABLE
+#endif
+}
+
+static inline uint32_t pgl_debug_ticks()
+{
+#if PICO_ON_DEVICE
+    return ~systick_hw->cvr & PGL_DEBUG_TICK_MASK;
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint32_t)((uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec) & PGL_DEBUG_TICK_MASK;
+#endif
+}
+
+// In the counting views the colour buffer holds the counts of the pixels instead of their colours
+static inline bool pgl_debug_view_counts()
+{
+    return (context.debug_view == PGL_DEBUG_VIEW_OVERDRAW) || (context.debug_view == PGL_DEBUG_VIEW_DEPTH_REJECTS);
+}
+
+static void pgl_debug_count(colour_t* colours, int32_t left, int32_t right, int32_t delta)
+{
+    for (int32_t x = left; x <= right; ++x)
+        colours[x] = (colour_t)CLAMP((int32_t)colours[x] + delta, 0, PGL_DEBUG_MAX_COUNT);
+}
+
+// Spreads the ticks spent on [left, right] of the row over the tiles it crosses
+static void pgl_debug_add_ticks(int32_t y, int32_t left, int32_t right, uint32_t ticks)
+{
+    if (context.debug_view != PGL_DEBUG_VIEW_TILE_TIME)
+        return;
+
+    uint32_t* tiles = context.debug_tile_ticks[get_core_num()][y / PGL_DEBUG_TILE_SIZE];
+    const uint64_t masked_ticks = ticks & PGL_DEBUG_TICK_MASK;
+    const int32_t width = right - left + 1;
+
+    for (int32_t x = left; x <= right;)
+    {
+        const int32_t tile_right = SMALLER(x | (PGL_DEBUG_TILE_SIZE - 1), right);
+        tiles[x / PGL_DEBUG_TILE_SIZE] += (uint32_t)(masked_ticks * (tile_right - x + 1) / width);
+        x = tile_right + 1;
+    }
+}
+
+static void pgl_debug_begin_frame()
+{
+    context.debug_view = context.requested_debug_view;
+
+    uint32_t* ticks = (uint32_t*)context.debug_tile_ticks;
+    for (uint32_t i = 0; i < NUM_CORES * PGL_DEBUG_TILE_ROWS * PGL_DEBUG_TILE_COLUMNS; ++i)
+        ticks[i] = 0;
+}
+
+// Colour-codes the counts of the pixels, or the ticks of the tiles relative to the slowest tile
+static void pgl_debug_resolve()
+{
+    colour_t (*colours)[SCREEN_WIDTH] = context.draw_image->colours;
+    const uint32_t max_level = COUNT_OF(pgl_debug_heat_colours) - 1;
+
+    if (pgl_debug_view_counts())
+    {
+        for (uint32_t y = 0; y < SCREEN_HEIGHT; ++y)
+            for (uint32_t x = 0; x < SCREEN_WIDTH; ++x)
+                colours[y][x] = pgl_debug_heat_colours[SMALLER((uint32_t)colours[y][x], max_level)];
+    }
+    else if (context.debug_view == PGL_DEBUG_VIEW_TILE_TIME)
+    {
+        uint32_t max_ticks = 1;
+        for (uint32_t row = 0; row < PGL_DEBUG_TILE_ROWS; ++row)
+        {
+            for (uint32_t column = 0; column < PGL_DEBUG_TILE_COLUMNS; ++column)
+            {
+                for (uint core = 1; core < NUM_CORES; ++core)
+                    context.debug_tile_ticks[0][row][column] += context.debug_tile_ticks[core][row][column];
+                max_ticks = GREATER(max_ticks, context.debug_tile_ticks[0][row][column]);
+            }
+        }
+
+        for (uint32_t y = 0; y < SCREEN_HEIGHT; ++y)
+        {
+            for (uint32_t x = 0; x < SCREEN_WIDTH; ++x)
+            {
+                // Only the tiles without any work are black
+                const uint64_t ticks = context.debug_tile_ticks[0][y / PGL_DEBUG_TILE_SIZE][x / PGL_DEBUG_TILE_SIZE];
+                colours[y][x] = pgl_debug_heat_colours[(ticks * max_level + max_ticks - 1) / max_ticks];
+            }
+        }
+    }
+}
+
+#endif // PGL_DEBUG_VIEWS
+
+// ------------------------------------- PRIMITIVES ------------------------------------- //
+
+#if defined(PGL_PRIMITIVE_PLANES)
+
+static inline Q_TYPE pgl_plane_gradient(Q_TYPE d10, Q_TYPE d20, int32_t a, int32_t b, int32_t area)
+{
+    return q_sub(q_mul_int(d10, a), q_mul_int(d20, b)) / area;
+}
+
+static inline Q_TYPE pgl_plane_evaluate(Q_TYPE value, Q_TYPE dx_grad, Q_TYPE dy_grad, int32_t dx, int32_t dy)
+{
+    return q_add(value, q_add(q_mul_int(dx_grad, dx), q_mul_int(dy_grad, dy)));
+}
+
+static inline Q_TYPE pgl_primitive_inv_depth(const pgl_primitive_t* primitive, int32_t x, int32_t y)
+{
+    return pgl_plane_evaluate(primitive->w, primitive->dwdx, primitive->dwdy, x - primitive->x, y - primitive->y);
+}
+
+// REQUIREMENT: The area, the snapped area of the triangle, is not zero
+static void pgl_setup_primitive(
+    const pgl_rast_vertex_t* vert0,
+    const pgl_rast_vertex_t* vert1,
+    const pgl_rast_vertex_t* vert2,
+    int32_t area,
+    pgl_primitive_t* primitive)
+{
+    const int32_t dx10 = vert1->x - vert0->x;
+    const int32_t dy10 = vert1->y - vert0->y;
+    const int32_t dx20 = vert2->x - vert0->x;
+    const int32_t dy20 = vert2->y - vert0->y;
+
+    const Q_TYPE du10 = q_sub(vert1->u, vert0->u);
+    const Q_TYPE du20 = q_sub(vert2->u, vert0->u);
+    const Q_TYPE dv10 = q_sub(vert1->v, vert0->v);
+    const Q_TYPE dv20 = q_sub(vert2->v, vert0->v);
+    const Q_TYPE dw10 = q_sub(vert1->inv_depth, vert0->inv_depth);
+    const Q_TYPE dw20 = q_sub(vert2->inv_depth, vert0->inv_depth);
+
+    primitive->level = context.bound_levels[get_core_num()];
+    primitive->x = (int16_t)vert0->x;
+    primitive->y = (int16_t)vert0->y;
+    primitive->u = vert0->u;
+    primitive->v = vert0->v;
+    primitive->w = vert0->inv_depth;
+    primitive->dudx = pgl_plane_gradient(du10, du20, dy20, dy10, area);
+    primitive->dudy = pgl_plane_gradient(du20, du10, dx10, dx20, area);
+    primitive->dvdx = pgl_plane_gradient(dv10, dv20, dy20, dy10, area);
+    primitive->dvdy = pgl_plane_gradient(dv20, dv10, dx10, dx20, area);
+    primitive->dwdx = pgl_plane_gradient(dw10, dw20, dy20, dy10, area);
+    primitive->dwdy = pgl_plane_gradient(dw20, dw10, dx10, dx20, area);
+}
+
+// REQUIREMENT: The spin lock must be held
+// Returns PGL_PRIMITIVE_NONE when the primitive pool is full
+static uint16_t pgl_push_primitive(const pgl_primitive_t* primitive)
+{
+    if (context.primitive_count == PGL_PRIMITIVE_COUNT)
+        return PGL_PRIMITIVE_NONE;
+
+    const uint32_t index = context.primitive_count++;
+    context.primitives[index] = *primitive;
+    return (uint16_t)index;
+}
+
+static void pgl_begin_primitive(const pgl_rast_vertex_t* vert0, const pgl_rast_vertex_t* vert1, const pgl_rast_vertex_t* vert2, int32_t area)
+{
+    const uint core = get_core_num();
+    pgl_setup_primitive(vert0, vert1, vert2, area, &context.candidates[core]);
+
+#if defined(PGL_DEFERRED_TEXTURING)
+    const uint32_t saved_irq = spin_lock_blocking(context.spin_lock);
+    PGL_STATS_ADD(lock_acquisitions, 1);
+    context.active_primitives[core] = pgl_push_primitive(&context.candidates[core]);
+    spin_unlock(context.spin_lock, saved_irq);
+#else
+    // The primitive is pushed lazily when it turns out to be visible
+    context.active_primitives[core] = PGL_PRIMITIVE_NONE;
+#endif
+}
+
+static void pgl_resolve_span(colour_t* colours, const pgl_primitive_t* primitive, int32_t left, int32_t right, int32_t y)
+{
+    const int32_t dx = left - primitive->x;
+    const int32_t dy = y - primitive->y;
+
+    Q_TYPE u = pgl_plane_evaluate(primitive->u, primitive->dudx, primitive->dudy, dx, dy);
+    Q_TYPE v = pgl_plane_evaluate(primitive->v, primitive->dvdx, primitive->dvdy, dx, dy);
+    Q_TYPE w = pgl_plane_evaluate(primitive->w, primitive->dwdx, primitive->dwdy, dx, dy);
+
+    if (left == right)
+    {
+        const Q_TYPE inv_w = q_reciprocal(w);
+        colours[left] = pgl_fragment_shader(q_mul(u, inv_w), q_mul(v, inv_w));
+        return;
+    }
+
+    Q_TYPE inv_w = q_reciprocal(w);
+    Q_TYPE tex_u = q_mul(u, inv_w);
+    Q_TYPE tex_v = q_mul(v, inv_w);
+
+    for (int32_t x = left; x <= right; x += PGL_AFFINE_SPAN_LENGTH)
+    {
+        const int32_t count = SMALLER(right - x + 1, PGL_AFFINE_SPAN_LENGTH);
+
+        u = q_add(u, q_mul_int(primitive->dudx, count));
+        v = q_add(v, q_mul_int(primitive->dvdx, count));
+        w = q_add(w, q_mul_int(primitive->dwdx, count));
+
+        inv_w = q_reciprocal(w);
+        const Q_TYPE next_tex_u = q_mul(u, inv_w);
+        const Q_TYPE next_tex_v = q_mul(v, inv_w);
+
+        pgl_texture_affine_span(tex_u, tex_v, next_tex_u, next_tex_v, &colours[x], count);
+
+        tex_u = next_tex_u;
+        tex_v = next_tex_v;
+    }
+}
+
+#endif // PGL_PRIMITIVE_PLANES
+
+// ------------------------------------- DEFERRED ------------------------------------- //
+
+#if defined(PGL_DEFERRED_TEXTURING)
+
+// Textures every pixel that holds a primitive id, exactly once
+static void pgl_resolve_internal(uint32_t start_row, uint32_t row_stride)
+{
+    for (uint32_t y = start_row; y < SCREEN_HEIGHT; y += row_stride)
+    {
+        colour_t* colours = context.draw_image->colours[y];
+
+        for (uint32_t word = 0; word < PGL_DEFERRED_MASK_WORDS; ++word)
+        {
+            uint32_t bits = context.deferred_mask[y][word];
+            context.deferred_mask[y][word] = 0;
+
+            while (bits != 0)
+            {
+                uint32_t bit = __builtin_ctz(bits);
+                CLEAR_BIT(bits, bit);
+
+                // Extend the run while the following pixels hold the same primitive
+                const int32_t left = (word << 5) + bit;
+                const uint16_t id = colours[left];
+                while (bit < 31 && CHECK_BIT(bits, bit + 1) && colours[(word << 5) + bit + 1] == id)
+                    CLEAR_BIT(bits, ++bit);
+                const int32_t right = (word << 5) + bit;
+
+                const pgl_primitive_t* primitive = &context.primitives[id];
+                PGL_DEBUG_TIME_BEGIN();
+                pgl_bind_texture_level(&primitive->level);
+                pgl_resolve_span(colours, primitive, left, right, y);
+                PGL_DEBUG_TIME_END(y, left, right);
+            }
+        }
+    }
+}
+
+#endif // PGL_DEFERRED_TEXTURING
+
+// ------------------------------------- SPAN BUFFER ------------------------------------- //
+
+#if defined(PGL_SPAN_BUFFER)
+
+static inline uint32_t pgl_span_available()
+{
+    return (PGL_SPAN_COUNT - context.span_count) + context.span_free_count;
+}
+
+// REQUIREMENT: pgl_span_available() must be non-zero
+static uint16_t pgl_span_allocate(int32_t left, int32_t right, uint16_t primitive, uint16_t next)
+{
+    uint16_t index;
+    if (context.span_free != PGL_SPAN_NONE)
+    {
+        index = context.span_free;
+        context.span_free = context.spans[index].next;
+        --context.span_free_count;
+    }
+    else
+    {
+        index = (uint16_t)context.span_count++;
+    }
+
+    context.spans[index] = (pgl_span_t){
+        .left = (int16_t)left,
+        .right = (int16_t)right,
+        .primitive = primitive,
+        .next = next,
+    };
+    return index;
+}
+
+static void pgl_span_release(uint16_t index)
+{
+    context.spans[index].next = context.span_free;
+    context.span_free = index;
+    ++context.span_free_count;
+}
+
+// Links [left, right] of the primitive at *link, or extends the previous span when they are adjacent.
+// Returns the span that ends at right.
+static pgl_span_t* pgl_span_emit(uint16_t* link, pgl_span_t* prev, int32_t left, int32_t right, uint16_t primitive)
+{
+    if (prev != NULL && prev->primitive == primitive && prev->right + 1 == left)
+    {
+        prev->right = (int16_t)right;
+        return prev;
+    }
+
+    *link = pgl_span_allocate(left, right, primitive, *link);
+    return &context.spans[*link];
+}
+
+static void pgl_span_reset()
+{
+    for (uint32_t y = 0; y < SCREEN_HEIGHT; ++y)
+        context.span_heads[y] = PGL_SPAN_NONE;
+
+    context.span_free = PGL_SPAN_NONE;
+    context.span_free_count = 0;
+    context.span_count = 0;
+    context.primitive_count = 0;
+}
+
+// Textures [left, right] of the primitive right away, for the visible gaps the full pools cannot take
+static void pgl_span_texture_now(const pgl_primitive_t* primitive, int32_t left, int32_t right, int32_t y)
+{
+#if defined(PGL_DEBUG_VIEWS)
+    if (pgl_debug_view_counts())
+        return;
+#endif
+
+    pgl_bind_texture_level(&primitive->level);
+    pgl_resolve_span(context.draw_image->colours[y], primitive, left, right, y);
+}
+
+// REQUIREMENT: The spin lock must be held
+// Inserts the parts of [left, right] where the active primitive of the core is nearer than the spans
+// in the scanline. Since 1/w is linear in screen space, the depths of two primitives cross at most once.
+static void pgl_span_insert(int32_t y, int32_t left, int32_t right)
+{
+    const uint core = get_core_num();
+    const pgl_primitive_t* candidate = &context.candidates[core];
+
+    uint16_t* link = &context.span_heads[y];
+    pgl_span_t* prev = NULL;
+    int32_t x = left;
+
+    while (x <= right)
+    {
+        pgl_span_t* span = (*link != PGL_SPAN_NONE) ? &context.spans[*link] : NULL;
+        if (span != NULL && span->right < x)
+        {
+            prev = span;
+            link = &span->next;
+            continue;
+        }
+
+        // Visible part [visible_left, visible_right] of [x, end]
+        int32_t end, visible_left, visible_right;
+
+        if (span == NULL || span->left > x)
+        {
+            end = (span == NULL) ? right : SMALLER(right, span->left - 1);
+            visible_left  = x;
+            visible_right = end;
+            span = NULL;
+        }
+        else
+        {
+            end = SMALLER(right, span->right);
+
+            const pgl_primitive_t* other = &context.primitives[span->primitive];
+            const Q_TYPE diff_left  = q_sub(pgl_primitive_inv_depth(candidate, x, y),   pgl_primitive_inv_depth(other, x, y));
+            const Q_TYPE diff_right = q_sub(pgl_primitive_inv_depth(candidate, end, y), pgl_primitive_inv_depth(other, end, y));
+
+            // Depth Test -> LESS, so the primitive must have a greater 1/w to be visible
+            const bool visible_at_left  = q_gt(diff_left,  Q_ZERO);
+            const bool visible_at_right = q_gt(diff_right, Q_ZERO);
+
+            if (!visible_at_left && !visible_at_right)
+            {
+                x = end + 1;
+                prev = span;
+                link = &span->next;
+                continue;
+            }
+
+            const int64_t length = end - x;
+            if (visible_at_left && visible_at_right)
+            {
+                visible_left  = x;
+                visible_right = end;
+            }
+            else if (visible_at_left)
+            {
+                const int64_t slope = (int64_t)diff_left - diff_right;
+                visible_left  = x;
+                visible_right = x + (int32_t)((diff_left * length + slope - 1) / slope) - 1;
+            }
+            else
+            {
+                const int64_t slope = (int64_t)diff_right - diff_left;
+                visible_left  = x + (int32_t)((-(int64_t)diff_left * length) / slope) + 1;
+                visible_right = end;
+            }
+        }
+
+        // A gap or a side of a span takes a new span, the middle of a span two and a whole span none
+        const uint32_t needed_spans = (span == NULL) ? 1 : (uint32_t)(visible_left > span->left) + (uint32_t)(visible_right < span->right);
+        if (context.active_primitives[core] == PGL_PRIMITIVE_NONE && pgl_span_available() >= needed_spans)
+            context.active_primitives[core] = pgl_push_primitive(candidate);
+
+        if (pgl_span_available() < needed_spans || context.active_primitives[core] == PGL_PRIMITIVE_NONE)
+        {
+            // The pools are full. A gap is textured at once, so that the frame has no hole, but the spans inserted into
+            // it later are drawn over it whatever their depth. A span keeps its primitive where it was hidden.
+            PGL_STATS_ADD(fragments_overflowed, visible_right - visible_left + 1);
+            if (span == NULL)
+                pgl_span_texture_now(candidate, visible_left, visible_right, y);
+            else
+            {
+                prev = span;
+                link = &span->next;
+            }
+            x = end + 1;
+            continue;
+        }
+        const uint16_t primitive = context.active_primitives[core];
+        PGL_STATS_ADD(fragments_passed, visible_right - visible_left + 1);
+#if defined(PGL_DEBUG_VIEWS)
+        // pgl_debug_count_scanline counted every pixel as hidden
+        if (context.debug_view == PGL_DEBUG_VIEW_DEPTH_REJECTS)
+            pgl_debug_count(context.draw_image->colours[y], visible_left, visible_right, -1);
+#endif
+
+        if (span == NULL)
+        {
+            prev = pgl_span_emit(link, prev, visible_left, visible_right, primitive);
+            link = &prev->next;
+        }
+        else if (visible_left > span->left)
+        {
+            // Keep the left part of the span, then the primitive, then the right part of the span
+            const int32_t span_right = span->right;
+            span->right = (int16_t)(visible_left - 1);
+
+            prev = pgl_span_emit(&span->next, span, visible_left, visible_right, primitive);
+            link = &prev->next;
+
+            if (visible_right < span_right)
+            {
+                prev = pgl_span_emit(link, prev, visible_right + 1, span_right, span->primitive);
+                link = &prev->next;
+            }
+        }
+        else if (visible_right < span->right)
+        {
+            // The primitive hides the left part of the span
+            span->left = (int16_t)(visible_right + 1);
+            pgl_span_emit(link, prev, visible_left, visible_right, primitive);
+
+            prev = span;
+            link = &span->next;
+        }
+        else if (prev != NULL && prev->primitive == primitive && prev->right + 1 == visible_left)
+        {
+            // The primitive hides the whole span and continues the previous span
+            prev->right = (int16_t)visible_right;
+            const uint16_t index = *link;
+            *link = span->next;
+            pgl_span_release(index);
+        }
+        else
+        {
+            // The primitive hides the whole span
+            span->primitive = primitive;
+            prev = span;
+            link = &span->next;
         }
-        
-        if (curr_inside)
-            out->verts[out->count++] = *curr;
+
+        x = end + 1;
     }
 }
 
-static uint32_t pgl_clip(const pgl_clip_triangle_t* restrict clip_triangle, pgl_clip_triangle_t* restrict triangle_out)
+// Textures the visible spans of every row, each pixel exactly once
+static void pgl_resolve_internal(uint32_t start_row, uint32_t row_stride)
 {
-    static const pgl_clip_plane_t planes[] = {
-        {{ Q_ZERO,  Q_ZERO,   Q_ONE, Q_ONE}}, // Near     : +Z + W > 0.0
-        {{  Q_ONE,  Q_ZERO,  Q_ZERO, Q_ONE}}, // Left     : +X + W > 0.0
-        {{Q_M_ONE,  Q_ZERO,  Q_ZERO, Q_ONE}}, // Right    : -X + W > 0.0
-        {{ Q_ZERO,   Q_ONE,  Q_ZERO, Q_ONE}}, // Bottom   : +Y + W > 0.0
-        {{ Q_ZERO, Q_M_ONE,  Q_ZERO, Q_ONE}}, // Top      : -Y + W > 0.0
-        {{ Q_ZERO,  Q_ZERO, Q_M_ONE, Q_ONE}}, // Far      : -Z + W > 0.0
-    };
-
-    pgl_clip_poly_t poly0;
-    pgl_clip_poly_t poly1;
-    poly0.verts[0] = clip_triangle->verts[0];
-    poly0.verts[1] = clip_triangle->verts[1];
-    poly0.verts[2] = clip_triangle->verts[2];
-    poly0.count = 3;
-
-    pgl_clip_poly_t* poly_in  = &poly0;
-    pgl_clip_poly_t* poly_out = &poly1;
+#if defined(PGL_DEBUG_VIEWS)
+    if (pgl_debug_view_counts())
+        return;
+#endif
 
-    for (uint32_t i = 0; i < COUNT_OF(planes) && poly_in->count > 0; ++i)
+    for (uint32_t y = start_row; y < SCREEN_HEIGHT; y += row_stride)
     {
-        pgl_clip_poly_plane(poly_in, &planes[i], poly_out);
-        SWAP(&poly_in, &poly_out);
-    }
+        colour_t* colours = context.draw_image->colours[y];
 
-    uint32_t triangle_count = 0;
-    for (uint32_t i = 1; i + 1 < poly_in->count; ++i)
-    {
-        triangle_out[triangle_count++] = (pgl_clip_triangle_t){
-            poly_in->verts[0], 
-            poly_in->verts[i], 
-            poly_in->verts[i + 1],
-        };
+        for (uint16_t index = context.span_heads[y]; index != PGL_SPAN_NONE; index = context.spans[index].next)
+        {
+            const pgl_span_t* span = &context.spans[index];
+            const pgl_primitive_t* primitive = &context.primitives[span->primitive];
+            PGL_DEBUG_TIME_BEGIN();
+            pgl_bind_texture_level(&primitive->level);
+            pgl_resolve_span(colours, primitive, span->left, span->right, (int32_t)y);
+            PGL_DEBUG_TIME_END((int32_t)y, span->left, span->right);
+        }
     }
-    return triangle_count;
 }
 
-// ------------------------------------- TESTS ------------------------------------- //
+#endif // PGL_SPAN_BUFFER
 
-static inline depth_t pgl_depth_map(Q_TYPE q_depth)
+// ------------------------------------- RASTERISER ------------------------------------- //
+
+#if !defined(PGL_SPAN_BUFFER)
+// interp1 of each core steps 1/w on lane 0 and the depth-buffer address on lane 1 along a scanline
+static void pgl_init_scanline_interp()
 {
-    const Q_TYPE ratio = q_div(q_sub(q_depth, context.near), q_sub(context.far, context.near));
-    const depth_t depth = Q_TO_INT(q_add(q_mul_int(ratio, DEPTH_RANGE), Q_FROM_INT(DEPTH_NEAREST)));
-    return depth;
+    interp_config cfg0 = interp_default_config();
+    interp_config_set_add_raw(&cfg0, true);
+    // Shifting bit 31 out and masking only bit 31 keeps 1/w out of the full result
+    interp_config_set_shift(&cfg0, 31);
+    interp_config_set_mask(&cfg0, 31, 31);
+    interp_set_config(interp1, 0, &cfg0);
+
+    interp_config cfg1 = interp_default_config();
+    interp_config_set_add_raw(&cfg1, true);
+    interp_set_config(interp1, 1, &cfg1);
+
+    interp_set_base(interp1, 1, sizeof(depth_t));
 }
 
-static inline bool pgl_depth_test_passed(int32_t x, int32_t y, depth_t depth)
+static inline void pgl_begin_scanline_interp(Q_TYPE w, Q_TYPE sw, int32_t x, int32_t y)
 {
-    // Depth Test -> LESS
-    const depth_t depth_in_buffer = context.depths[y][x];
-    return (depth < depth_in_buffer);
+    interp_set_accumulator(interp1, 0, w);
+    interp_set_base(interp1, 0, sw);
+    interp_set_accumulator(interp1, 1, x * sizeof(depth_t));
+    interp_set_base(interp1, 2, (uintptr_t)context.depths[y]);
 }
 
-static inline bool pgl_face_is_culled(Q_VEC2 v0_xy_ndc, Q_VEC2 v1_xy_ndc, Q_VEC2 v2_xy_ndc)
+static inline Q_TYPE pgl_scanline_interp_w()
 {
-    // Front Face -> CCW and Cull Face -> BACK
-    const Q_VEC2 edge01 = q_vec2_sub(v1_xy_ndc, v0_xy_ndc);
-    const Q_VEC2 edge02 = q_vec2_sub(v2_xy_ndc, v0_xy_ndc);
-    const Q_TYPE area   = q_vec2_cross(edge01, edge02);
-    return (area < Q_ZERO);
+    return (Q_TYPE)interp_get_accumulator(interp1, 0);
 }
 
-// ------------------------------------- TEXTURE ------------------------------------- //
-
-// REQUIREMENT: u and v must be non-negative
-static colour_t pgl_sample_texture(Q_TYPE u, Q_TYPE v) 
+// Returns the depth-buffer address of the current pixel and advances both 1/w and the address to the next one
+static inline depth_t* pgl_scanline_interp_pop()
 {
-    interp0->accum[0] = u;
-    interp0->accum[1] = v;
-
-    // equivalent to
-    // uint32_t x = (accum0 >> (Q_FRAC_BITS - width_bits))  & ((1 << width_bits)  - 1);
-    // uint32_t y = (accum1 >> (Q_FRAC_BITS - height_bits)) & ((1 << height_bits) - 1);
-    // const colour_t* *address = texture + ((x + (y << width_bits)) << bpp_shift);
-    // return *address;
-
-    return *(const colour_t*)interp0->pop[2];
+    return (depth_t*)interp_pop_full_result(interp1);
 }
+#endif
 
-// REQUIREMENT:  u and  v must be non-negative
-// REQUIREMENT: su and sv must be non-negative
-static void pgl_multisample_texture(Q_TYPE u, Q_TYPE v, Q_TYPE su, Q_TYPE sv, colour_t *output, uint32_t count) 
+#if defined(PGL_DEBUG_VIEWS)
+// Counts the depth tests of the scanline, or only the failed ones, in the colour buffer without texturing it
+static void pgl_debug_count_scanline(Q_TYPE left_x, Q_TYPE right_x, Q_TYPE left_w, Q_TYPE right_w, int32_t y)
 {
-    interp0->accum[0] = u;
-    interp0->base[0] = su;
-    interp0->accum[1] = v;
-    interp0->base[1] = sv;
+    const int32_t left  = Q_TO_INT(left_x);
+    const int32_t right = Q_TO_INT(right_x);
+    colour_t* const colours = context.draw_image->colours[y];
+    PGL_STATS_ADD(fragments_tested, right - left + 1);
+
+#if defined(PGL_SPAN_BUFFER)
+    // Every pixel counts as hidden, pgl_span_insert takes the visible ones back for PGL_DEBUG_VIEW_DEPTH_REJECTS
+    UNUSED(left_w); UNUSED(right_w);
+
+    const uint32_t saved_irq = spin_lock_blocking(context.spin_lock);
+    PGL_STATS_ADD(lock_acquisitions, 1);
+    pgl_debug_count(colours, left, right, 1);
+    pgl_span_insert(y, left, right);
+    spin_unlock(context.spin_lock, saved_irq);
+#else
+    const Q_TYPE x_diff = (q_ne(left_x, right_x)) ? q_sub(right_x, left_x) : Q_MAX;
+    const Q_TYPE sw = q_div(q_sub(right_w, left_w), x_diff);
+    const bool count_passed = (context.debug_view == PGL_DEBUG_VIEW_OVERDRAW);
 
-    for (uint32_t i = 0; i < count; ++i) 
+    pgl_begin_scanline_interp(left_w, sw, left, y);
+
+    for (int32_t x = left; x <= right; ++x)
     {
-        // equivalent to
-        // uint32_t x = (accum0 >> (Q_FRAC_BITS - width_bits))  & ((1 << width_bits)  - 1);
-        // uint32_t y = (accum1 >> (Q_FRAC_BITS - height_bits)) & ((1 << height_bits) - 1);
-        // const colour_t* *address = texture + ((x + (y << width_bits)) << bpp_shift);
-        // output[i] = *address;
-        // accum0 = su + accum0;
-        // accum1 = sv + accum1;
+        const depth_t depth = pgl_depth_map(q_reciprocal(pgl_scanline_interp_w()));
+        depth_t* const depth_in_buffer = pgl_scanline_interp_pop();
 
-        // popping the result advances to the next iteration
-        output[i] = *(const colour_t*)interp0->pop[2];
+        const uint32_t saved_irq = spin_lock_blocking(context.spin_lock);
+        PGL_STATS_ADD(lock_acquisitions, 1);
+        const bool passed = pgl_depth_test_passed(depth_in_buffer, depth);
+        if (passed)
+        {
+            PGL_STATS_ADD(fragments_passed, 1);
+            *depth_in_buffer = depth;
+        }
+        if (!passed || count_passed)
+            pgl_debug_count(colours, x, x, 1);
+        spin_unlock(context.spin_lock, saved_irq);
     }
+#endif
 }
-
-// ------------------------------------- SHADERS ------------------------------------- //
-
-static pgl_clip_vertex_t pgl_vertex_shader(pgl_vertex_t vertex)
-{
-    const Q_VEC4 point = q_homogeneous_point(vertex.position);
-    const Q_VEC4 pos_out = q_mat4_mul_vec4(context.projection, q_mat4_mul_vec4(context.view, q_mat4_mul_vec4(context.model, point)));
-
-    const pgl_clip_vertex_t clip_vertex = {
-        .position = pos_out,
-        .tex_coord = vertex.tex_coord,
-    };
-    return clip_vertex;
-}
-
-static inline colour_t pgl_fragment_shader(Q_TYPE u, Q_TYPE v)
-{
-    return pgl_sample_texture(u, v);
-}
-
-// ------------------------------------- RASTERISER ------------------------------------- //
+#endif
 
 static void pgl_rasterise_scanline(
     Q_TYPE left_x, Q_TYPE right_x,
@@ -248,9 +1370,29 @@ static void pgl_rasterise_scanline(
     Q_TYPE left_w, Q_TYPE right_w,
     int32_t y)
 {
+#if defined(PGL_DEBUG_VIEWS)
+    if (pgl_debug_view_counts())
+    {
+        pgl_debug_count_scanline(left_x, right_x, left_w, right_w, y);
+        return;
+    }
+#endif
+    PGL_DEBUG_TIME_BEGIN();
+
+#if defined(PGL_SPAN_BUFFER)
+    // Occlusion is resolved per span and texturing is postponed to the resolve pass
+    UNUSED(left_u); UNUSED(right_u);
+    UNUSED(left_v); UNUSED(right_v);
+    UNUSED(left_w); UNUSED(right_w);
+    PGL_STATS_ADD(fragments_tested, Q_TO_INT(right_x) - Q_TO_INT(left_x) + 1);
+
+    const uint32_t saved_irq = spin_lock_blocking(context.spin_lock);
+    PGL_STATS_ADD(lock_acquisitions, 1);
+    pgl_span_insert(y, Q_TO_INT(left_x), Q_TO_INT(right_x));
+    spin_unlock(context.spin_lock, saved_irq);
+#else
     Q_TYPE u = left_u;
     Q_TYPE v = left_v;
-    Q_TYPE w = left_w;
 
     const Q_TYPE x_diff = (q_ne(left_x, right_x)) ? q_sub(right_x, left_x) : Q_MAX;
 
@@ -260,27 +1402,92 @@ static void pgl_rasterise_scanline(
 
     const int32_t left  = Q_TO_INT(left_x);
     const int32_t right = Q_TO_INT(right_x);
+    PGL_STATS_ADD(fragments_tested, right - left + 1);
+
+    pgl_begin_scanline_interp(left_w, sw, left, y);
+
+#if defined(PGL_DEFERRED_TEXTURING)
+    const uint16_t primitive = context.active_primitives[get_core_num()];
 
     for (int32_t x = left; x <= right; ++x)
     {
-        const Q_TYPE inv_w = q_div(Q_ONE, w);
+        const Q_TYPE inv_w = q_reciprocal(pgl_scanline_interp_w());
         const depth_t depth = pgl_depth_map(inv_w);
+        depth_t* const depth_in_buffer = pgl_scanline_interp_pop();
 
         const uint32_t saved_irq = spin_lock_blocking(context.spin_lock);
-		if (pgl_depth_test_passed(x, y, depth))
+        PGL_STATS_ADD(lock_acquisitions, 1);
+		if (pgl_depth_test_passed(depth_in_buffer, depth))
         {
-            const colour_t colour = pgl_fragment_shader(
-                q_mul(u, inv_w), q_mul(v, inv_w));
-
-            context.draw_image->colours[y][x] = colour;
-            context.depths[y][x] = depth;
+            PGL_STATS_ADD(fragments_passed, 1);
+
+            // Store the primitive id and postpone texturing to the resolve pass
+            if (primitive != PGL_PRIMITIVE_NONE)
+            {
+                context.draw_image->colours[y][x] = primitive;
+                SET_BIT(context.deferred_mask[y][x >> 5], x & 31);
+            }
+            else
+            {
+                context.draw_image->colours[y][x] = pgl_fragment_shader(
+                    q_mul(u, inv_w), q_mul(v, inv_w));
+                CLEAR_BIT(context.deferred_mask[y][x >> 5], x & 31);
+            }
+            *depth_in_buffer = depth;
 		}
         spin_unlock(context.spin_lock, saved_irq);
 
         u = q_add(u, su);
         v = q_add(v, sv);
-        w = q_add(w, sw);
 	}
+#else
+    colour_t colours[PGL_AFFINE_SPAN_LENGTH];
+    colour_t* colour_in_buffer = &context.draw_image->colours[y][left];
+
+    Q_TYPE inv_w = q_reciprocal(left_w);
+    Q_TYPE tex_u = q_mul(u, inv_w);
+    Q_TYPE tex_v = q_mul(v, inv_w);
+
+    for (int32_t x = left; x <= right; x += PGL_AFFINE_SPAN_LENGTH)
+    {
+        const int32_t count = SMALLER(right - x + 1, PGL_AFFINE_SPAN_LENGTH);
+
+        // Texture the whole sub-span at once, some of its pixels may fail the depth test
+        u = q_add(u, q_mul_int(su, count));
+        v = q_add(v, q_mul_int(sv, count));
+        const Q_TYPE next_inv_w = q_reciprocal(q_add(pgl_scanline_interp_w(), q_mul_int(sw, count)));
+        const Q_TYPE next_tex_u = q_mul(u, next_inv_w);
+        const Q_TYPE next_tex_v = q_mul(v, next_inv_w);
+
+        pgl_texture_affine_span(tex_u, tex_v, next_tex_u, next_tex_v, colours, count);
+
+        for (int32_t i = 0; i < count; ++i)
+        {
+            const depth_t depth = pgl_depth_map(inv_w);
+            depth_t* const depth_in_buffer = pgl_scanline_interp_pop();
+
+            const uint32_t saved_irq = spin_lock_blocking(context.spin_lock);
+            PGL_STATS_ADD(lock_acquisitions, 1);
+            if (pgl_depth_test_passed(depth_in_buffer, depth))
+            {
+                PGL_STATS_ADD(fragments_passed, 1);
+                colour_in_buffer[i] = colours[i];
+                *depth_in_buffer = depth;
+            }
+            spin_unlock(context.spin_lock, saved_irq);
+
+            inv_w = (i + 1 < count) ? q_reciprocal(pgl_scanline_interp_w()) : next_inv_w;
+        }
+
+        colour_in_buffer += count;
+
+        tex_u = next_tex_u;
+        tex_v = next_tex_v;
+    }
+#endif
+#endif
+
+    PGL_DEBUG_TIME_END(y, Q_TO_INT(left_x), Q_TO_INT(right_x));
 }
 
 static void pgl_rasterise_filled_triangle(pgl_rast_vertex_t vert0, pgl_rast_vertex_t vert1, pgl_rast_vertex_t vert2)
@@ -297,7 +1504,7 @@ static void pgl_rasterise_filled_triangle(pgl_rast_vertex_t vert0, pgl_rast_vert
     const Q_TYPE dv20 = q_sub(vert2.v, vert0.v);
     const Q_TYPE dw20 = q_sub(vert2.inv_depth, vert0.inv_depth);
 
-    const Q_TYPE inv_dy20 = q_div(Q_ONE, dy20);
+    const Q_TYPE inv_dy20 = q_reciprocal(dy20);
     const Q_TYPE sx20 = q_mul(dx20, inv_dy20);
     const Q_TYPE su20 = q_mul(du20, inv_dy20);
     const Q_TYPE sv20 = q_mul(dv20, inv_dy20);
@@ -311,7 +1518,7 @@ static void pgl_rasterise_filled_triangle(pgl_rast_vertex_t vert0, pgl_rast_vert
         const Q_TYPE dv10 = q_sub(vert1.v, vert0.v);
         const Q_TYPE dw10 = q_sub(vert1.inv_depth, vert0.inv_depth);
 
-        const Q_TYPE inv_dy10 = q_div(Q_ONE, dy10);
+        const Q_TYPE inv_dy10 = q_reciprocal(dy10);
         const Q_TYPE sx10 = q_mul(dx10, inv_dy10);
         const Q_TYPE su10 = q_mul(du10, inv_dy10);
         const Q_TYPE sv10 = q_mul(dv10, inv_dy10);
@@ -376,7 +1583,7 @@ static void pgl_rasterise_filled_triangle(pgl_rast_vertex_t vert0, pgl_rast_vert
         const Q_TYPE dv21 = q_sub(vert2.v, vert1.v);
         const Q_TYPE dw21 = q_sub(vert2.inv_depth, vert1.inv_depth);
 
-        const Q_TYPE inv_dy21 = q_div(Q_ONE, dy21);
+        const Q_TYPE inv_dy21 = q_reciprocal(dy21);
         const Q_TYPE sx21 = q_mul(dx21, inv_dy21);
         const Q_TYPE su21 = q_mul(du21, inv_dy21);
         const Q_TYPE sv21 = q_mul(dv21, inv_dy21);
@@ -438,33 +1645,65 @@ static void pgl_rasterise_filled_triangle(pgl_rast_vertex_t vert0, pgl_rast_vert
 
 void pgl_model(Q_VEC3 position, Q_QUAT rotation, Q_VEC3 scale)
 {
+#if defined(PGL_CAPTURE)
+    pgl_capture_model(position, rotation, scale);
+#endif
     context.model = Q_MAT4_IDENTITY;            // M = I
     q_translate_3d(&context.model, position);   // M = I * T
     q_rotate_3d_quat(&context.model, rotation); // M = I * T * R
     q_scale_3d(&context.model, scale);          // M = I * T * R * S
+
+    context.model_position = position;
+    context.model_rotation = rotation;
+    context.model_scale = scale;
 }
 
 void pgl_view(Q_VEC3 eye, Q_VEC3 backward, Q_VEC3 up)
 {
+#if defined(PGL_CAPTURE)
+    pgl_capture_view(eye, backward, up);
+#endif
     context.view = q_view(eye, backward, up);
+    context.eye = eye;
 }
 
 #define ASPECT_RATIO (Q_FROM_FLOAT((float)SCREEN_WIDTH / (float)SCREEN_HEIGHT))
 
 void pgl_projection(Q_TYPE fovw, Q_TYPE near, Q_TYPE far)
 {
+#if defined(PGL_CAPTURE)
+    pgl_capture_projection(fovw, near, far);
+#endif
     context.projection = q_perspective(fovw, ASPECT_RATIO, near, far);
     context.near = near;
     context.far  = far;
+
+    // The right plane is P[0][0] * x + z = 0 in the view space, the top one P[1][1] * y + z = 0
+    const Q_VEC4 unit_x = q_mat4_mul_vec4(context.projection, (Q_VEC4){{Q_ONE, Q_ZERO, Q_ZERO, Q_ZERO}});
+    const Q_VEC4 unit_y = q_mat4_mul_vec4(context.projection, (Q_VEC4){{Q_ZERO, Q_ONE, Q_ZERO, Q_ZERO}});
+    context.frustum_x_norm = q_vec3_length((Q_VEC3){{unit_x.x, Q_ZERO, Q_ONE}});
+    context.frustum_y_norm = q_vec3_length((Q_VEC3){{Q_ZERO, unit_y.y, Q_ONE}});
 }
 
 void pgl_viewport(int32_t x, int32_t y, uint32_t width, uint32_t height)
 {
+#if defined(PGL_CAPTURE)
+    pgl_capture_viewport(x, y, width, height);
+#endif
     context.viewport = q_viewport(x, y, width, height);
 }
 
 void pgl_clear_colours(colour_t colour)
 {
+#if defined(PGL_CAPTURE)
+    pgl_capture_clear_colours(colour);
+#endif
+    TRACE_BEGIN(TRACE_ZONE_CLEAR_COLOURS);
+#if defined(PGL_DEBUG_VIEWS)
+    pgl_debug_begin_frame();
+    if (pgl_debug_view_counts())
+        colour = 0;
+#endif
 #if defined(RGB332)
     const uint32_t value = (colour << 24) | (colour << 16) | (colour << 8) | colour;
     const uint32_t count = (SCREEN_HEIGHT * SCREEN_WIDTH) / 4;
@@ -477,10 +1716,28 @@ void pgl_clear_colours(colour_t colour)
     #pragma GCC unroll 16
     for (uint32_t i = 0; i < count; ++i)
         buffer[i] = value;
+
+#if defined(PGL_DEFERRED_TEXTURING)
+    uint32_t* mask = (uint32_t*)context.deferred_mask;
+    for (uint32_t i = 0; i < SCREEN_HEIGHT * PGL_DEFERRED_MASK_WORDS; ++i)
+        mask[i] = 0;
+
+    context.primitive_count = 0;
+#endif
+    TRACE_END(TRACE_ZONE_CLEAR_COLOURS);
 }
 
 void pgl_clear_depths(depth_t depth)
 {
+#if defined(PGL_CAPTURE)
+    pgl_capture_clear_depths(depth);
+#endif
+    TRACE_BEGIN(TRACE_ZONE_CLEAR_DEPTHS);
+#if defined(PGL_SPAN_BUFFER)
+    // The span buffer replaces the depth buffer
+    UNUSED(depth);
+    pgl_span_reset();
+#else
 #if defined(DEPTH_8BIT)
     const uint32_t value = (depth << 24) | (depth << 16) | (depth << 8) | depth;
     const uint32_t count = (SCREEN_HEIGHT * SCREEN_WIDTH) / 4;
@@ -493,146 +1750,259 @@ void pgl_clear_depths(depth_t depth)
     #pragma GCC unroll 16
     for (uint32_t i = 0; i < count; ++i)
         buffer[i] = value;
+#endif
+    TRACE_END(TRACE_ZONE_CLEAR_DEPTHS);
 }
 
 bool pgl_request_draw_image()
 {
     context.draw_image = swapchain_request_draw_image();
+#if defined(PGL_CAPTURE)
+    pgl_capture_request_draw_image(context.draw_image != NULL);
+#endif
     return (context.draw_image != NULL);
 }
 
-static void pgl_bind_texture_internal(const colour_t* texels, uint width_bits, uint height_bits)
+static bool pgl_texture_is_bound(const pgl_texture_t* texture)
 {
-#if defined(RGB332)
-    const uint bpp_shift = 0; // log2(1 byte)
-#elif defined(RGB565)
-    const uint bpp_shift = 1; // log2(2 bytes)
+    const pgl_texture_t* bound = &context.texture;
+    return (texture->texels == bound->texels) && (texture->mipmaps == bound->mipmaps) &&
+        (texture->palette == bound->palette) && (texture->width_bits == bound->width_bits) &&
+        (texture->height_bits == bound->height_bits) && (texture->level_count == bound->level_count) &&
+        (texture->format == bound->format) && (texture->layout == bound->layout);
+}
+
+void pgl_bind_texture(const pgl_texture_t* texture)
+{
+#if defined(PGL_CAPTURE)
+    pgl_capture_bind_texture(texture);
 #endif
+    if (pgl_texture_is_bound(texture))
+        return;
+    context.texture = *texture;
+    TRACE_BEGIN(TRACE_ZONE_BIND_TEXTURE);
 
-    interp_config cfg0 = interp_default_config();
-    interp_config_set_add_raw(&cfg0, true);
-    interp_config_set_shift(&cfg0, Q_FRAC_BITS - width_bits - bpp_shift);
-    interp_config_set_mask(&cfg0, bpp_shift, width_bits + bpp_shift - 1);
-    interp_set_config(interp0, 0, &cfg0);
+    const uint width_bits  = texture->width_bits;
+    const uint height_bits = texture->height_bits;
+    const uint bits_per_texel = pgl_texture_bits_per_texel(texture->format);
 
-    interp_config cfg1 = interp_default_config();
-    interp_config_set_add_raw(&cfg1, true);
-    interp_config_set_shift(&cfg1, Q_FRAC_BITS - height_bits - width_bits - bpp_shift);
-    interp_config_set_mask(&cfg1, width_bits + bpp_shift, width_bits + height_bits + bpp_shift - 1);
-    interp_set_config(interp0, 1, &cfg1);
+    // INDEX4 rows must fill at least a byte
+    const uint min_width_bits = (texture->format == PGL_TEXTURE_FORMAT_INDEX4) ? 1 : 0;
 
-    interp0->base[2] = (uintptr_t)texels;
-}
+    uint level_count = (texture->mipmaps != NULL) ? texture->level_count : 1;
+    level_count = SMALLER(level_count, SMALLER(width_bits - min_width_bits, height_bits) + 1);
+    level_count = CLAMP(level_count, 1, PGL_TEXTURE_MAX_LEVELS);
 
-void pgl_bind_texture(const colour_t* texels, uint width_bits, uint height_bits)
-{
-    multicore_fifo_push_blocking(CORE1_TEXTURE_CONFIG_COMMAND);
-    multicore_fifo_push_blocking((uint32_t)texels);
-    multicore_fifo_push_blocking((uint32_t)width_bits);
-    multicore_fifo_push_blocking((uint32_t)height_bits);
+    const uint8_t* mipmaps = texture->mipmaps;
+    for (uint i = 0; i < level_count; ++i)
+    {
+        const uint32_t level_bytes = ((1u << (width_bits + height_bits - 2 * i)) * bits_per_texel + 7) / 8;
+        // Morton textures only need the lanes to hold the texel coordinates
+        const int32_t level_offset_bits = (texture->layout == PGL_TEXTURE_LAYOUT_MORTON) ?
+            (int32_t)(GREATER(width_bits, height_bits) - i) :
+            (int32_t)(width_bits + height_bits - 2 * i) + pgl_texture_bpp_shift(texture->format);
+        const void* texels = (i == 0) ? texture->texels : mipmaps;
+#if defined(PGL_TEXTURE_CACHE_BYTES)
+        texels = pgl_texture_cache_request(texels, level_bytes);
+#endif
 
-    pgl_bind_texture_internal(texels, width_bits, height_bits);
+        context.levels[i] = (pgl_texture_level_t){
+            .texels = texels,
+            .palette = texture->palette,
+            .width_bits = (uint8_t)(width_bits - i),
+            .height_bits = (uint8_t)(height_bits - i),
+            .format = (uint8_t)texture->format,
+            .layout = (uint8_t)texture->layout,
+            .coord_shift = (uint8_t)GREATER(level_offset_bits - (int32_t)Q_FRAC_BITS, 0),
+        };
 
-    multicore_fifo_pop_blocking();
+        // Every level starts at a byte boundary
+        if (i > 0)
+            mipmaps += level_bytes;
+    }
+    context.level_count = level_count;
+
+    // Both cores are idle between draw calls, they bind a level before rasterising each triangle
+    for (uint core = 0; core < NUM_CORES; ++core)
+        context.bound_levels[core].texels = NULL;
+    TRACE_END(TRACE_ZONE_BIND_TEXTURE);
 }
 
-static void pgl_draw_internal(uint16_t start_index, uint16_t index_stride)
+static void pgl_draw_triangle(uint16_t index0, uint16_t index1, uint16_t index2)
 {
     pgl_clip_triangle_t clip_buffer[CLIP_BUFFER_SIZE];
-    for (uint16_t i = start_index; i < context.index_count; i += index_stride)
+    PGL_STATS_ADD(triangles_in, 1);
+    PGL_STATS_ADD(vertices_shaded, 3);
+
+    const pgl_clip_triangle_t clip_triangle = {{
+        pgl_vertex_shader(pgl_fetch_vertex(index0)),
+        pgl_vertex_shader(pgl_fetch_vertex(index1)),
+        pgl_vertex_shader(pgl_fetch_vertex(index2)),
+    }};
+    uint32_t triangle_count = pgl_clip(&clip_triangle, (pgl_clip_triangle_t*)clip_buffer);
+
+    while (triangle_count > 0)
     {
-        const pgl_clip_triangle_t clip_triangle = {{
-            pgl_vertex_shader(context.vertices[context.indices[i + 0]]),
-            pgl_vertex_shader(context.vertices[context.indices[i + 1]]),
-            pgl_vertex_shader(context.vertices[context.indices[i + 2]]),
-        }};
-        uint32_t triangle_count = pgl_clip(&clip_triangle, (pgl_clip_triangle_t*)clip_buffer);
+        const pgl_clip_triangle_t* subtriangle = &clip_buffer[--triangle_count];
+
+        const Q_TYPE inv_depth0 = q_reciprocal(subtriangle->verts[0].position.w);
+        const Q_TYPE inv_depth1 = q_reciprocal(subtriangle->verts[1].position.w);
+        const Q_TYPE inv_depth2 = q_reciprocal(subtriangle->verts[2].position.w);
+
+        const Q_VEC4 ndc0 = q_vec4_scale(subtriangle->verts[0].position, inv_depth0);
+        const Q_VEC4 ndc1 = q_vec4_scale(subtriangle->verts[1].position, inv_depth1);
+        const Q_VEC4 ndc2 = q_vec4_scale(subtriangle->verts[2].position, inv_depth2);
 
-        while (triangle_count > 0)
+        if (pgl_face_is_culled((Q_VEC2){{ndc0.x, ndc0.y}}, (Q_VEC2){{ndc1.x, ndc1.y}}, (Q_VEC2){{ndc2.x, ndc2.y}})) 
         {
-            const pgl_clip_triangle_t* subtriangle = &clip_buffer[--triangle_count];
+            PGL_STATS_ADD(triangles_culled, 1);
+            continue;
+        }
 
-            const Q_TYPE inv_depth0 = q_div(Q_ONE, subtriangle->verts[0].position.w);
-            const Q_TYPE inv_depth1 = q_div(Q_ONE, subtriangle->verts[1].position.w);
-            const Q_TYPE inv_depth2 = q_div(Q_ONE, subtriangle->verts[2].position.w);
+        const Q_VEC4 sc0 = q_mat4_mul_vec4(context.viewport, ndc0);
+        const Q_VEC4 sc1 = q_mat4_mul_vec4(context.viewport, ndc1);
+        const Q_VEC4 sc2 = q_mat4_mul_vec4(context.viewport, ndc2);
 
-            const Q_VEC4 ndc0 = q_vec4_scale(subtriangle->verts[0].position, inv_depth0);
-            const Q_VEC4 ndc1 = q_vec4_scale(subtriangle->verts[1].position, inv_depth1);
-            const Q_VEC4 ndc2 = q_vec4_scale(subtriangle->verts[2].position, inv_depth2);
+        const pgl_rast_vertex_t rast_vert0 = {
+            .x = CLAMP(Q_TO_INT(sc0.x), 0, SCREEN_WIDTH  - 1),
+            .y = CLAMP(Q_TO_INT(sc0.y), 0, SCREEN_HEIGHT - 1),
+            .u = q_mul(subtriangle->verts[0].tex_coord.u, inv_depth0),
+            .v = q_mul(subtriangle->verts[0].tex_coord.v, inv_depth0),
+            .inv_depth = inv_depth0,
+        };
 
-            if (pgl_face_is_culled((Q_VEC2){{ndc0.x, ndc0.y}}, (Q_VEC2){{ndc1.x, ndc1.y}}, (Q_VEC2){{ndc2.x, ndc2.y}})) 
-                continue;
+        const pgl_rast_vertex_t rast_vert1 = {
+            .x = CLAMP(Q_TO_INT(sc1.x), 0, SCREEN_WIDTH  - 1),
+            .y = CLAMP(Q_TO_INT(sc1.y), 0, SCREEN_HEIGHT - 1),
+            .u = q_mul(subtriangle->verts[1].tex_coord.u, inv_depth1),
+            .v = q_mul(subtriangle->verts[1].tex_coord.v, inv_depth1),
+            .inv_depth = inv_depth1,
+        };
 
-            const Q_VEC4 sc0 = q_mat4_mul_vec4(context.viewport, ndc0);
-            const Q_VEC4 sc1 = q_mat4_mul_vec4(context.viewport, ndc1);
-            const Q_VEC4 sc2 = q_mat4_mul_vec4(context.viewport, ndc2);
+        const pgl_rast_vertex_t rast_vert2 = {
+            .x = CLAMP(Q_TO_INT(sc2.x), 0, SCREEN_WIDTH  - 1),
+            .y = CLAMP(Q_TO_INT(sc2.y), 0, SCREEN_HEIGHT - 1),
+            .u = q_mul(subtriangle->verts[2].tex_coord.u, inv_depth2),
+            .v = q_mul(subtriangle->verts[2].tex_coord.v, inv_depth2),
+            .inv_depth = inv_depth2,
+        };
 
-            const pgl_rast_vertex_t rast_vert0 = {
-                .x = CLAMP(Q_TO_INT(sc0.x), 0, SCREEN_WIDTH  - 1),
-                .y = CLAMP(Q_TO_INT(sc0.y), 0, SCREEN_HEIGHT - 1),
-                .u = q_mul(subtriangle->verts[0].tex_coord.u, inv_depth0),
-                .v = q_mul(subtriangle->verts[0].tex_coord.v, inv_depth0),
-                .inv_depth = inv_depth0,
-            };
+        const int32_t snapped_area = pgl_triangle_snapped_area(&rast_vert0, &rast_vert1, &rast_vert2);
+        if (snapped_area == 0)
+        {
+            PGL_STATS_ADD(triangles_degenerate, 1);
+            continue;
+        }
 
-            const pgl_rast_vertex_t rast_vert1 = {
-                .x = CLAMP(Q_TO_INT(sc1.x), 0, SCREEN_WIDTH  - 1),
-                .y = CLAMP(Q_TO_INT(sc1.y), 0, SCREEN_HEIGHT - 1),
-                .u = q_mul(subtriangle->verts[1].tex_coord.u, inv_depth1),
-                .v = q_mul(subtriangle->verts[1].tex_coord.v, inv_depth1),
-                .inv_depth = inv_depth1,
-            };
+        pgl_bind_texture_level(pgl_select_texture_level(snapped_area,
+            subtriangle->verts[0].tex_coord, subtriangle->verts[1].tex_coord, subtriangle->verts[2].tex_coord));
 
-            const pgl_rast_vertex_t rast_vert2 = {
-                .x = CLAMP(Q_TO_INT(sc2.x), 0, SCREEN_WIDTH  - 1),
-                .y = CLAMP(Q_TO_INT(sc2.y), 0, SCREEN_HEIGHT - 1),
-                .u = q_mul(subtriangle->verts[2].tex_coord.u, inv_depth2),
-                .v = q_mul(subtriangle->verts[2].tex_coord.v, inv_depth2),
-                .inv_depth = inv_depth2,
-            };
+#if defined(PGL_PRIMITIVE_PLANES)
+        pgl_begin_primitive(&rast_vert0, &rast_vert1, &rast_vert2, snapped_area);
+#endif
 
-            pgl_rasterise_filled_triangle(rast_vert0, rast_vert1, rast_vert2);
-        }
+        pgl_rasterise_filled_triangle(rast_vert0, rast_vert1, rast_vert2);
     }
 }
 
+static void pgl_draw_internal(uint16_t start_index, uint16_t index_stride)
+{
+    TRACE_BEGIN(TRACE_ZONE_DRAW);
+    for (uint16_t i = start_index; i < context.index_count; i += index_stride)
+        pgl_draw_triangle(context.indices[i + 0], context.indices[i + 1], context.indices[i + 2]);
+    TRACE_END(TRACE_ZONE_DRAW);
+}
+
+// Both cores test every meshlet, which costs less than sharing the results, and take turns on the triangles of the visible ones
+static void pgl_draw_meshlets_internal(uint core)
+{
+    TRACE_BEGIN(TRACE_ZONE_DRAW);
+    uint32_t triangle_base = 0;
+    for (uint16_t m = 0; m < context.meshlet_count; ++m)
+    {
+        const pgl_meshlet_t* meshlet = &context.meshlets[m];
+        if (pgl_meshlet_is_culled(meshlet))
+            continue;
+
+        const uint8_t* indices = &context.meshlet_indices[meshlet->index_offset];
+        const uint16_t offset = meshlet->vertex_offset;
+        for (uint32_t t = (core + PGL_CORE_COUNT - triangle_base % PGL_CORE_COUNT) % PGL_CORE_COUNT; t < meshlet->triangle_count; t += PGL_CORE_COUNT)
+            pgl_draw_triangle(offset + indices[3 * t + 0], offset + indices[3 * t + 1], offset + indices[3 * t + 2]);
+        triangle_base += meshlet->triangle_count;
+    }
+    TRACE_END(TRACE_ZONE_DRAW);
+}
+
+#if !defined(PGL_SINGLE_CORE)
 static void pgl_draw_core1()
 {
+#if !defined(PGL_SPAN_BUFFER)
+    pgl_init_scanline_interp();
+#endif
+#if defined(PGL_DEBUG_VIEWS)
+    pgl_debug_init_ticks();
+#endif
+
+    TRACE_BEGIN(TRACE_ZONE_FIFO_WAIT);
     while (true)
     {
         const uint32_t command = multicore_fifo_pop_blocking();
+        TRACE_END(TRACE_ZONE_FIFO_WAIT);
+
         if (command == CORE1_TRIANGLE_DRAW_COMMAND)
         {
             const uint16_t start_index  = (uint16_t)multicore_fifo_pop_blocking();
             const uint16_t index_stride = (uint16_t)multicore_fifo_pop_blocking();
             pgl_draw_internal(start_index, index_stride);
         }
-        else if (command == CORE1_TEXTURE_CONFIG_COMMAND)
+        else if (command == CORE1_MESHLET_DRAW_COMMAND)
+        {
+            pgl_draw_meshlets_internal(1);
+        }
+#if defined(PGL_PRIMITIVE_PLANES)
+        else if (command == CORE1_RESOLVE_COMMAND)
         {
-            const colour_t* texels  = (const colour_t*)multicore_fifo_pop_blocking();
-            const uint width_bits = (uint)multicore_fifo_pop_blocking();
-            const uint height_bits = (uint)multicore_fifo_pop_blocking();
-            pgl_bind_texture_internal(texels, width_bits, height_bits);
+            TRACE_BEGIN(TRACE_ZONE_RESOLVE);
+            pgl_resolve_internal(1, PGL_CORE_COUNT);
+            TRACE_END(TRACE_ZONE_RESOLVE);
         }
+#endif
 
+        // Recorded before signalling, so that nothing is recorded while core 0 may dump the rings
+        TRACE_BEGIN(TRACE_ZONE_FIFO_WAIT);
         const uint32_t complete_signal = UINT32_MAX;
         multicore_fifo_push_blocking(complete_signal);
     }
 }
+#endif
 
 void pgl_init()
 {
     const int spin_lock_number = spin_lock_claim_unused(true);
     context.spin_lock = spin_lock_init(spin_lock_number);
+    pgl_init_morton_table();
+#if !defined(PGL_SPAN_BUFFER)
+    pgl_init_scanline_interp();
+#endif
+#if defined(PGL_TEXTURE_CACHE_BYTES)
+    pgl_texture_cache_init();
+#endif
+#if defined(PGL_DEBUG_VIEWS)
+    pgl_debug_init_ticks();
+#endif
+#if !defined(PGL_SINGLE_CORE)
     multicore_launch_core1(pgl_draw_core1);
+#endif
 }
 
-void pgl_draw(const pgl_vertex_t* vertices, const uint16_t* indices, uint16_t index_count)
+static void pgl_draw_indices(const uint16_t* indices, uint16_t index_count)
 {
-    context.vertices = vertices;
     context.indices = indices;
     context.index_count = index_count;
 
+#if defined(PGL_SINGLE_CORE)
+    pgl_draw_internal(0, 3);
+#else
     const uint16_t start_index  = 3;
     const uint16_t index_stride = 6;
     multicore_fifo_push_blocking(CORE1_TRIANGLE_DRAW_COMMAND);
@@ -641,6 +2011,146 @@ void pgl_draw(const pgl_vertex_t* vertices, const uint16_t* indices, uint16_t in
 
     pgl_draw_internal(0, 6);
     
+    TRACE_BEGIN(TRACE_ZONE_FIFO_WAIT);
+    multicore_fifo_pop_blocking();
+    TRACE_END(TRACE_ZONE_FIFO_WAIT);
+#endif
+}
+
+void pgl_draw(const pgl_vertex_t* vertices, const uint16_t* indices, uint16_t index_count)
+{
+#if defined(PGL_CAPTURE)
+    pgl_capture_draw(vertices, false, indices, index_count);
+#endif
+    context.vertices = vertices;
+    context.packed_vertices = NULL;
+    pgl_draw_indices(indices, index_count);
+}
+
+void pgl_draw_packed(const pgl_packed_vertex_t* vertices, const uint16_t* indices, uint16_t index_count)
+{
+#if defined(PGL_CAPTURE)
+    pgl_capture_draw(vertices, true, indices, index_count);
+#endif
+    context.vertices = NULL;
+    context.packed_vertices = vertices;
+    pgl_draw_indices(indices, index_count);
+}
+
+// The offset of the eye along an axis of the model divided by its scale, 64 bits wide to hold a far eye of a small model
+static inline int64_t pgl_meshlet_eye_coordinate(Q_TYPE offset, Q_TYPE scale)
+{
+    return (scale == Q_ZERO) ? 0 : ((int64_t)offset * (1 << Q_FRAC_BITS)) / scale;
+}
+
+static void pgl_draw_meshlet_list(const pgl_meshlet_t* meshlets, uint16_t meshlet_count, const uint8_t* indices)
+{
+    context.meshlets = meshlets;
+    context.meshlet_count = meshlet_count;
+    context.meshlet_indices = indices;
+
+    // M = T * R * S, so the inverse maps the eye with the transposed rotation and the reciprocal scale. A small model far
+    // away puts the eye hundreds of units out in the space of its vertices, so it is halved until it fits the fixed point.
+    const Q_VEC3 eye_offset = q_vec3_sub(context.eye, context.model_position);
+    const int64_t eye_x = pgl_meshlet_eye_coordinate(q_vec3_dot(q_quat_rotate_vec3(context.model_rotation, Q_VEC3_RIGHT),    eye_offset), context.model_scale.x);
+    const int64_t eye_y = pgl_meshlet_eye_coordinate(q_vec3_dot(q_quat_rotate_vec3(context.model_rotation, Q_VEC3_UP),       eye_offset), context.model_scale.y);
+    const int64_t eye_z = pgl_meshlet_eye_coordinate(q_vec3_dot(q_quat_rotate_vec3(context.model_rotation, Q_VEC3_BACKWARD), eye_offset), context.model_scale.z);
+    uint32_t eye_shift = 0;
+    for (int64_t largest = GREATER(GREATER(ABS(eye_x), ABS(eye_y)), ABS(eye_z)); largest > PGL_MESHLET_EYE_LIMIT; largest >>= 1)
+        ++eye_shift;
+    context.meshlet_eye = (Q_VEC3){{(Q_TYPE)(eye_x >> eye_shift), (Q_TYPE)(eye_y >> eye_shift), (Q_TYPE)(eye_z >> eye_shift)}};
+    context.meshlet_eye_shift = eye_shift;
+    context.meshlet_radius_scale = GREATER(GREATER(ABS(context.model_scale.x), ABS(context.model_scale.y)), ABS(context.model_scale.z));
+
+#if defined(PGL_SINGLE_CORE)
+    pgl_draw_meshlets_internal(0);
+#else
+    multicore_fifo_push_blocking(CORE1_MESHLET_DRAW_COMMAND);
+    pgl_draw_meshlets_internal(0);
+
+    TRACE_BEGIN(TRACE_ZONE_FIFO_WAIT);
+    multicore_fifo_pop_blocking();
+    TRACE_END(TRACE_ZONE_FIFO_WAIT);
+#endif
+}
+
+void pgl_draw_meshlets(const pgl_vertex_t* vertices, const pgl_meshlet_t* meshlets, uint16_t meshlet_count, const uint8_t* indices)
+{
+#if defined(PGL_CAPTURE)
+    pgl_capture_draw_meshlets(vertices, false, meshlets, meshlet_count, indices);
+#endif
+    context.vertices = vertices;
+    context.packed_vertices = NULL;
+    pgl_draw_meshlet_list(meshlets, meshlet_count, indices);
+}
+
+void pgl_draw_packed_meshlets(const pgl_packed_vertex_t* vertices, const pgl_meshlet_t* meshlets, uint16_t meshlet_count, const uint8_t* indices)
+{
+#if defined(PGL_CAPTURE)
+    pgl_capture_draw_meshlets(vertices, true, meshlets, meshlet_count, indices);
+#endif
+    context.vertices = NULL;
+    context.packed_vertices = vertices;
+    pgl_draw_meshlet_list(meshlets, meshlet_count, indices);
+}
+
+void pgl_resolve()
+{
+#if defined(PGL_CAPTURE)
+    pgl_capture_resolve();
+#endif
+#if defined(PGL_PRIMITIVE_PLANES)
+#if !defined(PGL_SINGLE_CORE)
+    multicore_fifo_push_blocking(CORE1_RESOLVE_COMMAND);
+#endif
+
+    TRACE_BEGIN(TRACE_ZONE_RESOLVE);
+    pgl_resolve_internal(0, PGL_CORE_COUNT);
+    TRACE_END(TRACE_ZONE_RESOLVE);
+
+#if !defined(PGL_SINGLE_CORE)
+    TRACE_BEGIN(TRACE_ZONE_FIFO_WAIT);
     multicore_fifo_pop_blocking();
+    TRACE_END(TRACE_ZONE_FIFO_WAIT);
+#endif
+
+#if defined(PGL_SPAN_BUFFER)
+    pgl_span_reset();
+#else
+    context.primitive_count = 0;
+#endif
+#endif
+
+#if defined(PGL_TEXTURE_CACHE_BYTES)
+    pgl_texture_cache_end_frame();
+#endif
+
+#if defined(PGL_DEBUG_VIEWS)
+    pgl_debug_resolve();
+#endif
+
+#if defined(PGL_STATS)
+    for (uint core = 0; core < NUM_CORES; ++core)
+    {
+        context.frame_stats[core] = context.stats[core];
+        context.stats[core] = (pgl_stats_t){0};
+    }
+#endif
+
+    // The first bind of the next frame sets the levels up again, after the cache has aged
+    context.texture.texels = NULL;
+}
+
+#if defined(PGL_STATS)
+pgl_stats_t pgl_stats(uint core)
+{
+    return context.frame_stats[core];
 }
+#endif
 
+#if defined(PGL_DEBUG_VIEWS)
+void pgl_debug_view(pgl_debug_view_t view)
+{
+    context.requested_debug_view = view;
+}
+#endif
@@ -7,6 +7,7 @@
 #include "common/depth.h"
 #include "common/fixed_point.h"
 #include "swapchain/swapchain.h"
+#include "pgl/texture_cache.h"
 
 typedef struct
 {
@@ -14,6 +15,87 @@ typedef struct
     Q_VEC2 tex_coord; // Texture coordinates must have non-negative values
 } pgl_vertex_t;
 
+// Half the size of pgl_vertex_t, generated by tools/pack_vertices.py.
+// The positions are relative to the bounds of the mesh, which the model matrix has to map to the object space.
+typedef struct
+{
+    int16_t position[3];   // In [-1, 1] with 15 fractional bits
+    uint16_t tex_coord[2]; // In [0, 1) with 16 fractional bits
+} pgl_packed_vertex_t;
+
+#define PGL_MESHLET_MAX_VERTICES  64
+#define PGL_MESHLET_MAX_TRIANGLES 124
+
+// A cluster of triangles, generated by tools/meshlets.py, culled as a whole before its vertices are shaded.
+// Its vertices are consecutive in the vertex array and its triangles index them with 8-bit local indices.
+// The bounds are in the space of the vertices, so they are in [-1, 1] for packed vertices.
+typedef struct
+{
+    Q_VEC3 centre;          // Bounding sphere
+    Q_TYPE radius;
+    Q_VEC3 cone_apex;       // Every triangle faces away from the eyes in the cone with this apex around -cone_axis
+    Q_VEC3 cone_axis;
+    Q_TYPE cone_cutoff;     // Cosine of the half angle of the cone, above 1 when the triangles face too many directions
+    uint16_t vertex_offset;
+    uint16_t index_offset;  // 3 local indices per triangle
+    uint8_t vertex_count;
+    uint8_t triangle_count;
+} pgl_meshlet_t;
+
+typedef enum
+{
+    PGL_TEXTURE_FORMAT_COLOUR, // colour_t texels
+    PGL_TEXTURE_FORMAT_INDEX8, // 8-bit indices into a palette of 256 colours
+    PGL_TEXTURE_FORMAT_INDEX4, // 4-bit indices into a palette of 16 colours, the lower nibble holds the left texel
+} pgl_texture_format_t;
+
+typedef enum
+{
+    PGL_TEXTURE_LAYOUT_LINEAR, // Row-major texels
+    PGL_TEXTURE_LAYOUT_MORTON, // Z-order texels in squares of the smaller dimension, the squares back to back along the larger one
+} pgl_texture_layout_t;
+
+typedef struct
+{
+    const void* texels;      // 2^width_bits x 2^height_bits texels in row-major order
+    const void* mipmaps;     // Levels 1 to level_count - 1 back to back, each halving both dimensions and starting at a byte, or NULL
+    const colour_t* palette; // Only for the indexed formats
+    uint16_t width_bits;
+    uint16_t height_bits;
+    uint16_t level_count;
+    uint16_t format;         // pgl_texture_format_t
+    uint16_t layout;         // pgl_texture_layout_t, the smaller dimension of a Morton texture must not exceed 256 texels
+} pgl_texture_t;
+
+#if defined(PGL_STATS)
+typedef struct
+{
+    uint32_t vertices_shaded;
+    uint32_t triangles_in;
+    uint32_t triangles_rejected;    // Entirely outside one of the clip planes
+    uint32_t triangles_clipped;     // Crossing the clip planes
+    uint32_t clipped_triangles_out; // Produced by clipping the crossing triangles
+    uint32_t triangles_culled;      // Back faces
+    uint32_t triangles_degenerate;  // Enclosing no pixel once their vertices are snapped
+    uint32_t fragments_tested;
+    uint32_t fragments_passed;      // Passing the depth test, or visible spans of the span buffer
+    uint32_t texels_fetched;
+    uint32_t lock_acquisitions;
+    uint32_t fragments_overflowed;  // Visible spans the full pools of PGL_SPAN_BUFFER could not take, textured at once in gaps
+} pgl_stats_t;
+#endif
+
+#if defined(PGL_DEBUG_VIEWS)
+typedef enum
+{
+    PGL_DEBUG_VIEW_NONE,
+    PGL_DEBUG_VIEW_OVERDRAW,      // Depth tests of each pixel, or the pixels of the spans inserted with PGL_SPAN_BUFFER
+    PGL_DEBUG_VIEW_DEPTH_REJECTS, // Failed depth tests of each pixel, or the hidden pixels of the inserted spans
+    PGL_DEBUG_VIEW_TILE_TIME,     // Rasterisation and resolve time of each 16x16 tile, relative to the slowest tile
+    PGL_DEBUG_VIEW_COUNT,
+} pgl_debug_view_t;
+#endif
+
 void pgl_init();
 
 void pgl_model(Q_VEC3 position, Q_QUAT rotation, Q_VEC3 scale);
@@ -27,8 +109,28 @@ void pgl_clear_depths(depth_t depth);
 // Returns true when the draw image is successfully received from the swapchain
 bool pgl_request_draw_image();
 
-void pgl_bind_texture(const colour_t* texels, uint width_bits, uint height_bits);
+// Binding the texture that is already bound does nothing, models sharing an atlas texture bind it once per frame
+void pgl_bind_texture(const pgl_texture_t* texture);
 void pgl_draw(const pgl_vertex_t* vertices, const uint16_t* indices, uint16_t index_count);
+void pgl_draw_packed(const pgl_packed_vertex_t* vertices, const uint16_t* indices, uint16_t index_count);
+
+// Skips the meshlets outside the frustum or facing away from the eye, set by pgl_view, without shading their vertices
+void pgl_draw_meshlets(const pgl_vertex_t* vertices, const pgl_meshlet_t* meshlets, uint16_t meshlet_count, const uint8_t* indices);
+void pgl_draw_packed_meshlets(const pgl_packed_vertex_t* vertices, const pgl_meshlet_t* meshlets, uint16_t meshlet_count, const uint8_t* indices);
+
+// Textures the fragments deferred by PGL_DEFERRED_TEXTURING and ends the frame, must be called before swapping images
+void pgl_resolve();
+
+#if defined(PGL_STATS)
+// Returns the statistics counted by the core in the last finished frame
+pgl_stats_t pgl_stats(uint core);
+#endif
+
+#if defined(PGL_DEBUG_VIEWS)
+// Replaces the shaded colours with the view from the next pgl_clear_colours on, colour-coded from black
+// through blue, cyan, green, yellow, orange and red to white. The counting views skip texturing.
+void pgl_debug_view(pgl_debug_view_t view);
+#endif
 
 #endif // PICO_ENGINE_PGL_PGL_H
 
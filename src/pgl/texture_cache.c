@@ -0,0 +1,241 @@
+
+#include <string.h>
+#include <pico/stdlib.h>
+#include "texture_cache.h"
+
+#if defined(PGL_TEXTURE_CACHE_BYTES)
+
+#if PICO_ON_DEVICE
+    #include <hardware/dma.h>
+#endif
+
+#if PGL_TEXTURE_CACHE_BYTES <= 0 || PGL_TEXTURE_CACHE_BYTES % 4 != 0
+    #error "PGL_TEXTURE_CACHE_BYTES must be a positive multiple of 4!"
+#endif
+
+#ifndef PGL_TEXTURE_CACHE_ENTRIES
+    #define PGL_TEXTURE_CACHE_ENTRIES 48
+#endif
+
+#define PGL_TEXTURE_CACHE_ALIGN(size) (((size) + 3u) & ~3u)
+
+typedef enum
+{
+    PGL_TEXTURE_CACHE_EMPTY,
+    PGL_TEXTURE_CACHE_LOADING,
+    PGL_TEXTURE_CACHE_RESIDENT,
+} pgl_texture_cache_state_t;
+
+typedef struct
+{
+    const void* source;
+    uint32_t offset;     // Byte offset of the copy in the arena
+    uint32_t size;       // Bytes of the texels
+    uint32_t last_frame; // Frame of the last request
+    uint32_t uses;       // Requests since the copy was made
+    uint32_t state;      // pgl_texture_cache_state_t
+} pgl_texture_cache_entry_t;
+
+static struct
+{
+    pgl_texture_cache_entry_t entries[PGL_TEXTURE_CACHE_ENTRIES];
+    pgl_texture_cache_entry_t* loading; // Only one copy is in flight at a time
+    pgl_texture_cache_stats_t stats;
+    pgl_texture_cache_stats_t frame_stats;
+    uint32_t frame;
+#if PICO_ON_DEVICE
+    int dma_channel;
+#endif
+} cache;
+
+static uint8_t __attribute__((aligned(4))) cache_arena[PGL_TEXTURE_CACHE_BYTES];
+
+static void pgl_texture_cache_start_copy(const pgl_texture_cache_entry_t* entry)
+{
+    uint8_t* destination = cache_arena + entry->offset;
+#if PICO_ON_DEVICE
+    const bool word_aligned = ((uintptr_t)entry->source % 4 == 0) && (entry->size % 4 == 0);
+
+    dma_channel_config config = dma_channel_get_default_config(cache.dma_channel);
+    channel_config_set_transfer_data_size(&config, word_aligned ? DMA_SIZE_32 : DMA_SIZE_8);
+    channel_config_set_read_increment(&config, true);
+    channel_config_set_write_increment(&config, true);
+    dma_channel_configure(cache.dma_channel, &config, destination, entry->source,
+        word_aligned ? entry->size / 4 : entry->size, true);
+#else
+    memcpy(destination, entry->source, entry->size);
+#endif
+}
+
+static bool pgl_texture_cache_copy_finished()
+{
+#if PICO_ON_DEVICE
+    return !dma_channel_is_busy(cache.dma_channel);
+#else
+    return true;
+#endif
+}
+
+static void pgl_texture_cache_poll()
+{
+    if (cache.loading != NULL && pgl_texture_cache_copy_finished())
+    {
+        cache.loading->state = PGL_TEXTURE_CACHE_RESIDENT;
+        cache.loading = NULL;
+    }
+}
+
+static pgl_texture_cache_entry_t* pgl_texture_cache_find(const void* texels)
+{
+    for (uint32_t i = 0; i < PGL_TEXTURE_CACHE_ENTRIES; ++i)
+    {
+        pgl_texture_cache_entry_t* entry = &cache.entries[i];
+        if (entry->state != PGL_TEXTURE_CACHE_EMPTY && entry->source == texels)
+            return entry;
+    }
+    return NULL;
+}
+
+// Finds the lowest offset where size bytes do not overlap any copy in the arena
+static bool pgl_texture_cache_find_gap(uint32_t size, uint32_t* offset)
+{
+    for (int32_t i = -1; i < PGL_TEXTURE_CACHE_ENTRIES; ++i)
+    {
+        uint32_t candidate = 0;
+        if (i >= 0)
+        {
+            const pgl_texture_cache_entry_t* entry = &cache.entries[i];
+            if (entry->state == PGL_TEXTURE_CACHE_EMPTY)
+                continue;
+            candidate = entry->offset + PGL_TEXTURE_CACHE_ALIGN(entry->size);
+        }
+
+        if (candidate + size > PGL_TEXTURE_CACHE_BYTES)
+            continue;
+
+        bool overlaps = false;
+        for (uint32_t j = 0; j < PGL_TEXTURE_CACHE_ENTRIES && !overlaps; ++j)
+        {
+            const pgl_texture_cache_entry_t* other = &cache.entries[j];
+            overlaps = (other->state != PGL_TEXTURE_CACHE_EMPTY) &&
+                (candidate < other->offset + PGL_TEXTURE_CACHE_ALIGN(other->size)) &&
+                (other->offset < candidate + size);
+        }
+
+        if (!overlaps)
+        {
+            *offset = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+static pgl_texture_cache_entry_t* pgl_texture_cache_find_empty()
+{
+    for (uint32_t i = 0; i < PGL_TEXTURE_CACHE_ENTRIES; ++i)
+    {
+        if (cache.entries[i].state == PGL_TEXTURE_CACHE_EMPTY)
+            return &cache.entries[i];
+    }
+    return NULL;
+}
+
+// Evicts the least recently used copy, the least used one among those of the same frame.
+// Copies requested in the current frame may still be read by the deferred primitives, so they stay.
+// Copies requested in the previous frame stay too, otherwise a working set larger than the budget
+// would evict and copy the same levels every frame.
+static bool pgl_texture_cache_evict()
+{
+    pgl_texture_cache_entry_t* victim = NULL;
+    for (uint32_t i = 0; i < PGL_TEXTURE_CACHE_ENTRIES; ++i)
+    {
+        pgl_texture_cache_entry_t* entry = &cache.entries[i];
+        if (entry->state != PGL_TEXTURE_CACHE_RESIDENT || entry->last_frame + 1 >= cache.frame)
+            continue;
+
+        if (victim == NULL || entry->last_frame < victim->last_frame ||
+            (entry->last_frame == victim->last_frame && entry->uses < victim->uses))
+        {
+            victim = entry;
+        }
+    }
+
+    if (victim == NULL)
+        return false;
+
+    victim->state = PGL_TEXTURE_CACHE_EMPTY;
+    cache.stats.resident_bytes -= PGL_TEXTURE_CACHE_ALIGN(victim->size);
+    cache.stats.evictions++;
+    return true;
+}
+
+void pgl_texture_cache_init()
+{
+#if PICO_ON_DEVICE
+    cache.dma_channel = dma_claim_unused_channel(true);
+#endif
+    // Copies of the frame 0 would never become evictable
+    cache.frame = 1;
+}
+
+const void* pgl_texture_cache_request(const void* texels, uint32_t size)
+{
+    pgl_texture_cache_poll();
+    cache.stats.requests++;
+
+    pgl_texture_cache_entry_t* entry = pgl_texture_cache_find(texels);
+    if (entry != NULL)
+    {
+        entry->last_frame = cache.frame;
+        entry->uses++;
+
+        if (entry->state != PGL_TEXTURE_CACHE_RESIDENT)
+            return texels;
+
+        cache.stats.hits++;
+        return cache_arena + entry->offset;
+    }
+
+    const uint32_t aligned_size = PGL_TEXTURE_CACHE_ALIGN(size);
+    if (cache.loading != NULL || aligned_size > PGL_TEXTURE_CACHE_BYTES)
+        return texels;
+
+    uint32_t offset;
+    while ((entry = pgl_texture_cache_find_empty()) == NULL || !pgl_texture_cache_find_gap(aligned_size, &offset))
+    {
+        if (!pgl_texture_cache_evict())
+            return texels;
+    }
+
+    *entry = (pgl_texture_cache_entry_t){
+        .source = texels,
+        .offset = offset,
+        .size = size,
+        .last_frame = cache.frame,
+        .uses = 1,
+        .state = PGL_TEXTURE_CACHE_LOADING,
+    };
+    cache.loading = entry;
+    cache.stats.resident_bytes += aligned_size;
+    cache.stats.copies++;
+
+    pgl_texture_cache_start_copy(entry);
+    return texels;
+}
+
+void pgl_texture_cache_end_frame()
+{
+    pgl_texture_cache_poll();
+
+    cache.frame_stats = cache.stats;
+    cache.stats = (pgl_texture_cache_stats_t){.resident_bytes = cache.stats.resident_bytes};
+    cache.frame++;
+}
+
+pgl_texture_cache_stats_t pgl_texture_cache_stats()
+{
+    return cache.frame_stats;
+}
+
+#endif // PGL_TEXTURE_CACHE_BYTES
@@ -0,0 +1,28 @@
+
+#ifndef PICO_ENGINE_PGL_TEXTURE_CACHE_H
+#define PICO_ENGINE_PGL_TEXTURE_CACHE_H
+
+#include <stdint.h>
+
+typedef struct
+{
+    uint32_t requests;       // Texture levels bound during the frame
+    uint32_t hits;           // Requests served from a resident copy in SRAM
+    uint32_t copies;         // Levels copied into SRAM during the frame
+    uint32_t evictions;      // Levels evicted to make room for the copies
+    uint32_t resident_bytes; // SRAM held by resident and loading levels at the end of the frame
+} pgl_texture_cache_stats_t;
+
+void pgl_texture_cache_init();
+
+// Returns the SRAM copy of the texels if they are resident, otherwise the texels themselves.
+// A miss schedules a copy into SRAM in the background, so a later request of the same texels hits.
+const void* pgl_texture_cache_request(const void* texels, uint32_t size);
+
+// Latches the statistics of the finished frame, levels requested in it become evictable
+void pgl_texture_cache_end_frame();
+
+// Returns the statistics of the last finished frame
+pgl_texture_cache_stats_t pgl_texture_cache_stats();
+
+#endif // PICO_ENGINE_PGL_TEXTURE_CACHE_H
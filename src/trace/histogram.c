@@ -0,0 +1,27 @@
+
+#include "histogram.h"
+
+void histogram_reset(histogram_t* histogram)
+{
+    *histogram = (histogram_t){0};
+    histogram->min_us = UINT32_MAX;
+}
+
+uint32_t histogram_percentile(const histogram_t* histogram, uint32_t percent)
+{
+    if (histogram->count == 0)
+        return 0;
+
+    // The rank of the time among the sorted ones, counting from 1
+    const uint64_t rank = ((uint64_t)histogram->count * percent + 99) / 100;
+
+    // The last bucket has no end, so its times are bounded by the largest one only
+    uint64_t count = 0;
+    for (uint32_t bucket = 0; bucket < HISTOGRAM_BUCKET_COUNT - 1; ++bucket)
+    {
+        count += histogram->buckets[bucket];
+        if (count >= rank && count != 0)
+            return SMALLER((bucket + 1) * HISTOGRAM_BUCKET_US - 1, histogram->max_us);
+    }
+    return histogram->max_us;
+}
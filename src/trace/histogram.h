@@ -0,0 +1,45 @@
+
+#ifndef PICO_ENGINE_TRACE_HISTOGRAM_H
+#define PICO_ENGINE_TRACE_HISTOGRAM_H
+
+#include <pico/stdlib.h>
+#include "common/macros.h"
+
+#ifndef HISTOGRAM_BUCKET_US
+    #define HISTOGRAM_BUCKET_US 250
+#endif
+
+#define HISTOGRAM_BUCKET_COUNT 256 // Times past the last bucket land in it
+
+// Accumulates times in microseconds into buckets of HISTOGRAM_BUCKET_US
+typedef struct
+{
+    uint32_t buckets[HISTOGRAM_BUCKET_COUNT];
+    uint32_t count;
+    uint64_t total_us;
+    uint32_t min_us;
+    uint32_t max_us;
+} histogram_t;
+
+void histogram_reset(histogram_t* histogram);
+
+static inline void histogram_add(histogram_t* histogram, uint32_t time_us)
+{
+    const uint32_t bucket = time_us / HISTOGRAM_BUCKET_US;
+    ++histogram->buckets[SMALLER(bucket, HISTOGRAM_BUCKET_COUNT - 1)];
+    ++histogram->count;
+    histogram->total_us += time_us;
+    histogram->min_us = SMALLER(time_us, histogram->min_us);
+    histogram->max_us = GREATER(time_us, histogram->max_us);
+}
+
+// Returns the time that the percent of the times do not exceed, rounded up to the end of its bucket but never past
+// the largest time, which it returns for the last bucket. Returns 0 for an empty histogram.
+uint32_t histogram_percentile(const histogram_t* histogram, uint32_t percent);
+
+static inline uint32_t histogram_average(const histogram_t* histogram)
+{
+    return (histogram->count != 0) ? (uint32_t)(histogram->total_us / histogram->count) : 0;
+}
+
+#endif // PICO_ENGINE_TRACE_HISTOGRAM_H
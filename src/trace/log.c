@@ -0,0 +1,55 @@
+
+#include <stdio.h>
+#include "log.h"
+
+log_ring_t log_rings[NUM_CORES];
+
+static uint32_t log_reported_dropped[NUM_CORES];
+
+uint32_t log_flush(uint32_t max_entries)
+{
+    for (uint core = 0; core < NUM_CORES; ++core)
+    {
+        const uint32_t dropped = log_rings[core].dropped;
+        if (dropped != log_reported_dropped[core])
+        {
+            printf("LOG %u dropped %lu\n", core, (unsigned long)(dropped - log_reported_dropped[core]));
+            log_reported_dropped[core] = dropped;
+        }
+    }
+
+    uint32_t flushed = 0;
+    while (flushed < max_entries)
+    {
+        // The oldest entry at the tails of the rings goes first
+        log_ring_t* oldest = NULL;
+        uint oldest_core = 0;
+        for (uint core = 0; core < NUM_CORES; ++core)
+        {
+            log_ring_t* ring = &log_rings[core];
+            if (ring->tail == __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE))
+                continue;
+
+            const uint32_t time_us = ring->entries[ring->tail & (LOG_ENTRY_COUNT - 1)].time_us;
+            if (oldest == NULL || (int32_t)(time_us - oldest->entries[oldest->tail & (LOG_ENTRY_COUNT - 1)].time_us) < 0)
+            {
+                oldest = ring;
+                oldest_core = core;
+            }
+        }
+        if (oldest == NULL)
+            break;
+
+        const log_entry_t* entry = &oldest->entries[oldest->tail & (LOG_ENTRY_COUNT - 1)];
+        printf("LOG %u %lu ", oldest_core, (unsigned long)entry->time_us);
+        printf(entry->format, (unsigned long)entry->args[0], (unsigned long)entry->args[1], (unsigned long)entry->args[2],
+            (unsigned long)entry->args[3], (unsigned long)entry->args[4], (unsigned long)entry->args[5]);
+        printf("\n");
+
+        // The entry may be overwritten once the tail passes it
+        __atomic_store_n(&oldest->tail, oldest->tail + 1, __ATOMIC_RELEASE);
+        ++flushed;
+    }
+
+    return flushed;
+}
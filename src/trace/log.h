@@ -0,0 +1,67 @@
+
+#ifndef PICO_ENGINE_TRACE_LOG_H
+#define PICO_ENGINE_TRACE_LOG_H
+
+#include <pico/stdlib.h>
+
+#ifndef LOG_ENTRY_COUNT
+    #define LOG_ENTRY_COUNT 64
+#endif
+
+#if LOG_ENTRY_COUNT <= 0 || (LOG_ENTRY_COUNT & (LOG_ENTRY_COUNT - 1)) != 0
+    #error "LOG_ENTRY_COUNT must be a power of 2!"
+#endif
+
+#define LOG_ARG_COUNT 6
+
+// The format is only expanded when the entry is flushed, so it must outlive the entry and take its arguments as %lu or %lx
+typedef struct
+{
+    uint32_t time_us;
+    const char* format;
+    uint32_t args[LOG_ARG_COUNT];
+} log_entry_t;
+
+// Each core only writes its own ring and only the flushing core reads it, so neither takes a lock
+typedef struct
+{
+    log_entry_t entries[LOG_ENTRY_COUNT];
+    uint32_t head;    // Written by the owning core
+    uint32_t tail;    // Written by the flushing core
+    uint32_t dropped; // Entries that found the ring full
+} log_ring_t;
+
+extern log_ring_t log_rings[NUM_CORES];
+
+static inline void log_write(const char* format, uint32_t arg0, uint32_t arg1, uint32_t arg2, uint32_t arg3, uint32_t arg4, uint32_t arg5)
+{
+    log_ring_t* ring = &log_rings[get_core_num()];
+    const uint32_t head = ring->head;
+    if (head - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE) == LOG_ENTRY_COUNT)
+    {
+        ++ring->dropped;
+        return;
+    }
+
+    ring->entries[head & (LOG_ENTRY_COUNT - 1)] = (log_entry_t){time_us_32(), format, {arg0, arg1, arg2, arg3, arg4, arg5}};
+    __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+}
+
+// Returns how many more entries the ring of the calling core can take
+static inline uint32_t log_free_entries()
+{
+    const log_ring_t* ring = &log_rings[get_core_num()];
+    return LOG_ENTRY_COUNT - (ring->head - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE));
+}
+
+// Prints up to max_entries of the oldest entries of both rings as "LOG <core> <time_us> <message>" lines and returns
+// how many it printed. Entries dropped since the last flush are reported as "LOG <core> dropped <count>".
+// Only one core may flush.
+uint32_t log_flush(uint32_t max_entries);
+
+// Records a message of up to LOG_ARG_COUNT arguments without formatting or printing it
+#define LOG(...) LOG_WRITE(__VA_ARGS__, 0, 0, 0, 0, 0, 0)
+#define LOG_WRITE(format, arg0, arg1, arg2, arg3, arg4, arg5, ...) \
+    log_write((format), (uint32_t)(arg0), (uint32_t)(arg1), (uint32_t)(arg2), (uint32_t)(arg3), (uint32_t)(arg4), (uint32_t)(arg5))
+
+#endif // PICO_ENGINE_TRACE_LOG_H
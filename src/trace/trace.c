@@ -0,0 +1,40 @@
+
+#include <stdio.h>
+#include "trace.h"
+
+#if defined(TRACE_EVENT_COUNT)
+
+static const char* const trace_zone_names[TRACE_ZONE_COUNT] = {
+    [TRACE_ZONE_FRAME]          = "frame",
+    [TRACE_ZONE_SWAPCHAIN_WAIT] = "swapchain wait",
+    [TRACE_ZONE_CLEAR_COLOURS]  = "clear colours",
+    [TRACE_ZONE_CLEAR_DEPTHS]   = "clear depths",
+    [TRACE_ZONE_SCENE]          = "scene",
+    [TRACE_ZONE_BIND_TEXTURE]   = "bind texture",
+    [TRACE_ZONE_DRAW]           = "draw",
+    [TRACE_ZONE_RESOLVE]        = "resolve",
+    [TRACE_ZONE_FIFO_WAIT]      = "fifo wait",
+};
+
+trace_ring_t trace_rings[NUM_CORES];
+
+void trace_dump()
+{
+    printf("TRACE DUMP\n");
+    for (uint core = 0; core < NUM_CORES; ++core)
+    {
+        trace_ring_t* ring = &trace_rings[core];
+
+        // When the ring has wrapped around, the oldest events are overwritten
+        const uint32_t first = (ring->head > TRACE_EVENT_COUNT) ? ring->head - TRACE_EVENT_COUNT : 0;
+        for (uint32_t i = first; i < ring->head; ++i)
+        {
+            const trace_event_t* event = &ring->events[i & (TRACE_EVENT_COUNT - 1)];
+            printf("TRACE %u %c %lu %s\n", core, (event->phase == TRACE_PHASE_BEGIN) ? 'B' : 'E',
+                (unsigned long)event->time_us, trace_zone_names[event->zone]);
+        }
+        ring->head = 0;
+    }
+}
+
+#endif // TRACE_EVENT_COUNT
@@ -0,0 +1,69 @@
+
+#ifndef PICO_ENGINE_TRACE_TRACE_H
+#define PICO_ENGINE_TRACE_TRACE_H
+
+#include <pico/stdlib.h>
+
+typedef enum
+{
+    TRACE_ZONE_FRAME,
+    TRACE_ZONE_SWAPCHAIN_WAIT, // Until the swapchain hands out the next draw image
+    TRACE_ZONE_CLEAR_COLOURS,
+    TRACE_ZONE_CLEAR_DEPTHS,
+    TRACE_ZONE_SCENE,
+    TRACE_ZONE_BIND_TEXTURE,
+    TRACE_ZONE_DRAW,           // Vertex work and rasterisation of the triangles of a draw call on one core
+    TRACE_ZONE_RESOLVE,
+    TRACE_ZONE_FIFO_WAIT,      // Core 0 waiting for core 1 to finish, or core 1 waiting for a command
+    TRACE_ZONE_COUNT,
+} trace_zone_t;
+
+#if defined(TRACE_EVENT_COUNT)
+
+#if TRACE_EVENT_COUNT <= 0 || (TRACE_EVENT_COUNT & (TRACE_EVENT_COUNT - 1)) != 0
+    #error "TRACE_EVENT_COUNT must be a power of 2!"
+#endif
+
+typedef enum
+{
+    TRACE_PHASE_BEGIN,
+    TRACE_PHASE_END,
+} trace_phase_t;
+
+typedef struct
+{
+    uint32_t time_us;
+    uint8_t zone;  // trace_zone_t
+    uint8_t phase; // trace_phase_t
+} trace_event_t;
+
+// Each core only writes its own ring, which keeps the last TRACE_EVENT_COUNT events
+typedef struct
+{
+    trace_event_t events[TRACE_EVENT_COUNT];
+    uint32_t head; // Events recorded since the last dump
+} trace_ring_t;
+
+extern trace_ring_t trace_rings[NUM_CORES];
+
+static inline void trace_record(trace_zone_t zone, trace_phase_t phase)
+{
+    trace_ring_t* ring = &trace_rings[get_core_num()];
+    ring->events[ring->head++ & (TRACE_EVENT_COUNT - 1)] = (trace_event_t){time_us_32(), (uint8_t)zone, (uint8_t)phase};
+}
+
+// Prints "TRACE DUMP", then the events of both rings as "TRACE <core> <B|E> <time_us> <zone>" lines, and empties the rings.
+// The other core must not record while it runs, tools/trace_json.py converts the output into a Chrome trace.
+void trace_dump();
+
+#define TRACE_BEGIN(zone) trace_record((zone), TRACE_PHASE_BEGIN)
+#define TRACE_END(zone)   trace_record((zone), TRACE_PHASE_END)
+
+#else
+
+#define TRACE_BEGIN(zone) ((void)0)
+#define TRACE_END(zone)   ((void)0)
+
+#endif // TRACE_EVENT_COUNT
+
+#endif // PICO_ENGINE_TRACE_TRACE_H
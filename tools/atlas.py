@@ -0,0 +1,229 @@
+#!/usr/bin/env python3
+"""Packs the textures of a model source file into one atlas texture, in place.
+
+The textures (all of them by default) are packed into the smallest power-of-two atlas, every one
+at a position aligned to its own size so that the box filter of the mip chain never mixes texels
+of different textures. The mip chain stops at the level where the smallest texture is a single
+texel. The atlas keeps the format of the textures: indexed textures are decoded and quantised
+again to a single shared palette, colour textures stay colour textures.
+
+The texture coordinates of every model using a packed texture are remapped into its region and
+all of them share the same `.texture = { ... }` initializer, so pgl_bind_texture only binds it once.
+The regions are written to NAME_regions as runtime metadata, in the order the textures are given.
+Texture coordinates must lie in [0, 1], since regions of an atlas cannot repeat.
+
+    python3 tools/atlas.py scene_models.c [--name scene_atlas] [--format rgb565|rgb332] [NAME ...]
+"""
+
+import argparse
+import math
+import re
+import sys
+
+import texture_source as ts
+import mipmap
+import quantise
+
+MODEL = re.compile(r"const model_t (\w+) = \{\s*\.mesh\s*=\s*(\w+),\s*\.texture\s*=\s*\{\s*\.texels\s*=\s*(\w+)")
+MESH_VERTICES = r"static const mesh_t %s = \{\s*\.vertices\s*=\s*(\w+)"
+MESH_PACKED_VERTICES = r"static const mesh_t %s = \{\s*\.packed_vertices\s*="
+ATLAS_MARKER = "/* atlas */"
+TEX_COORD = re.compile(r"(\}, \{)Q_FROM_FLOAT\(([-+0-9.]+)\), Q_FROM_FLOAT\(([-+0-9.]+)\)(\}\})")
+
+
+def decode(source, fields, fmt):
+    """Returns the colours of the base level of a texture."""
+    width, height = 1 << int(fields["width_bits"]), 1 << int(fields["height_bits"])
+    values = ts.array_values(ts.find_array(source, fields["texels"]))
+    if not ts.is_indexed(fields):
+        return values[:width * height]
+
+    palette = ts.array_values(ts.find_array(source, fields["palette"]))
+    if fields["format"] == "PGL_TEXTURE_FORMAT_INDEX4":
+        values = [(byte >> shift) & 0xf for byte in values for shift in (0, 4)]
+    return [palette[i] for i in values[:width * height]]
+
+
+def pack(sizes):
+    """Places (width, height) rectangles of powers of two, returns the atlas size and the positions.
+
+    Larger rectangles are placed first at the first free position aligned to their size, trying
+    atlases of increasing area (wider than tall on ties) until they all fit.
+    """
+    order = sorted(range(len(sizes)), key=lambda i: (-sizes[i][0] * sizes[i][1], i))
+    area = sum(w * h for w, h in sizes)
+    atlas_bits = max(w * h for w, h in sizes).bit_length() - 1
+
+    while True:
+        candidates = [(1 << (atlas_bits - hb), 1 << hb) for hb in range(atlas_bits // 2, -1, -1)]
+        for atlas_width, atlas_height in candidates:
+            if (1 << atlas_bits) < area or any(w > atlas_width or h > atlas_height for w, h in sizes):
+                continue
+
+            placed, positions = [], [None] * len(sizes)
+            for i in order:
+                w, h = sizes[i]
+                spot = next(((x, y) for y in range(0, atlas_height, h) for x in range(0, atlas_width, w)
+                             if not any(x < px + pw and px < x + w and y < py + ph and py < y + h for px, py, pw, ph in placed)), None)
+                if spot is None:
+                    break
+                placed.append((spot[0], spot[1], w, h))
+                positions[i] = spot
+            else:
+                return (atlas_width, atlas_height), positions
+        atlas_bits += 1
+
+
+def remap(vertices, region, atlas_size):
+    x, y, w, h = region
+    atlas_width, atlas_height = atlas_size
+
+    def tex_coord(match):
+        u, v = float(match.group(2)), float(match.group(3))
+        if not (0.0 <= u <= 1.0 and 0.0 <= v <= 1.0):
+            raise ValueError("texture coordinates (%f, %f) lie outside [0, 1]" % (u, v))
+
+        # A coordinate of 1 would sample the first texel after the region
+        u = (x + min(u * w, w - 0.5)) / atlas_width
+        v = (y + min(v * h, h - 0.5)) / atlas_height
+        return "%sQ_FROM_FLOAT(%+f), Q_FROM_FLOAT(%+f)%s" % (match.group(1), u, v, match.group(4))
+
+    return TEX_COORD.sub(tex_coord, vertices)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("source")
+    parser.add_argument("names", nargs="*", help="textures to pack, all textures by default")
+    parser.add_argument("--name", default="scene_atlas")
+    parser.add_argument("--format", choices=ts.COLOUR_FORMATS.keys(), default="rgb565")
+    args = parser.parse_args()
+
+    with open(args.source) as f:
+        source = f.read()
+
+    textures = ts.textures(source)
+    names = args.names or list(textures)
+    if len(names) < 2:
+        sys.exit("at least two textures are needed for an atlas")
+
+    formats = set(textures[name].get("format", "PGL_TEXTURE_FORMAT_COLOUR") if name in textures else None for name in names)
+    if None in formats:
+        sys.exit("no texture initializer for one of " + ", ".join(names))
+    if len(formats) > 1:
+        sys.exit("the textures have different formats: " + ", ".join(sorted(formats)))
+    texture_format = formats.pop()
+    for name in names:
+        if ts.is_morton(textures[name]):
+            sys.exit("%s has the Morton layout, run tools/swizzle.py --linear first" % name)
+
+    # Every model using a packed texture, with the vertex array of its mesh
+    models = {}
+    for model, mesh, texels in MODEL.findall(source):
+        match = re.search(MESH_VERTICES % re.escape(mesh), source)
+        if match is None and re.search(MESH_PACKED_VERTICES % re.escape(mesh), source):
+            sys.exit("mesh %s of %s has packed vertices, run tools/atlas.py before tools/pack_vertices.py" % (mesh, model))
+        if match is None:
+            sys.exit("mesh %s of %s not found" % (mesh, model))
+        models.setdefault(match.group(1), set()).add(texels)
+
+    for vertices, used in models.items():
+        if len(used) > 1 and used & set(names):
+            sys.exit("%s is shared by models with the textures %s" % (vertices, ", ".join(sorted(used))))
+
+    sizes = [(1 << int(textures[name]["width_bits"]), 1 << int(textures[name]["height_bits"])) for name in names]
+    (atlas_width, atlas_height), positions = pack(sizes)
+    regions = [(x, y, w, h) for (x, y), (w, h) in zip(positions, sizes)]
+
+    texels = [0] * (atlas_width * atlas_height)
+    for name, (x, y, w, h) in zip(names, regions):
+        colours = decode(source, textures[name], args.format)
+        for row in range(h):
+            texels[(y + row) * atlas_width + x:(y + row) * atlas_width + x + w] = colours[row * w:(row + 1) * w]
+
+    # Stops where the smallest texture is a single texel
+    level_count = min(min(w, h).bit_length() for w, h in sizes)
+    levels, width, height = [texels], atlas_width, atlas_height
+    for _ in range(1, level_count):
+        levels.append(mipmap.downsample(levels[-1], width, height, args.format))
+        width, height = width // 2, height // 2
+    level_sizes = [(atlas_width >> i, atlas_height >> i) for i in range(level_count)]
+
+    for vertices, used in models.items():
+        if used & set(names):
+            region = regions[names.index(next(iter(used)))]
+            match = ts.array_pattern(vertices, r"pgl_vertex_t").search(source)
+            try:
+                source = source[:match.start(2)] + remap(match.group(2), region, (atlas_width, atlas_height)) + source[match.end(2):]
+            except ValueError as error:
+                sys.exit("%s: %s" % (vertices, error))
+
+    # The atlas takes the place of the first packed texture
+    arrays_of = [textures[name][field] for name in names for field in ("palette", "texels", "mipmaps") if field in textures[name]]
+    start = min(ts.find_array(source, array).start() for array in arrays_of)
+    source = source[:start] + ATLAS_MARKER + source[start:]
+    for array in arrays_of:
+        source = ts.remove_array(source, array)
+
+    digits = ts.COLOUR_FORMATS[args.format][3]
+    arrays, fields = [], {"texels": args.name, "width_bits": str(atlas_width.bit_length() - 1),
+                          "height_bits": str(atlas_height.bit_length() - 1), "format": texture_format}
+    level_rows = [[level[y * w:(y + 1) * w] for y in range(h)] for level, (w, h) in zip(levels, level_sizes)]
+    element_type, element_digits = "colour_t", digits
+
+    if texture_format != "PGL_TEXTURE_FORMAT_COLOUR":
+        bits = 4 if texture_format == "PGL_TEXTURE_FORMAT_INDEX4" else 8
+        # Texels outside the regions are never sampled, they must not take palette entries
+        used = []
+        for i, (lw, lh) in enumerate(level_sizes):
+            mask = [False] * (lw * lh)
+            for x, y, w, h in regions:
+                for row in range(y >> i, (y + h) >> i):
+                    mask[row * lw + (x >> i):row * lw + ((x + w) >> i)] = [True] * (w >> i)
+            used.append(mask)
+
+        used_texels = [t for level, mask in zip(levels, used) for t, m in zip(level, mask) if m]
+        palette, indices = quantise.quantise(used_texels, 1 << bits, args.format)
+        error = math.sqrt(sum(quantise.distance(quantise.to_rgb(t, args.format), quantise.to_rgb(palette[i], args.format))
+                              for t, i in zip(used_texels, indices)) / len(used_texels) / 3)
+        indices = iter(indices)
+        level_rows = []
+        for mask, (w, h) in zip(used, level_sizes):
+            level_rows.append(quantise.pack_rows([next(indices) if m else 0 for m in mask], w, h, bits))
+        element_type, element_digits = "uint8_t", 2
+
+        fields["palette"] = args.name + "_palette"
+        arrays.append(ts.format_array("colour_t", fields["palette"], [palette[i:i + 16] for i in range(0, len(palette), 16)], digits))
+        print("%s: %d colours in %d palette entries, RMS error %.2f / 255" % (args.name, len(set(used_texels)), len(palette), error))
+
+    arrays.append(ts.format_array(element_type, args.name, level_rows[0], element_digits))
+    if level_count > 1:
+        rows, comments = [], {}
+        for level, (w, h) in enumerate(level_sizes[1:], start=1):
+            comments[len(rows)] = "Level %d: %dx%d" % (level, w, h)
+            rows += level_rows[level]
+        fields["mipmaps"] = args.name + "_mipmaps"
+        arrays.append(ts.format_array(element_type, fields["mipmaps"], rows, element_digits, comments))
+    fields["level_count"] = str(level_count)
+
+    regions_array = ["const texture_region_t %s_regions[] = {" % args.name]
+    for name, (x, y, w, h) in zip(names, regions):
+        regions_array.append("    { .x = %d, .y = %d, .width_bits = %d, .height_bits = %d }, // %s"
+                             % (x, y, w.bit_length() - 1, h.bit_length() - 1, name))
+    arrays.append("\n".join(regions_array) + "\n};\n")
+
+    source = source.replace(ATLAS_MARKER, "\n".join(arrays))
+    for name in names:
+        source = ts.replace_texture(source, dict(fields, texels=name))
+        source = source.replace(".texture = { .texels = %s," % name, ".texture = { .texels = %s," % args.name)
+
+    with open(args.source, "w") as f:
+        f.write(source)
+
+    print("%s: %d textures in %dx%d with %d levels, %.0f%% used" % (args.name, len(names), atlas_width, atlas_height,
+          level_count, 100.0 * sum(w * h for w, h in sizes) / (atlas_width * atlas_height)))
+    print("declare `extern const texture_region_t %s_regions[];` next to the models" % args.name)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,77 @@
+#!/usr/bin/env python3
+"""Compares the output of the pico-engine-scene-benchmark target against a stored baseline.
+
+The benchmark prints a `BENCH <json>` line per camera path. Capture its output (the serial
+output on device, stdout on host), store a baseline of the build to compare against with --save,
+then compare later captures with it. A path regresses when its average or 99th percentile frame
+time exceeds the baseline by more than the threshold, in which case the exit status is 1. The
+per-stage statistics of PGL_STATS builds are printed next to the times when both runs have them.
+
+    python3 tools/bench_compare.py capture.txt baseline.json --save
+    python3 tools/bench_compare.py capture.txt baseline.json [--threshold 5]
+"""
+
+import argparse
+import json
+import sys
+
+PREFIX = "BENCH "
+TIMES = ["avg_us", "p99_us"]
+
+
+def parse(lines):
+    """Returns the results of the capture by path, the last run of a path wins."""
+    results = {}
+    for line in lines:
+        line = line.strip()
+        if line.startswith(PREFIX):
+            result = json.loads(line[len(PREFIX):])
+            results[result["path"]] = result
+    return results
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("capture")
+    parser.add_argument("baseline")
+    parser.add_argument("--save", action="store_true", help="store the capture as the baseline instead of comparing")
+    parser.add_argument("--threshold", type=float, default=5.0, help="allowed slowdown in percent")
+    args = parser.parse_args()
+
+    with open(args.capture, errors="replace") as f:
+        results = parse(f)
+    if not results:
+        sys.exit("no benchmark results found in " + args.capture)
+
+    if args.save:
+        with open(args.baseline, "w") as f:
+            json.dump(results, f, indent=4, sort_keys=True)
+        print("%d paths stored in %s" % (len(results), args.baseline))
+        return
+
+    with open(args.baseline) as f:
+        baseline = json.load(f)
+
+    regressions = 0
+    for path, result in results.items():
+        if path not in baseline:
+            print("%-12s not in the baseline" % path)
+            continue
+
+        base = baseline[path]
+        for time in TIMES:
+            change = 100.0 * (result[time] - base[time]) / max(base[time], 1)
+            regressed = change > args.threshold
+            regressions += regressed
+            print("%-12s %-7s %8d us -> %8d us %+7.1f%%%s" % (path, time, base[time], result[time], change, "  REGRESSION" if regressed else ""))
+
+        for stat, value in sorted(result.get("stats", {}).items()):
+            if stat in base.get("stats", {}) and base["stats"][stat] != value:
+                print("%-12s %-21s %8d -> %8d" % (path, stat, base["stats"][stat], value))
+
+    if regressions:
+        sys.exit("%d regressions over %.1f%%" % (regressions, args.threshold))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,130 @@
+#!/usr/bin/env python3
+"""Sweeps the build configurations and prints a Pareto table of frame time, memory and image error.
+
+For each combination of fixed-point type, colour format and depth precision, a host build
+(PICO_PLATFORM=host) of the pico-engine-scene-benchmark and pico-engine-golden-render targets is
+configured with PICO_ENGINE_DEFINITIONS. The scene benchmark flies its camera paths, the golden
+renderer renders its views, and every configuration is reported with:
+
+- the average and the worst 99th percentile frame time of the paths,
+- the static RAM (data and bss) of the golden renderer, which holds the swapchain, depth and
+  texture buffers of the configuration,
+- the lowest PSNR and the largest fraction of differing pixels of its views against a reference.
+
+The reference is a separate build more precise than any configuration: Q16_16 with RGB565 and
+DEPTH_16BIT, perspective-correct texture coordinates at every pixel (PGL_AFFINE_SPAN_LENGTH=1) and
+core 0 alone (PGL_SINGLE_CORE), so that no race of the cores on a pixel ends up in the error. It
+is not a row of the table, so every configuration is measured against it, and it takes no part
+in the Pareto front. A configuration is on the Pareto front when no other one is at least as
+good in all three of frame time, RAM and PSNR and better in one. Host frame times only rank the
+configurations; for device times, flash the scene benchmark of each configuration, capture its
+serial output into <captures>/<config>.txt and pass --captures, which replaces the host runs.
+
+    python3 tools/config_sweep.py [--config q16_16-rgb565-depth_8bit ...] [--define PGL_SPAN_BUFFER ...]
+    python3 tools/config_sweep.py --captures CAPTURES --json sweep.json
+"""
+
+import argparse
+import json
+import math
+import os
+import subprocess
+import sys
+
+import bench_compare
+import golden_images
+
+BENCHMARK = "pico-engine-scene-benchmark"
+REFERENCE = "reference"
+REFERENCE_DEFINITIONS = ["Q16_16", "RGB565", "DEPTH_16BIT", "PGL_AFFINE_SPAN_LENGTH=1", "PGL_SINGLE_CORE"]
+
+
+def static_ram(executable):
+    """Returns the data and bss bytes of the executable."""
+    output = subprocess.run(["size", executable], check=True, capture_output=True, text=True).stdout
+    _, data, bss = output.splitlines()[1].split()[:3]
+    return int(data) + int(bss)
+
+
+def frame_times(results):
+    """Returns the average frame time over the paths and the worst 99th percentile in microseconds."""
+    if not results:
+        return math.nan, math.nan
+    return (sum(result["avg_us"] for result in results.values()) / len(results),
+            max(result["p99_us"] for result in results.values()))
+
+
+def image_error(reference_dir, image_dir):
+    """Returns the lowest PSNR in dB and the largest fraction of differing pixels of the views."""
+    min_psnr, max_differing = math.inf, 0.0
+    for image_name in sorted(os.listdir(reference_dir)):
+        width, height, reference = golden_images.read_ppm(os.path.join(reference_dir, image_name))
+        _, _, image = golden_images.read_ppm(os.path.join(image_dir, image_name))
+        _, psnr, differing = golden_images.compare(reference, image)
+        min_psnr = min(min_psnr, psnr)
+        max_differing = max(max_differing, differing / (width * height))
+    return min_psnr, max_differing
+
+
+def dominates(a, b):
+    """Returns whether the row a is at least as good as b in every objective and better in one."""
+    objectives_a = (a["avg_us"], a["ram"], -a["min_psnr"])
+    objectives_b = (b["avg_us"], b["ram"], -b["min_psnr"])
+    return all(x <= y for x, y in zip(objectives_a, objectives_b)) and objectives_a != objectives_b
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--config", action="append", help="only this configuration, may be repeated")
+    parser.add_argument("--define", action="append", default=[], help="definition added to every configuration, may be repeated")
+    parser.add_argument("--captures", help="directory of <config>.txt scene benchmark captures from the device")
+    parser.add_argument("--build-dir", default=os.path.join(golden_images.ROOT, "build", "sweep"))
+    parser.add_argument("--json", help="also write the table to this file")
+    args = parser.parse_args()
+
+    configs = golden_images.configurations()
+    for name in args.config or []:
+        if name not in configs:
+            sys.exit("unknown configuration %s, the configurations are %s" % (name, ", ".join(configs)))
+    names = args.config or list(configs)
+
+    # The plain pipeline, whatever --define adds to the configurations
+    reference_dir = golden_images.render(golden_images.build(REFERENCE, REFERENCE_DEFINITIONS, args.build_dir, [golden_images.TARGET]))
+
+    rows, image_dirs = [], {}
+    for name in names:
+        targets = [golden_images.TARGET] if args.captures else [golden_images.TARGET, BENCHMARK]
+        build_dir = golden_images.build(name, configs[name] + args.define, args.build_dir, targets)
+        image_dirs[name] = golden_images.render(build_dir)
+
+        if args.captures:
+            with open(os.path.join(args.captures, name + ".txt"), errors="replace") as f:
+                results = bench_compare.parse(f)
+        else:
+            output = subprocess.run([os.path.join(build_dir, "src", "benchmark", BENCHMARK)],
+                                    check=True, capture_output=True, text=True).stdout
+            results = bench_compare.parse(output.splitlines())
+
+        avg_us, p99_us = frame_times(results)
+        ram = static_ram(os.path.join(build_dir, "src", "benchmark", golden_images.TARGET))
+        rows.append({"config": name, "avg_us": avg_us, "p99_us": p99_us, "ram": ram})
+
+    for row in rows:
+        row["min_psnr"], row["max_differing"] = image_error(reference_dir, image_dirs[row["config"]])
+    for row in rows:
+        row["pareto"] = not any(dominates(other, row) for other in rows)
+
+    print("%-28s %10s %10s %10s %10s %10s" % ("configuration", "avg us", "p99 us", "RAM KiB", "min PSNR", "differing"))
+    for row in sorted(rows, key=lambda row: row["avg_us"]):
+        print("%-28s %10.0f %10.0f %10.1f %10.2f %9.2f%%%s"
+              % (row["config"], row["avg_us"], row["p99_us"], row["ram"] / 1024.0, row["min_psnr"],
+                 100.0 * row["max_differing"], "  pareto" if row["pareto"] else ""))
+
+    if args.json:
+        with open(args.json, "w") as f:
+            # Identical images have an infinite PSNR, which JSON cannot hold
+            json.dump([dict(row, min_psnr=min(row["min_psnr"], 999.0)) for row in rows], f, indent=4)
+
+
+if __name__ == "__main__":
+    main()
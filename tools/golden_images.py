@@ -0,0 +1,240 @@
+#!/usr/bin/env python3
+"""Renders the golden views of the farm for every build configuration and compares them with stored images.
+
+For each combination of fixed-point type, colour format and depth precision, a host build
+(PICO_PLATFORM=host) of the pico-engine-golden-render target is configured with
+PICO_ENGINE_DEFINITIONS and run, and its images are compared with GOLDEN/<config>/<view>.png,
+tools/golden by default. The maximum channel difference, the PSNR and the number of differing
+pixels are printed for each image. The builds define PGL_SINGLE_CORE: with both cores, pixels
+where two triangles tie in depth go either way between runs, with core 0 alone every run gives
+the same image. The small default tolerance is left for the float maths of the camera setup,
+which may round differently with another compiler or C library. The texels of the scene are stored
+as RGB565 and come out truncated in RGB332 builds, whose images check the geometry and the depth
+rather than the colours.
+
+The configurations of EXPECTED_FAILURES are known to render wrong. They have no golden images of
+their own, are compared with those of Q16_16 in the same colour format and depth precision, and
+report an unexpected pass, which fails the run, once all their images match.
+
+--save stores the images as the golden ones instead. They are not part of the repository: store
+them from a revision whose images were checked by eye before changing the renderer. --define adds
+definitions to every configuration, and its golden images are kept apart, under
+<config>-<definition>: a faster path (PGL_SPAN_BUFFER, for example) interpolates differently and
+is compared with its own images.
+
+    python3 tools/golden_images.py --save
+    python3 tools/golden_images.py [GOLDEN] [--config q16_16-rgb565-depth_8bit ...] [--define PGL_SPAN_BUFFER ...]
+"""
+
+import argparse
+import itertools
+import math
+import os
+import shutil
+import struct
+import subprocess
+import sys
+import zlib
+
+ROOT = os.path.normpath(os.path.join(os.path.dirname(os.path.abspath(__file__)), ".."))
+TARGET = "pico-engine-golden-render"
+
+FIXED_POINT_TYPES = ["Q16_16", "Q24_8", "Q8_24"]
+COLOUR_FORMATS = ["RGB565", "RGB332"]
+DEPTH_PRECISIONS = ["DEPTH_8BIT", "DEPTH_16BIT"]
+SCREEN = ["SCREEN_WIDTH=240", "SCREEN_HEIGHT=240"]
+# Definitions whose configurations render wrong, with the reason
+EXPECTED_FAILURES = {"Q8_24": "Q8_24 holds values below 128, which the viewport of a 240 pixel screen overflows"}
+# Core 0 renders alone, so that the images do not depend on how the cores race on the pixels
+GOLDEN_DEFINITIONS = ["PGL_SINGLE_CORE"]
+
+
+def configurations():
+    """Returns the definitions of every configuration by name."""
+    return {"-".join(c.lower() for c in combination): list(combination)
+            for combination in itertools.product(FIXED_POINT_TYPES, COLOUR_FORMATS, DEPTH_PRECISIONS)}
+
+
+def expected_failure(definitions):
+    """Returns why the configuration renders wrong, None when it is expected to match its golden images."""
+    return next((EXPECTED_FAILURES[d] for d in definitions if d in EXPECTED_FAILURES), None)
+
+
+def build(name, definitions, build_root, targets):
+    """Configures and builds the targets of the configuration on the host, returns the build directory."""
+    build_dir = os.path.join(build_root, name)
+    subprocess.run(["cmake", "-S", ROOT, "-B", build_dir, "-DPICO_PLATFORM=host",
+                    "-DPICO_ENGINE_DEFINITIONS=" + ";".join(SCREEN + definitions)], check=True, stdout=subprocess.DEVNULL)
+    for target in targets:
+        subprocess.run(["cmake", "--build", build_dir, "--target", target, "-j", str(os.cpu_count() or 1)], check=True, stdout=subprocess.DEVNULL)
+    return build_dir
+
+
+def render(build_dir):
+    """Runs the golden renderer of the build, returns the directory of its images."""
+    image_dir = os.path.join(build_dir, "images")
+    shutil.rmtree(image_dir, ignore_errors=True)
+    os.makedirs(image_dir)
+    subprocess.run([os.path.join(build_dir, "src", "benchmark", TARGET), image_dir], check=True)
+    return image_dir
+
+
+def read_ppm(path):
+    """Returns the width, the height and the RGB bytes of a binary PPM."""
+    with open(path, "rb") as f:
+        data = f.read()
+    fields, offset = [], 0
+    while len(fields) < 4:
+        while data[offset:offset + 1].isspace():
+            offset += 1
+        end = offset
+        while not data[end:end + 1].isspace():
+            end += 1
+        fields.append(data[offset:end])
+        offset = end
+    if fields[0] != b"P6" or fields[3] != b"255":
+        raise ValueError("%s is not a binary PPM with 8-bit channels" % path)
+    width, height = int(fields[1]), int(fields[2])
+    return width, height, data[offset + 1:offset + 1 + 3 * width * height]
+
+
+def write_png(path, width, height, rgb):
+    """Writes the RGB bytes as a PNG, the golden images are kept compressed."""
+    def chunk(kind, data):
+        return struct.pack(">I", len(data)) + kind + data + struct.pack(">I", zlib.crc32(kind + data))
+
+    rows = b"".join(b"\x00" + rgb[3 * width * y:3 * width * (y + 1)] for y in range(height))
+    with open(path, "wb") as f:
+        f.write(b"\x89PNG\r\n\x1a\n" + chunk(b"IHDR", struct.pack(">IIBBBBB", width, height, 8, 2, 0, 0, 0)) +
+                chunk(b"IDAT", zlib.compress(rows, 9)) + chunk(b"IEND", b""))
+
+
+def read_png(path):
+    """Returns the width, the height and the RGB bytes of a PNG with 8-bit RGB pixels and no interlacing."""
+    with open(path, "rb") as f:
+        data = f.read()
+    if data[:8] != b"\x89PNG\r\n\x1a\n":
+        raise ValueError("%s is not a PNG" % path)
+    offset, compressed = 8, b""
+    while offset < len(data):
+        length, kind = struct.unpack(">I4s", data[offset:offset + 8])
+        body = data[offset + 8:offset + 8 + length]
+        if kind == b"IHDR":
+            width, height, depth, colour_type, _, _, interlace = struct.unpack(">IIBBBBB", body)
+            if (depth, colour_type, interlace) != (8, 2, 0):
+                raise ValueError("%s does not hold 8-bit RGB pixels without interlacing" % path)
+        elif kind == b"IDAT":
+            compressed += body
+        offset += 12 + length
+
+    # Undoes the filter of every row against the row above, 3 bytes per pixel
+    raw, stride, rgb = zlib.decompress(compressed), 3 * width, bytearray()
+    previous = bytearray(stride)
+    for y in range(height):
+        kind, row = raw[y * (stride + 1)], bytearray(raw[y * (stride + 1) + 1:(y + 1) * (stride + 1)])
+        for i in range(stride):
+            a = row[i - 3] if i >= 3 else 0
+            b = previous[i]
+            c = previous[i - 3] if i >= 3 else 0
+            if kind == 1:
+                row[i] = (row[i] + a) & 0xFF
+            elif kind == 2:
+                row[i] = (row[i] + b) & 0xFF
+            elif kind == 3:
+                row[i] = (row[i] + (a + b) // 2) & 0xFF
+            elif kind == 4:
+                p = a + b - c
+                pa, pb, pc = abs(p - a), abs(p - b), abs(p - c)
+                row[i] = (row[i] + (a if pa <= pb and pa <= pc else b if pb <= pc else c)) & 0xFF
+        rgb += row
+        previous = row
+    return width, height, bytes(rgb)
+
+
+def compare(golden, image):
+    """Returns the maximum channel difference, the PSNR in dB and the number of differing pixels."""
+    max_diff, squared_sum, differing = 0, 0, 0
+    for i in range(0, len(golden), 3):
+        diffs = [abs(golden[i + c] - image[i + c]) for c in range(3)]
+        pixel_diff = max(diffs)
+        if pixel_diff:
+            differing += 1
+            max_diff = max(max_diff, pixel_diff)
+            squared_sum += sum(d * d for d in diffs)
+    psnr = 10.0 * math.log10(255.0 ** 2 * len(golden) / squared_sum) if squared_sum else math.inf
+    return max_diff, psnr, differing
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("golden", nargs="?", default=os.path.join(ROOT, "tools", "golden"), help="directory of the golden images")
+    parser.add_argument("--save", action="store_true", help="store the rendered images as the golden ones")
+    parser.add_argument("--config", action="append", help="only this configuration, may be repeated")
+    parser.add_argument("--define", action="append", default=[], help="definition added to every configuration, may be repeated")
+    parser.add_argument("--build-dir", default=os.path.join(ROOT, "build", "golden"))
+    parser.add_argument("--max-differing", type=float, default=0.001, help="allowed fraction of differing pixels")
+    parser.add_argument("--min-psnr", type=float, default=40.0, help="lowest allowed PSNR in dB")
+    args = parser.parse_args()
+
+    configs = configurations()
+    for name in args.config or []:
+        if name not in configs:
+            sys.exit("unknown configuration %s, the configurations are %s" % (name, ", ".join(configs)))
+    names = args.config or list(configs)
+
+    failures = 0
+    for name in names:
+        reason = expected_failure(configs[name])
+        if args.save and reason:
+            print("%s: expected to fail, %s" % (name, reason))
+            continue
+
+        image_dir = render(build(name, configs[name] + GOLDEN_DEFINITIONS + args.define, args.build_dir, [TARGET]))
+        # A configuration expected to fail is compared with the images it should have rendered
+        golden_name = "-".join(("q16_16" if reason and d in EXPECTED_FAILURES else d.lower()) for d in configs[name])
+        golden_dir = os.path.join(args.golden, "-".join([golden_name] + [d.lower() for d in args.define]))
+
+        if args.save:
+            shutil.rmtree(golden_dir, ignore_errors=True)
+            os.makedirs(golden_dir)
+            for image_name in sorted(os.listdir(image_dir)):
+                write_png(os.path.join(golden_dir, os.path.splitext(image_name)[0] + ".png"), *read_ppm(os.path.join(image_dir, image_name)))
+            print("%s: %d images stored" % (name, len(os.listdir(golden_dir))))
+            continue
+
+        config_failures = 0
+        for image_name in sorted(os.listdir(image_dir)):
+            golden_path = os.path.join(golden_dir, os.path.splitext(image_name)[0] + ".png")
+            if not os.path.exists(golden_path):
+                print("%-28s %-14s no golden image" % (name, image_name))
+                failures += 1
+                continue
+
+            width, height, golden = read_png(golden_path)
+            image_width, image_height, image = read_ppm(os.path.join(image_dir, image_name))
+            if (width, height) != (image_width, image_height):
+                print("%-28s %-14s %dx%d instead of %dx%d" % (name, image_name, image_width, image_height, width, height))
+                config_failures += 1
+                continue
+
+            max_diff, psnr, differing = compare(golden, image)
+            failed = differing > args.max_differing * width * height or psnr < args.min_psnr
+            config_failures += failed
+            print("%-28s %-14s max diff %3d  PSNR %6.2f dB  %6d pixels differ (%5.2f%%)%s"
+                  % (name, image_name, max_diff, psnr, differing, 100.0 * differing / (width * height),
+                     ("  FAILED" if not reason else "  expected failure") if failed else ""))
+
+        if not reason:
+            failures += config_failures
+        elif config_failures:
+            print("%s: expected failure, %s" % (name, reason))
+        else:
+            print("%s: UNEXPECTED PASS, remove it from EXPECTED_FAILURES" % name)
+            failures += 1
+
+    if failures:
+        sys.exit("%d images failed" % failures)
+
+
+if __name__ == "__main__":
+    main()
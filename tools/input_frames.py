@@ -0,0 +1,79 @@
+#!/usr/bin/env python3
+"""Prints the frame times of input replays side by side.
+
+A replay of a key recording renders a frame per physics tick, on the device (INPUT_LOG_EVENT_COUNT
+builds of main.c, CTRL and Y) as well as on the host (the pico-engine-input-replay target), and
+both print an `INPUT FRAME <tick> <us>` line per frame, inside a `LOG` line on the device. Given
+their outputs, the frame times of every run are averaged over windows of ticks and printed in
+columns, with the average, the 99th percentile and the slowest window of each run, and the ratio
+of each run to the first one.
+
+    python3 tools/input_frames.py device.txt host.txt [--window 25]
+"""
+
+import argparse
+import os
+import sys
+
+PREFIX = "INPUT FRAME "
+
+
+def parse(lines):
+    """Returns the frame times of the capture by tick, the last replay of a tick wins."""
+    frames = {}
+    for line in lines:
+        index = line.find(PREFIX)
+        if index < 0:
+            continue
+        fields = line[index + len(PREFIX):].split()
+        if len(fields) >= 2 and fields[0].isdigit() and fields[1].isdigit():
+            frames[int(fields[0])] = int(fields[1])
+    return frames
+
+
+def percentile(values, fraction):
+    """Returns the smallest value that the fraction of the values do not exceed."""
+    values = sorted(values)
+    return values[max(int(len(values) * fraction + 0.999999) - 1, 0)]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("captures", nargs="+")
+    parser.add_argument("--window", type=int, default=25, help="ticks per row, 25 ticks are half a second of the recording")
+    args = parser.parse_args()
+
+    runs = []
+    for capture in args.captures:
+        with open(capture, errors="replace") as f:
+            frames = parse(f)
+        if not frames:
+            sys.exit("no replayed frames found in " + capture)
+        runs.append(frames)
+
+    # Ticks missing from a run, when its replay was stopped early, are left out of every column
+    ticks = sorted(set.intersection(*(set(frames) for frames in runs)))
+    if not ticks:
+        sys.exit("the captures share no replayed ticks")
+
+    names = [os.path.basename(capture)[:12] for capture in args.captures]
+    print("%-11s" % "ticks" + "".join(" %12s" % name for name in names))
+    windows = [[] for _ in runs]
+    for start in range(0, len(ticks), args.window):
+        window_ticks = ticks[start:start + args.window]
+        averages = [sum(frames[tick] for tick in window_ticks) / len(window_ticks) for frames in runs]
+        for run, average in enumerate(averages):
+            windows[run].append(average)
+        print("%5d-%-5d" % (window_ticks[0], window_ticks[-1]) + "".join(" %12.0f" % average for average in averages))
+
+    print()
+    averages = [sum(frames[tick] for tick in ticks) / len(ticks) for frames in runs]
+    for label, values in (("avg us", averages),
+                          ("p99 us", [percentile([frames[tick] for tick in ticks], 0.99) for frames in runs]),
+                          ("worst avg", [max(run_windows) for run_windows in windows])):
+        print("%-11s" % label + "".join(" %12.0f" % value for value in values))
+    print("%-11s" % "ratio" + "".join(" %12.2f" % (average / averages[0]) for average in averages))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,328 @@
+#!/usr/bin/env python3
+"""Generates chains of simplified meshes for the models of a model source file, in place.
+
+Every model whose mesh has unpacked vertices gets a level per --ratio, each simplified from the
+previous one by half-edge collapses ordered by quadric error (Garland and Heckbert), so no new
+positions are made. The collapses work on the positions: the exported meshes split the vertices
+of every face for its texture coordinates, which stay with the corners of the faces. Collapses that
+flip a face or pinch the surface are skipped, and open borders are held by constraint planes.
+
+The levels are written as NAME_lodN arrays and mesh initializers, and the model initializer gets
+`.lods`, `.lod_count` and `.radius`, the bounding sphere around the object origin. A level is used
+while the model covers less of the screen than its `.max_screen_size`, the fraction of the width
+of the viewport where its geometric error projects to --pixel-error pixels. A level whose size is
+not below that of the next one is left out, the next one has no more error and fewer triangles.
+Levels below --min-screen-size are left out as well: a model never covers less of the screen than
+at the far plane, its radius times its scale over far * tan(fovw / 2), so models placed at
+different scales are simplified one call each. Run it after tools/atlas.py and before
+tools/pack_vertices.py and tools/meshlets.py, which handle the levels like any other mesh.
+
+    python3 tools/lod.py scene_models.c [--ratio 0.5 0.25] [--pixel-error 1] [--screen-width 240] [--min-screen-size 0] [MODEL ...]
+"""
+
+import argparse
+import heapq
+import math
+import re
+import sys
+
+import texture_source as ts
+
+MODEL = re.compile(r"(const model_t (\w+) = \{\s*\.mesh\s*=\s*(\w+),.*?)(\n\};)", re.S)
+MESH = r"static const mesh_t %s = \{\s*\.vertices\s*=\s*(\w+),\s*\.indices\s*=\s*(\w+),.*?\n\};\n"
+VERTEX = re.compile(r"\{\{Q_FROM_FLOAT\(([-+0-9.e]+)\), Q_FROM_FLOAT\(([-+0-9.e]+)\), Q_FROM_FLOAT\(([-+0-9.e]+)\)\}, (\{[^}]*\})\}")
+
+# Weight of the planes holding the open borders in place, relative to those of the faces
+BORDER_WEIGHT = 10.0
+# The normal of a face may turn by at most about 80 degrees in a collapse
+MIN_NORMAL_DOT = 0.2
+
+
+def sub(a, b):
+    return [x - y for x, y in zip(a, b)]
+
+
+def dot(a, b):
+    return sum(x * y for x, y in zip(a, b))
+
+
+def cross(a, b):
+    return [a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0]]
+
+
+def plane_quadric(normal, point, weight=1.0):
+    """Returns the quadric of the squared distance to a plane, the upper triangle of the 4x4 matrix."""
+    length = math.sqrt(dot(normal, normal))
+    if length == 0.0:
+        return [0.0] * 10
+    a, b, c = (x / length for x in normal)
+    d = -(a * point[0] + b * point[1] + c * point[2])
+    p = (a, b, c, d)
+    return [weight * p[i] * p[j] for i in range(4) for j in range(i, 4)]
+
+
+def add_quadrics(q, r):
+    return [x + y for x, y in zip(q, r)]
+
+
+def quadric_error(q, v):
+    x, y, z = v
+    return (q[0] * x * x + 2 * q[1] * x * y + 2 * q[2] * x * z + 2 * q[3] * x +
+            q[4] * y * y + 2 * q[5] * y * z + 2 * q[6] * y +
+            q[7] * z * z + 2 * q[8] * z + q[9])
+
+
+def simplify(positions, triangles, target):
+    """Collapses the triangles, lists of 3 position indices, down to target of them.
+
+    Returns the indices of the remaining triangles with their new corners.
+    """
+    corners = [list(t) for t in triangles]
+    alive = [len(set(t)) == 3 for t in triangles]
+    triangles_at = [set() for _ in positions]
+    for t, tri in enumerate(corners):
+        if alive[t]:
+            for p in tri:
+                triangles_at[p].add(t)
+
+    quadrics = [[0.0] * 10 for _ in positions]
+    edge_uses = {}
+    for t, tri in enumerate(corners):
+        if not alive[t]:
+            continue
+        normal = cross(sub(positions[tri[1]], positions[tri[0]]), sub(positions[tri[2]], positions[tri[0]]))
+        q = plane_quadric(normal, positions[tri[0]])
+        for p in tri:
+            quadrics[p] = add_quadrics(quadrics[p], q)
+        for i in range(3):
+            edge = tuple(sorted((tri[i], tri[(i + 1) % 3])))
+            edge_uses.setdefault(edge, []).append((t, normal))
+
+    for (a, b), uses in edge_uses.items():
+        if len(uses) == 1:
+            border_normal = cross(sub(positions[b], positions[a]), uses[0][1])
+            q = plane_quadric(border_normal, positions[a], BORDER_WEIGHT)
+            quadrics[a] = add_quadrics(quadrics[a], q)
+            quadrics[b] = add_quadrics(quadrics[b], q)
+
+    def neighbours(p):
+        return {q for t in triangles_at[p] for q in corners[t]} - {p}
+
+    version = [0] * len(positions)
+    heap = []
+
+    def push_edges(p):
+        for q in neighbours(p):
+            for a, b in ((p, q), (q, p)):
+                cost = quadric_error(add_quadrics(quadrics[a], quadrics[b]), positions[b])
+                heapq.heappush(heap, (cost, a, b, version[a], version[b]))
+
+    for p in range(len(positions)):
+        if triangles_at[p]:
+            push_edges(p)
+
+    def collapse_is_valid(a, b):
+        shared = triangles_at[a] & triangles_at[b]
+        # The link condition, otherwise the surface gets pinched into a non-manifold edge
+        if len(neighbours(a) & neighbours(b)) != len(shared):
+            return False
+        for t in triangles_at[a] - shared:
+            tri = corners[t]
+            old = cross(sub(positions[tri[1]], positions[tri[0]]), sub(positions[tri[2]], positions[tri[0]]))
+            moved = [b if p == a else p for p in tri]
+            new = cross(sub(positions[moved[1]], positions[moved[0]]), sub(positions[moved[2]], positions[moved[0]]))
+            if dot(old, new) <= MIN_NORMAL_DOT * math.sqrt(dot(old, old) * dot(new, new)):
+                return False
+        return True
+
+    count = sum(alive)
+    while count > target and heap:
+        cost, a, b, version_a, version_b = heapq.heappop(heap)
+        if version_a != version[a] or version_b != version[b] or not triangles_at[a] or not collapse_is_valid(a, b):
+            continue
+
+        for t in list(triangles_at[a]):
+            if b in corners[t]:
+                alive[t] = False
+                count -= 1
+                for p in corners[t]:
+                    triangles_at[p].discard(t)
+            else:
+                corners[t] = [b if p == a else p for p in corners[t]]
+                triangles_at[b].add(t)
+        triangles_at[a] = set()
+
+        quadrics[b] = add_quadrics(quadrics[a], quadrics[b])
+        for p in neighbours(b) | {a, b}:
+            version[p] += 1
+        push_edges(b)
+
+    return [(t, corners[t]) for t in range(len(corners)) if alive[t]]
+
+
+def point_triangle_distance(p, a, b, c):
+    """Returns the distance from p to the closest point of the triangle abc (Ericson, Real-Time Collision Detection)."""
+    ab, ac, ap = sub(b, a), sub(c, a), sub(p, a)
+    d1, d2 = dot(ab, ap), dot(ac, ap)
+    if d1 <= 0 and d2 <= 0:
+        closest = a
+    else:
+        bp = sub(p, b)
+        d3, d4 = dot(ab, bp), dot(ac, bp)
+        cp = sub(p, c)
+        d5, d6 = dot(ab, cp), dot(ac, cp)
+        vc, vb, va = d1 * d4 - d3 * d2, d5 * d2 - d1 * d6, d3 * d6 - d5 * d4
+        if d3 >= 0 and d4 <= d3:
+            closest = b
+        elif d6 >= 0 and d5 <= d6:
+            closest = c
+        elif vc <= 0 and d1 >= 0 and d3 <= 0:
+            closest = [x + y * d1 / (d1 - d3) for x, y in zip(a, ab)]
+        elif vb <= 0 and d2 >= 0 and d6 <= 0:
+            closest = [x + y * d2 / (d2 - d6) for x, y in zip(a, ac)]
+        elif va <= 0 and d4 - d3 >= 0 and d5 - d6 >= 0:
+            w = (d4 - d3) / ((d4 - d3) + (d5 - d6))
+            closest = [x + (y - x) * w for x, y in zip(b, c)]
+        else:
+            denominator = va + vb + vc
+            if denominator == 0.0:
+                closest = a
+            else:
+                v, w = vb / denominator, vc / denominator
+                closest = [x + y * v + z * w for x, y, z in zip(a, ab, ac)]
+    d = sub(p, closest)
+    return math.sqrt(dot(d, d))
+
+
+def surface_error(positions, used, triangles):
+    """Returns the largest distance from the used positions to the closest of the triangles."""
+    return max(min(point_triangle_distance(positions[p], *(positions[c] for c in tri)) for tri in triangles) for p in used)
+
+
+def format_vertex(position, tex_coord):
+    return "{{%s}, %s}" % (", ".join("Q_FROM_FLOAT(%+f)" % c for c in position), tex_coord)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("source")
+    parser.add_argument("models", nargs="*", help="models to simplify, all of them by default")
+    parser.add_argument("--ratio", type=float, nargs="+", default=[0.5, 0.25], help="triangles of each level over those of the model")
+    parser.add_argument("--pixel-error", type=float, default=1.0)
+    parser.add_argument("--screen-width", type=int, default=240)
+    parser.add_argument("--min-screen-size", type=float, default=0.0, help="smallest fraction of the screen width the models cover")
+    args = parser.parse_args()
+
+    with open(args.source) as f:
+        source = f.read()
+
+    models = [m for m in MODEL.finditer(source) if not args.models or m.group(2) in args.models]
+    if not models:
+        sys.exit("no model initializers found in " + args.source)
+
+    done, skipped = {}, set()
+    for model_match in models:
+        model, mesh = model_match.group(2), model_match.group(3)
+        if ".lods" in model_match.group(1):
+            sys.exit("%s already has levels of detail" % model)
+        if mesh in done or mesh in skipped:
+            continue
+
+        mesh_match = re.search(MESH % re.escape(mesh), source, re.S)
+        if mesh_match is None:
+            sys.exit("mesh %s of %s with unpacked vertices and an index array not found, run it before "
+                     "tools/pack_vertices.py and tools/meshlets.py" % (mesh, model))
+        vertices_name, indices_name = mesh_match.group(1), mesh_match.group(2)
+        vertex_match = ts.array_pattern(vertices_name, r"pgl_vertex_t").search(source)
+        index_match = ts.array_pattern(indices_name, r"uint16_t").search(source)
+
+        vertices = VERTEX.findall(vertex_match.group(2))
+        indices = [int(i) for i in re.findall(r"\d+", index_match.group(2))]
+
+        # Faces are connected through their positions, the texture coordinates stay with the corners
+        positions, position_of, tex_coords = [], {}, []
+        for x, y, z, tex_coord in vertices:
+            key = (float(x), float(y), float(z))
+            position_of.setdefault(key, len(positions))
+            if position_of[key] == len(positions):
+                positions.append(list(key))
+            tex_coords.append(tex_coord)
+        vertex_positions = [position_of[(float(x), float(y), float(z))] for x, y, z, _ in vertices]
+        triangles = [[indices[i + c] for c in range(3)] for i in range(0, len(indices), 3)]
+
+        radius = max(math.sqrt(dot(p, p)) for p in positions)
+        levels, previous = [], [[vertex_positions[v] for v in tri] for tri in triangles]
+        previous_ids = list(range(len(triangles)))
+        for level, ratio in enumerate(args.ratio, start=1):
+            remaining = simplify(positions, previous, max(int(len(triangles) * ratio), 1))
+            previous_ids = [previous_ids[t] for t, _ in remaining]
+            previous = [tri for _, tri in remaining]
+            # Measured against the positions of the model, the errors of the levels add up along the chain
+            error = surface_error(positions, set(vertex_positions), previous)
+
+            out_vertices, out_indices, vertex_of = [], [], {}
+            for original, tri in zip(previous_ids, previous):
+                for corner, p in enumerate(tri):
+                    key = (p, tex_coords[triangles[original][corner]])
+                    if key not in vertex_of:
+                        vertex_of[key] = len(out_vertices)
+                        out_vertices.append(format_vertex(positions[p], key[1]))
+                    out_indices.append(vertex_of[key])
+
+            # Rounded like the initializers, so that the levels kept differ in them too
+            screen_size = round(min(args.pixel_error * 2.0 * radius / (max(error, 1e-6) * args.screen_width), 1.0), 6)
+            levels.append((out_vertices, out_indices, error, screen_size))
+            print("%s level %d: %d triangles instead of %d, %d vertices, error %.4f, below %.3f of the screen width"
+                  % (mesh, level, len(out_indices) // 3, len(triangles), len(out_vertices), error, screen_size))
+
+        # The thresholds strictly decrease along the levels kept
+        kept = []
+        for level in reversed(levels):
+            if level[3] < args.min_screen_size:
+                print("%s: a level below %.3f of the screen width is never used, left out" % (mesh, level[3]))
+            elif kept and level[3] <= kept[-1][3]:
+                print("%s: a level below %.3f of the screen width is no coarser than the next one, left out" % (mesh, level[3]))
+            else:
+                kept.append(level)
+        levels = kept[::-1]
+        if not levels:
+            skipped.add(mesh)
+            continue
+
+        vertex_arrays, index_arrays, meshes, lods = "", "", "", []
+        for level, (out_vertices, out_indices, _, screen_size) in enumerate(levels, start=1):
+            vertices_lod, indices_lod, mesh_lod = ("%s_lod%d" % (name, level) for name in (vertices_name, indices_name, mesh))
+            # The suffix goes before _vertices and _indices, the naming tools/meshlets.py derives its arrays from
+            vertices_lod = re.sub(r"_vertices_lod(\d+)$", r"_lod\1_vertices", vertices_lod)
+            indices_lod = re.sub(r"_indices_lod(\d+)$", r"_lod\1_indices", indices_lod)
+            vertex_arrays += "\nstatic const pgl_vertex_t %s[] = {\n%s\n};\n" % (vertices_lod, "\n".join("    %s," % v for v in out_vertices))
+            index_arrays += "\nstatic const uint16_t %s[] = {\n%s\n};\n" % (indices_lod, "\n".join(
+                "    %d, %d, %d," % tuple(out_indices[i:i + 3]) for i in range(0, len(out_indices), 3)))
+            meshes += ("\nstatic const mesh_t %s = {\n    .vertices = %s,\n    .indices  = %s,\n    .vertex_count = COUNT_OF(%s),\n"
+                       "    .index_count  = COUNT_OF(%s),\n};\n" % (mesh_lod, vertices_lod, indices_lod, vertices_lod, indices_lod))
+            lods.append("    { .mesh = %s, .max_screen_size = Q_FROM_FLOAT(%+f) }," % (mesh_lod, screen_size))
+        meshes += "\nstatic const model_lod_t %s_lods[] = {\n%s\n};\n" % (mesh, "\n".join(lods))
+
+        # Inserted from the end of the file, the models come after the meshes and the meshes after the arrays
+        mesh_match = re.search(MESH % re.escape(mesh), source, re.S)
+        source = source[:mesh_match.end()] + meshes + source[mesh_match.end():]
+        index_match = ts.array_pattern(indices_name, r"uint16_t").search(source)
+        source = source[:index_match.end()] + index_arrays + source[index_match.end():]
+        vertex_match = ts.array_pattern(vertices_name, r"pgl_vertex_t").search(source)
+        source = source[:vertex_match.end()] + vertex_arrays + source[vertex_match.end():]
+        done[mesh] = radius
+
+    def model_with_lods(match):
+        mesh = match.group(3)
+        if mesh not in done:
+            return match.group(0)
+        return (match.group(1) + "\n    .lods = %s_lods,\n    .lod_count = COUNT_OF(%s_lods),\n    .radius = Q_FROM_FLOAT(%+f),"
+                % (mesh, mesh, done[mesh]) + match.group(4))
+
+    source = MODEL.sub(model_with_lods, source)
+    with open(args.source, "w") as f:
+        f.write(source)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,201 @@
+#!/usr/bin/env python3
+"""Splits the meshes of a model source file into meshlets, in place.
+
+Every `static const mesh_t` initializer with an index array is split into clusters of at most
+64 vertices and 124 triangles, grown from a seed triangle by the triangles adding the fewest
+vertices, facing the same way and lying closest to it. The exported meshes split the vertices of
+every face, so that a triangle adds as many vertices wherever it lies: growing through connected
+triangles alone gathered faces turning every way, and left the cones of most meshlets too wide to
+cull anything. Each meshlet gets a bounding sphere and a normal cone, which pgl_draw_meshlets tests
+before shading any vertex. The
+vertices of a meshlet are made consecutive, vertices shared by two meshlets are duplicated, and
+its triangles index them with 8-bit local indices: NAME_indices is replaced by NAME_meshlets and
+NAME_meshlet_indices. The bounds are computed in the space of the vertex array, so run it after
+tools/pack_vertices.py.
+
+    python3 tools/meshlets.py scene_models.c [--max-vertices 64] [--max-triangles 124]
+"""
+
+import argparse
+import math
+import re
+import sys
+
+import texture_source as ts
+
+MESH = re.compile(r"(static const mesh_t (\w+) = \{\s*)\.(packed_)?vertices\s*=\s*(\w+),(.*?)(\n\};)", re.S)
+VERTEX = re.compile(r"\{\{([^}]*)\}, \{[^}]*\}\}")
+FLOAT = re.compile(r"Q_FROM_FLOAT\(([-+0-9.e]+)\)")
+
+# The packed positions are in [-1, 1), unpacked with 15 fractional bits like pgl does, and so are the bounds written for them
+PACKED_POSITION_ONE = 32768
+
+# How much a triangle facing another way than the meshlet weighs against one more vertex
+NORMAL_WEIGHT = 4.0
+# How much the distance of a triangle from the centroid of the meshlet weighs, in the units of the vertices
+DISTANCE_WEIGHT = 1.0
+# Normals this close to perpendicular to the axis make the cone too narrow to cull anything
+MIN_CONE_DOT = 0.1
+# Widens the cones against the rounding of the fixed point tests
+CONE_MARGIN = 0.02
+NO_CONE_CUTOFF = 2.0
+
+MESHLET_BYTES = 52
+
+
+def sub(a, b):
+    return [x - y for x, y in zip(a, b)]
+
+
+def dot(a, b):
+    return sum(x * y for x, y in zip(a, b))
+
+
+def cross(a, b):
+    return [a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0]]
+
+
+def normalise(a):
+    length = math.sqrt(dot(a, a))
+    return [x / length for x in a] if length > 0.0 else None
+
+
+def build(positions, triangles, max_vertices, max_triangles):
+    """Returns the meshlets as lists of triangle indices."""
+    normals = [normalise(cross(sub(positions[b], positions[a]), sub(positions[c], positions[a]))) for a, b, c in triangles]
+    centroids = [[sum(positions[i][axis] for i in t) / 3 for axis in range(3)] for t in triangles]
+
+    assigned = [False] * len(triangles)
+    meshlets, next_seed = [], 0
+    while next_seed < len(triangles):
+        if assigned[next_seed]:
+            next_seed += 1
+            continue
+
+        meshlet, vertices = [], set()
+        normal_sum, centroid_sum = [0.0, 0.0, 0.0], [0.0, 0.0, 0.0]
+        candidate = next_seed
+        while candidate is not None:
+            assigned[candidate] = True
+            meshlet.append(candidate)
+            vertices.update(triangles[candidate])
+            if normals[candidate] is not None:
+                normal_sum = [s + n for s, n in zip(normal_sum, normals[candidate])]
+            centroid_sum = [s + c for s, c in zip(centroid_sum, centroids[candidate])]
+            if len(meshlet) == max_triangles:
+                break
+
+            axis = normalise(normal_sum)
+            centre = [s / len(meshlet) for s in centroid_sum]
+            def cost(t):
+                facing = dot(normals[t], axis) if normals[t] is not None and axis is not None else 1.0
+                distance = math.sqrt(dot(sub(centroids[t], centre), sub(centroids[t], centre)))
+                return len(set(triangles[t]) - vertices) + NORMAL_WEIGHT * (1.0 - facing) + DISTANCE_WEIGHT * distance
+
+            candidates = [t for t in range(next_seed, len(triangles)) if not assigned[t] and len(vertices | set(triangles[t])) <= max_vertices]
+            candidate = min(candidates, key=lambda t: (cost(t), t)) if candidates else None
+        meshlets.append(meshlet)
+    return meshlets, normals
+
+
+def bounds(positions, vertices, normals):
+    """Returns the bounding sphere and the normal cone of a meshlet."""
+    points = [positions[i] for i in vertices]
+    centre = [(min(p[axis] for p in points) + max(p[axis] for p in points)) / 2 for axis in range(3)]
+    radius = max(math.sqrt(dot(sub(p, centre), sub(p, centre))) for p in points) * 1.001 + 1e-4
+
+    normals = [(n, c) for n, c in normals if n is not None]
+    axis = normalise([sum(n[axis] for n, _ in normals) for axis in range(3)]) if normals else None
+    min_dot = min(min(dot(n, axis) for n, _ in normals), 1.0) if axis is not None else 0.0
+    if axis is None or min_dot < MIN_CONE_DOT:
+        return centre, radius, centre, [1.0, 0.0, 0.0], NO_CONE_CUTOFF
+
+    # The apex lies behind every plane of the triangles, as far along -axis as the furthest one needs
+    t = max(dot(sub(centre, corner), n) / dot(axis, n) for n, corner in normals)
+    apex = [c - a * t for c, a in zip(centre, axis)]
+    cutoff = min(math.sqrt(1.0 - min_dot * min_dot) + CONE_MARGIN, 1.0)
+    return centre, radius, apex, axis, cutoff
+
+
+def q_vec3(values):
+    return "{{%s}}" % ", ".join("Q_FROM_FLOAT(%+f)" % v for v in values)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("source")
+    parser.add_argument("--max-vertices", type=int, default=64)
+    parser.add_argument("--max-triangles", type=int, default=124)
+    args = parser.parse_args()
+    if not (3 <= args.max_vertices <= 256 and 1 <= args.max_triangles <= 255):
+        sys.exit("meshlets index at most 256 vertices with 8 bits and count at most 255 triangles")
+
+    with open(args.source) as f:
+        source = f.read()
+
+    meshes = [m for m in MESH.finditer(source) if re.search(r"\.indices\s*=", m.group(5))]
+    if not meshes:
+        sys.exit("no mesh initializers with an index array found in " + args.source)
+
+    for mesh_match in meshes:
+        mesh, packed, vertices_name = mesh_match.group(2), mesh_match.group(3) is not None, mesh_match.group(4)
+        indices_name = re.search(r"\.indices\s*=\s*(\w+)", mesh_match.group(5)).group(1)
+        prefix = indices_name[:-len("_indices")] if indices_name.endswith("_indices") else indices_name
+
+        vertex_match = ts.array_pattern(vertices_name, r"pgl_packed_vertex_t" if packed else r"pgl_vertex_t").search(source)
+        index_match = ts.array_pattern(indices_name, r"uint16_t").search(source)
+        if vertex_match is None or index_match is None:
+            sys.exit("arrays of %s not found" % mesh)
+
+        vertices = [m.group(0) for m in VERTEX.finditer(vertex_match.group(2))]
+        if packed:
+            positions = [[int(c) / PACKED_POSITION_ONE for c in m.group(1).split(",")] for m in VERTEX.finditer(vertex_match.group(2))]
+        else:
+            positions = [[float(c) for c in FLOAT.findall(m.group(1))] for m in VERTEX.finditer(vertex_match.group(2))]
+        indices = [int(i) for i in re.findall(r"\d+", index_match.group(2))]
+        triangles = [indices[i:i + 3] for i in range(0, len(indices), 3)]
+
+        clusters, normals = build(positions, triangles, args.max_vertices, args.max_triangles)
+
+        out_vertices, local_indices, meshlet_lines = [], [], []
+        for cluster in clusters:
+            local = {}
+            for t in cluster:
+                for i in triangles[t]:
+                    local.setdefault(i, len(local))
+
+            centre, radius, apex, axis, cutoff = bounds(positions, local, [(normals[t], positions[triangles[t][0]]) for t in cluster])
+            meshlet_lines.append("    { .centre = %s, .radius = Q_FROM_FLOAT(%+f), .cone_apex = %s, .cone_axis = %s, .cone_cutoff = Q_FROM_FLOAT(%+f), "
+                                 ".vertex_offset = %d, .index_offset = %d, .vertex_count = %d, .triangle_count = %d },"
+                                 % (q_vec3(centre), radius, q_vec3(apex), q_vec3(axis), cutoff,
+                                    len(out_vertices), 3 * len(local_indices), len(local), len(cluster)))
+            out_vertices += [vertices[i] for i in local]
+            local_indices += [[local[i] for i in triangles[t]] for t in cluster]
+
+        if len(out_vertices) > 0xffff:
+            sys.exit("%s: %d vertices after the split, more than 16-bit offsets address" % (mesh, len(out_vertices)))
+
+        cones = sum(1 for line in meshlet_lines if "cone_cutoff = Q_FROM_FLOAT(%+f)" % NO_CONE_CUTOFF not in line)
+        print("%s: %d meshlets (%d with a cone), %d vertices instead of %d, %d index bytes instead of %d"
+              % (mesh, len(clusters), cones, len(out_vertices), len(vertices),
+                 3 * len(local_indices) + MESHLET_BYTES * len(clusters), 2 * len(indices)))
+
+        vertex_lines = ["    %s," % vertex for vertex in out_vertices]
+        source = source[:vertex_match.start(2)] + "\n" + "\n".join(vertex_lines) + "\n" + source[vertex_match.end(2):]
+
+        index_match = ts.array_pattern(indices_name, r"uint16_t").search(source)
+        arrays = "static const pgl_meshlet_t %s_meshlets[] = {\n%s\n};\n\n" % (prefix, "\n".join(meshlet_lines))
+        arrays += "static const uint8_t %s_meshlet_indices[] = {\n%s\n};\n" % (prefix, "\n".join("    %d, %d, %d," % tuple(t) for t in local_indices))
+        source = source[:index_match.start()] + arrays + source[index_match.end():]
+
+        source = re.sub(r"(static const mesh_t %s = \{.*?)\.indices(\s*)= %s,(.*?)\.index_count(\s*)= COUNT_OF\(%s\),(.*?\n\};)"
+                        % (re.escape(mesh), re.escape(indices_name), re.escape(indices_name)),
+                        lambda m: "%s.meshlets = %s_meshlets,\n    .meshlet_indices = %s_meshlet_indices,%s.meshlet_count = COUNT_OF(%s_meshlets),%s"
+                        % (m.group(1), prefix, prefix, m.group(3), prefix, m.group(5)), source, count=1, flags=re.S)
+
+    with open(args.source, "w") as f:
+        f.write(source)
+
+
+if __name__ == "__main__":
+    main()
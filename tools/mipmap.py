@@ -0,0 +1,82 @@
+#!/usr/bin/env python3
+"""Generates the mip chains of the colour textures in a model source file, in place.
+
+For every `.texture = { .texels = NAME, ... }` initializer of a colour texture, the levels
+1 to min(width_bits, height_bits) of NAME are box-filtered into NAME_mipmaps, which is placed
+right after NAME, and the initializer is updated to reference it. Running it again regenerates
+the chains from the base levels. Indexed textures are skipped, run it before tools/quantise.py.
+
+    python3 tools/mipmap.py scene_models.c [--format rgb565|rgb332]
+"""
+
+import argparse
+import sys
+
+import texture_source as ts
+
+
+def downsample(texels, width, height, fmt):
+    half_width, half_height = width // 2, height // 2
+    out = []
+    for y in range(half_height):
+        for x in range(half_width):
+            quad = [texels[(2 * y + dy) * width + 2 * x + dx] for dy in (0, 1) for dx in (0, 1)]
+            channels = [ts.unpack(c, fmt) for c in quad]
+            out.append(ts.pack(*[(sum(c[i] for c in channels) + 2) // 4 for i in range(3)], fmt))
+    return out
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("source")
+    parser.add_argument("--format", choices=ts.COLOUR_FORMATS.keys(), default="rgb565")
+    args = parser.parse_args()
+
+    with open(args.source) as f:
+        source = f.read()
+
+    textures = ts.textures(source)
+    if not textures:
+        sys.exit("no texture initializers found in " + args.source)
+
+    for name, fields in textures.items():
+        if ts.is_indexed(fields):
+            print("%s: indexed, skipped" % name)
+            continue
+        if ts.is_morton(fields):
+            sys.exit("%s has the Morton layout, run tools/swizzle.py --linear first" % name)
+
+        mipmaps_name = name + "_mipmaps"
+        source = ts.remove_array(source, mipmaps_name)
+
+        match = ts.find_array(source, name)
+        if match is None:
+            sys.exit("texture array %s not found" % name)
+
+        width_bits, height_bits = int(fields["width_bits"]), int(fields["height_bits"])
+        width, height = 1 << width_bits, 1 << height_bits
+        texels = ts.array_values(match)
+        if len(texels) != width * height:
+            sys.exit("%s has %d texels, expected %dx%d" % (name, len(texels), width, height))
+
+        rows, comments = [], {}
+        level_count = min(width_bits, height_bits) + 1
+        for level in range(1, level_count):
+            texels = downsample(texels, width, height, args.format)
+            width, height = width // 2, height // 2
+            comments[len(rows)] = "Level %d: %dx%d" % (level, width, height)
+            rows += [texels[y * width:(y + 1) * width] for y in range(height)]
+
+        array = ts.format_array("colour_t", mipmaps_name, rows, ts.COLOUR_FORMATS[args.format][3], comments)
+        source = source[:match.end()] + "\n" + array + source[match.end():]
+
+        fields.update(mipmaps=mipmaps_name, level_count=str(level_count))
+        source = ts.replace_texture(source, fields)
+        print("%s: %d levels" % (name, level_count))
+
+    with open(args.source, "w") as f:
+        f.write(source)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,166 @@
+#!/usr/bin/env python3
+"""Orders the meshlets of a model source file for fewer shaded fragments, in place.
+
+pgl shades the vertices of a meshlet once per draw and has no post-transform cache, so vertex
+cache orders (the ACMR of a FIFO cache) change nothing. What the order of the triangles does
+change is overdraw: the forward path tests the depth of a fragment before texturing it, so the
+surfaces drawn first should be the ones most likely in front. For every `static const mesh_t`
+initializer split by tools/meshlets.py, the meshlets are sorted outside in with the view
+independent measure of Sander et al. (Fast Triangle Reordering for Vertex Locality and Reduced
+Overdraw): how far the centroid of a meshlet lies out of the centre of the mesh along its average
+normal. The vertices and the local indices are rewritten in the new order, so that the fetches
+still walk the arrays forwards through the flash cache. The overdraw is estimated before and
+after by rasterising the mesh from directions around it, as shaded fragments per covered pixel,
+and a mesh keeps its order when the estimate does not improve.
+The deferred texturing and span buffer paths shade every pixel once, whatever the order.
+Run it after tools/meshlets.py.
+
+    python3 tools/optimise_mesh.py scene_models.c [--views 12] [--resolution 64]
+"""
+
+import argparse
+import math
+import re
+import sys
+
+import meshlets as ml
+import texture_source as ts
+
+MESH = re.compile(r"static const mesh_t (\w+) = \{\s*\.(packed_)?vertices\s*=\s*(\w+),\s*\.meshlets\s*=\s*(\w+),\s*"
+                  r"\.meshlet_indices\s*=\s*(\w+),(.*?)\n\};", re.S)
+MESHLET = re.compile(r"    \{ (.*?\.vertex_offset = )(\d+)(, \.index_offset = )(\d+)(, \.vertex_count = )(\d+)(, \.triangle_count = )(\d+)( \},)")
+
+
+def overdraw(positions, triangles, view_count, resolution):
+    """Returns the fragments passing the depth test per covered pixel, averaged over orthographic views around the mesh."""
+    centre = [(min(p[axis] for p in positions) + max(p[axis] for p in positions)) / 2 for axis in range(3)]
+    radius = max(math.sqrt(ml.dot(ml.sub(p, centre), ml.sub(p, centre))) for p in positions) or 1.0
+
+    shaded, covered = 0, 0
+    for view in range(view_count):
+        # Directions spread evenly over the sphere on a Fibonacci spiral
+        z = 1.0 - (2.0 * view + 1.0) / view_count
+        angle = view * math.pi * (3.0 - math.sqrt(5.0))
+        forward = [math.sqrt(1.0 - z * z) * math.cos(angle), math.sqrt(1.0 - z * z) * math.sin(angle), z]
+        right = ml.normalise(ml.cross(forward, [0.0, 1.0, 0.0] if abs(forward[1]) < 0.9 else [1.0, 0.0, 0.0]))
+        up = ml.cross(right, forward)
+
+        scale = (resolution - 1) / (2.0 * radius)
+        screen = [((ml.dot(ml.sub(p, centre), right) + radius) * scale, (ml.dot(ml.sub(p, centre), up) + radius) * scale,
+                   ml.dot(ml.sub(p, centre), forward)) for p in positions]
+        depths = [[math.inf] * resolution for _ in range(resolution)]
+        for triangle in triangles:
+            (x0, y0, z0), (x1, y1, z1), (x2, y2, z2) = (screen[i] for i in triangle)
+            area = (x1 - x0) * (y2 - y0) - (x2 - x0) * (y1 - y0)
+            if area <= 0.0:
+                # Facing away, or covering no pixel centre
+                continue
+            for y in range(max(math.ceil(min(y0, y1, y2)), 0), min(math.floor(max(y0, y1, y2)), resolution - 1) + 1):
+                for x in range(max(math.ceil(min(x0, x1, x2)), 0), min(math.floor(max(x0, x1, x2)), resolution - 1) + 1):
+                    w0 = (x1 - x) * (y2 - y) - (x2 - x) * (y1 - y)
+                    w1 = (x2 - x) * (y0 - y) - (x0 - x) * (y2 - y)
+                    w2 = area - w0 - w1
+                    if w0 < 0.0 or w1 < 0.0 or w2 < 0.0:
+                        continue
+                    depth = (w0 * z0 + w1 * z1 + w2 * z2) / area
+                    if depth < depths[y][x]:
+                        covered += depths[y][x] == math.inf
+                        depths[y][x] = depth
+                        shaded += 1
+    return shaded / covered if covered else 1.0
+
+
+def order(positions, clusters):
+    """Returns the indices of the clusters, given as lists of triangles, sorted outside in."""
+    areas, centroids, normals = [], [], []
+    for cluster in clusters:
+        area_sum, centroid_sum, normal_sum = 0.0, [0.0, 0.0, 0.0], [0.0, 0.0, 0.0]
+        for a, b, c in cluster:
+            normal = ml.cross(ml.sub(positions[b], positions[a]), ml.sub(positions[c], positions[a]))
+            area = math.sqrt(ml.dot(normal, normal)) / 2
+            area_sum += area
+            centroid_sum = [s + area * (positions[a][axis] + positions[b][axis] + positions[c][axis]) / 3 for axis, s in enumerate(centroid_sum)]
+            normal_sum = [s + n for s, n in zip(normal_sum, normal)]
+        areas.append(area_sum)
+        centroids.append([s / area_sum for s in centroid_sum] if area_sum > 0.0 else list(positions[cluster[0][0]]))
+        normals.append(ml.normalise(normal_sum) or [0.0, 0.0, 0.0])
+
+    total = sum(areas) or 1.0
+    centre = [sum(area * centroid[axis] for area, centroid in zip(areas, centroids)) / total for axis in range(3)]
+    return sorted(range(len(clusters)), key=lambda m: -ml.dot(ml.sub(centroids[m], centre), normals[m]))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("source")
+    parser.add_argument("--views", type=int, default=12, help="directions the overdraw is estimated from")
+    parser.add_argument("--resolution", type=int, default=64, help="pixels across the mesh in every view")
+    args = parser.parse_args()
+
+    with open(args.source) as f:
+        source = f.read()
+
+    meshes = MESH.findall(source)
+    if not meshes:
+        sys.exit("no mesh initializers split into meshlets found in " + args.source + ", run tools/meshlets.py first")
+
+    vertex_arrays = [vertices_name for _, _, vertices_name, _, _, _ in meshes]
+    for mesh, packed, vertices_name, meshlets_name, indices_name, body in meshes:
+        if vertex_arrays.count(vertices_name) > 1:
+            sys.exit("%s: the vertex array %s is shared with another mesh" % (mesh, vertices_name))
+
+        vertex_match = ts.array_pattern(vertices_name, r"pgl_packed_vertex_t" if packed else r"pgl_vertex_t").search(source)
+        meshlet_match = ts.array_pattern(meshlets_name, r"pgl_meshlet_t").search(source)
+        index_match = ts.array_pattern(indices_name, r"uint8_t").search(source)
+        if vertex_match is None or meshlet_match is None or index_match is None:
+            sys.exit("arrays of %s not found" % mesh)
+
+        vertices = [m.group(0) for m in ml.VERTEX.finditer(vertex_match.group(2))]
+        if packed:
+            # The packed positions are scaled back by the bounds of the mesh, the order depends on the shape in model space
+            origin, extent = ([float(v) for v in ml.FLOAT.findall(re.search(r"\.%s\s*=\s*(\{\{.*?\}\})" % field, body).group(1))]
+                              for field in ("origin", "extent"))
+            positions = [[o + int(c) / ml.PACKED_POSITION_ONE * e for c, o, e in zip(m.group(1).split(","), origin, extent)]
+                         for m in ml.VERTEX.finditer(vertex_match.group(2))]
+        else:
+            positions = [[float(c) for c in ml.FLOAT.findall(m.group(1))] for m in ml.VERTEX.finditer(vertex_match.group(2))]
+        indices = [int(i) for i in re.findall(r"\d+", index_match.group(2))]
+        meshlet_lines = MESHLET.findall(meshlet_match.group(2))
+
+        # The triangles of every meshlet, indexing the whole vertex array
+        clusters = []
+        for line in meshlet_lines:
+            vertex_offset, index_offset, triangle_count = int(line[1]), int(line[3]), int(line[7])
+            local = indices[index_offset:index_offset + 3 * triangle_count]
+            clusters.append([[vertex_offset + i for i in local[3 * t:3 * t + 3]] for t in range(triangle_count)])
+
+        before = overdraw(positions, [t for cluster in clusters for t in cluster], args.views, args.resolution)
+        permutation = order(positions, clusters)
+        after = overdraw(positions, [t for m in permutation for t in clusters[m]], args.views, args.resolution)
+        print("%s: %d meshlets, overdraw %.3f -> %.3f from %d views%s" % (mesh, len(clusters), before, after, args.views,
+                                                                           "" if after < before else ", order kept"))
+        if after >= before:
+            # Few meshlets leave the measure little to work with, a worse estimate keeps the order of tools/meshlets.py
+            permutation = list(range(len(clusters)))
+
+        out_vertices, out_indices, out_lines = [], [], []
+        for m in permutation:
+            line = meshlet_lines[m]
+            vertex_offset, index_offset, vertex_count, triangle_count = int(line[1]), int(line[3]), int(line[5]), int(line[7])
+            out_lines.append("    { %s%d%s%d%s%d%s%d%s" % (line[0], len(out_vertices), line[2], len(out_indices), line[4], vertex_count,
+                                                         line[6], triangle_count, line[8]))
+            out_vertices += vertices[vertex_offset:vertex_offset + vertex_count]
+            out_indices += indices[index_offset:index_offset + 3 * triangle_count]
+
+        for name, element_type, lines in ((vertices_name, r"pgl_packed_vertex_t|pgl_vertex_t", ["    %s," % vertex for vertex in out_vertices]),
+                                          (meshlets_name, r"pgl_meshlet_t", out_lines),
+                                          (indices_name, r"uint8_t", ["    %d, %d, %d," % tuple(out_indices[i:i + 3]) for i in range(0, len(out_indices), 3)])):
+            match = ts.array_pattern(name, element_type).search(source)
+            source = source[:match.start(2)] + "\n" + "\n".join(lines) + "\n" + source[match.end(2):]
+
+    with open(args.source, "w") as f:
+        f.write(source)
+
+
+if __name__ == "__main__":
+    main()
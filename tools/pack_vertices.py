@@ -0,0 +1,106 @@
+#!/usr/bin/env python3
+"""Converts the vertex arrays of a model source file into pgl_packed_vertex_t arrays, in place.
+
+Every `static const mesh_t` initializer referencing a pgl_vertex_t array gets it packed: positions
+become 16-bit values relative to the bounding box of the mesh, stored as `.origin` (its centre) and
+`.extent` (its half size) so that model_draw can fold them into the model matrix, and texture
+coordinates become 16-bit fractions. Texture coordinates must lie in [0, 1], since the packed ones
+cannot repeat. Run it after tools/atlas.py, which remaps the unpacked texture coordinates, and
+before tools/meshlets.py, which bounds the meshlets in the space of the packed positions.
+
+    python3 tools/pack_vertices.py scene_models.c
+"""
+
+import argparse
+import re
+import sys
+
+import texture_source as ts
+
+MESH = re.compile(r"(static const mesh_t \w+ = \{\s*)\.vertices(\s*=\s*)(\w+)(,.*?)(\n\};)", re.S)
+VERTEX = re.compile(r"\{\{Q_FROM_FLOAT\(([-+0-9.e]+)\), Q_FROM_FLOAT\(([-+0-9.e]+)\), Q_FROM_FLOAT\(([-+0-9.e]+)\)\}, "
+                    r"\{Q_FROM_FLOAT\(([-+0-9.e]+)\), Q_FROM_FLOAT\(([-+0-9.e]+)\)\}\}")
+
+# pgl unpacks positions with 15 fractional bits, the largest packed value falls just short of the extent
+POSITION_ONE = 32768
+POSITION_MAX = 32767
+TEX_COORD_ONE = 65536
+
+
+def pack(vertices):
+    """Returns the origin, the extent and the packed (position, tex_coord) of the vertices."""
+    origin, extent = [], []
+    for axis in range(3):
+        low, high = min(v[axis] for v in vertices), max(v[axis] for v in vertices)
+        # Rounded as they are written, so that the positions are packed against the same bounds.
+        # A flat mesh still gets a non-zero extent.
+        origin.append(round((low + high) / 2, 6))
+        extent.append(round((high - low) / 2, 6) or 1.0)
+
+    packed = []
+    for v in vertices:
+        position = [max(-POSITION_MAX, min(POSITION_MAX, round((v[axis] - origin[axis]) / extent[axis] * POSITION_ONE))) for axis in range(3)]
+        for t in v[3:]:
+            if not 0.0 <= t <= 1.0:
+                raise ValueError("texture coordinate %f lies outside [0, 1]" % t)
+        tex_coord = [min(round(t * TEX_COORD_ONE), TEX_COORD_ONE - 1) for t in v[3:]]
+        packed.append((position, tex_coord))
+    return origin, extent, packed
+
+
+def q_vec3(values):
+    return "{{%s}}" % ", ".join("Q_FROM_FLOAT(%+f)" % v for v in values)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("source")
+    args = parser.parse_args()
+
+    with open(args.source) as f:
+        source = f.read()
+
+    meshes = MESH.findall(source)
+    if not meshes:
+        sys.exit("no mesh initializers with unpacked vertices found in " + args.source)
+
+    for _, _, name, body, _ in meshes:
+        if ".meshlets" in body:
+            sys.exit("the mesh of %s is split into meshlets, run tools/meshlets.py after tools/pack_vertices.py" % name)
+
+    bounds = {}
+    for _, _, name, _, _ in meshes:
+        if name in bounds:
+            continue
+
+        match = ts.array_pattern(name, r"pgl_vertex_t").search(source)
+        if match is None:
+            sys.exit("vertex array %s not found" % name)
+        vertices = [tuple(float(c) for c in v) for v in VERTEX.findall(match.group(2))]
+
+        try:
+            origin, extent, packed = pack(vertices)
+        except ValueError as error:
+            sys.exit("%s: %s" % (name, error))
+
+        lines = ["static const pgl_packed_vertex_t %s[] = {" % name]
+        lines += ["    {{%6d, %6d, %6d}, {%5d, %5d}}," % (*p, *t) for p, t in packed]
+        source = source[:match.start()] + "\n".join(lines) + "\n};\n" + source[match.end():]
+        bounds[name] = (origin, extent)
+
+        max_error = max(abs(v[axis] - (origin[axis] + p[axis] / POSITION_ONE * extent[axis]))
+                        for v, (p, _) in zip(vertices, packed) for axis in range(3))
+        print("%s: %d vertices, %d bytes instead of %d, max position error %.2e" % (name, len(vertices), 10 * len(vertices), 20 * len(vertices), max_error))
+
+    def packed_mesh(match):
+        origin, extent = bounds[match.group(3)]
+        return (match.group(1) + ".packed_vertices" + match.group(2) + match.group(3) + match.group(4) +
+                "\n    .origin = %s,\n    .extent = %s," % (q_vec3(origin), q_vec3(extent)) + match.group(5))
+
+    source = MESH.sub(packed_mesh, source)
+    with open(args.source, "w") as f:
+        f.write(source)
+
+
+if __name__ == "__main__":
+    main()
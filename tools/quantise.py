@@ -0,0 +1,181 @@
+#!/usr/bin/env python3
+"""Converts the colour textures of a model source file into palettised ones, in place.
+
+Every texture (including its mip chain from tools/mipmap.py) is quantised to a palette of
+2^bits colours: exactly when it has few enough colours, otherwise by median cut refined with
+k-means. NAME becomes an array of indices (two per byte for 4 bits, the lower nibble holding
+the left texel), NAME_palette holds the colours and the initializer is updated to match.
+
+    python3 tools/quantise.py scene_models.c [--bits 8|4] [--format rgb565|rgb332] [NAME ...]
+"""
+
+import argparse
+import math
+import sys
+
+import texture_source as ts
+
+KMEANS_ITERATIONS = 16
+
+
+def to_rgb(colour, fmt):
+    # Expands every channel to 8 bits so that distances are comparable across channels
+    r_bits, g_bits, b_bits, _ = ts.COLOUR_FORMATS[fmt]
+    r, g, b = ts.unpack(colour, fmt)
+    return (r * 255 / ((1 << r_bits) - 1), g * 255 / ((1 << g_bits) - 1), b * 255 / ((1 << b_bits) - 1))
+
+
+def from_rgb(rgb, fmt):
+    r_bits, g_bits, b_bits, _ = ts.COLOUR_FORMATS[fmt]
+    channels = [min(max(round(c * ((1 << bits) - 1) / 255), 0), (1 << bits) - 1) for c, bits in zip(rgb, (r_bits, g_bits, b_bits))]
+    return ts.pack(*channels, fmt)
+
+
+def distance(a, b):
+    return (a[0] - b[0]) ** 2 + (a[1] - b[1]) ** 2 + (a[2] - b[2]) ** 2
+
+
+def nearest(rgb, palette_rgb):
+    return min(range(len(palette_rgb)), key=lambda i: distance(rgb, palette_rgb[i]))
+
+
+def median_cut(histogram, colour_count):
+    """histogram maps rgb tuples to texel counts."""
+    boxes = [list(histogram.items())]
+    while len(boxes) < colour_count:
+        # Split the box with the widest weighted channel range
+        def spread(box):
+            return max(max(c[0][i] for c in box) - min(c[0][i] for c in box) for i in range(3)) * math.log2(1 + sum(n for _, n in box))
+        splittable = [box for box in boxes if len(box) > 1]
+        if not splittable:
+            break
+        box = max(splittable, key=spread)
+        boxes.remove(box)
+
+        channel = max(range(3), key=lambda i: max(c[0][i] for c in box) - min(c[0][i] for c in box))
+        box.sort(key=lambda c: c[0][channel])
+        half, total, cut = sum(n for _, n in box) / 2, 0, 1
+        for i, (_, n) in enumerate(box[:-1]):
+            total += n
+            if total >= half:
+                cut = i + 1
+                break
+        boxes += [box[:cut], box[cut:]]
+
+    return [tuple(sum(c[0][i] * c[1] for c in box) / sum(c[1] for c in box) for i in range(3)) for box in boxes]
+
+
+def kmeans(histogram, palette_rgb):
+    for _ in range(KMEANS_ITERATIONS):
+        sums = [[0.0, 0.0, 0.0, 0] for _ in palette_rgb]
+        for rgb, n in histogram.items():
+            s = sums[nearest(rgb, palette_rgb)]
+            for i in range(3):
+                s[i] += rgb[i] * n
+            s[3] += n
+        palette_rgb = [tuple(s[i] / s[3] for i in range(3)) if s[3] else p for s, p in zip(sums, palette_rgb)]
+    return palette_rgb
+
+
+def quantise(texels, colour_count, fmt):
+    """Returns the palette and the index of every texel."""
+    histogram = {}
+    for c in texels:
+        histogram[c] = histogram.get(c, 0) + 1
+
+    if len(histogram) <= colour_count:
+        palette = sorted(histogram)
+    else:
+        rgb_histogram = {}
+        for c, n in histogram.items():
+            rgb = to_rgb(c, fmt)
+            rgb_histogram[rgb] = rgb_histogram.get(rgb, 0) + n
+        palette_rgb = kmeans(rgb_histogram, median_cut(rgb_histogram, colour_count))
+        palette = sorted(set(from_rgb(rgb, fmt) for rgb in palette_rgb))
+
+    palette_rgb = [to_rgb(c, fmt) for c in palette]
+    lookup = {c: nearest(to_rgb(c, fmt), palette_rgb) for c in histogram}
+    return palette, [lookup[c] for c in texels]
+
+
+def pack_rows(indices, width, height, bits):
+    rows = [indices[y * width:(y + 1) * width] for y in range(height)]
+    if bits == 4:
+        # A single texel still takes a whole byte
+        rows = [[row[x] | ((row[x + 1] if x + 1 < len(row) else 0) << 4) for x in range(0, len(row), 2)] for row in rows]
+    return rows
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("source")
+    parser.add_argument("names", nargs="*", help="textures to quantise, all colour textures by default")
+    parser.add_argument("--bits", type=int, choices=(4, 8), default=8)
+    parser.add_argument("--format", choices=ts.COLOUR_FORMATS.keys(), default="rgb565")
+    args = parser.parse_args()
+
+    with open(args.source) as f:
+        source = f.read()
+
+    textures = ts.textures(source)
+    names = args.names or [name for name, fields in textures.items() if not ts.is_indexed(fields)]
+    digits = ts.COLOUR_FORMATS[args.format][3]
+
+    for name in names:
+        fields = textures.get(name)
+        if fields is None:
+            sys.exit("no texture initializer for " + name)
+        if ts.is_indexed(fields):
+            sys.exit(name + " is already indexed")
+        if ts.is_morton(fields):
+            sys.exit("%s has the Morton layout, run tools/swizzle.py --linear first" % name)
+
+        width_bits, height_bits = int(fields["width_bits"]), int(fields["height_bits"])
+        level_count = int(fields.get("level_count", "1")) if "mipmaps" in fields else 1
+
+        # INDEX4 rows must fill at least a byte
+        if args.bits == 4:
+            level_count = min(level_count, width_bits)
+
+        # (width, height) of every level, base level first
+        sizes = [(1 << (width_bits - i), 1 << (height_bits - i)) for i in range(level_count)]
+
+        texels = ts.array_values(ts.find_array(source, name))
+        if "mipmaps" in fields:
+            texels += ts.array_values(ts.find_array(source, fields["mipmaps"]))
+        texels = texels[:sum(w * h for w, h in sizes)]
+
+        palette, indices = quantise(texels, 1 << args.bits, args.format)
+        error = math.sqrt(sum(distance(to_rgb(t, args.format), to_rgb(palette[i], args.format)) for t, i in zip(texels, indices)) / len(texels) / 3)
+
+        levels, offset = [], 0
+        for w, h in sizes:
+            levels.append(pack_rows(indices[offset:offset + w * h], w, h, args.bits))
+            offset += w * h
+
+        palette_name = name + "_palette"
+        source = ts.remove_array(source, palette_name)
+        match = ts.find_array(source, name)
+        palette_array = ts.format_array("colour_t", palette_name, [palette[i:i + 16] for i in range(0, len(palette), 16)], digits)
+        texel_array = ts.format_array("uint8_t", name, levels[0], 2)
+        source = source[:match.start()] + palette_array + "\n" + texel_array + source[match.end():]
+
+        if level_count > 1:
+            rows, comments = [], {}
+            for level, (w, h) in enumerate(sizes[1:], start=1):
+                comments[len(rows)] = "Level %d: %dx%d" % (level, w, h)
+                rows += levels[level]
+            match = ts.find_array(source, fields["mipmaps"])
+            source = source[:match.start()] + ts.format_array("uint8_t", fields["mipmaps"], rows, 2, comments) + source[match.end():]
+            fields["level_count"] = str(level_count)
+
+        fields.update(palette=palette_name, format="PGL_TEXTURE_FORMAT_INDEX%d" % args.bits)
+        source = ts.replace_texture(source, fields)
+        print("%s: %d colours in %d entries, RMS error %.2f / 255" % (name, len(set(texels)), len(palette), error))
+
+    with open(args.source, "w") as f:
+        f.write(source)
+
+
+if __name__ == "__main__":
+    main()
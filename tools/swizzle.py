@@ -0,0 +1,117 @@
+#!/usr/bin/env python3
+"""Converts the textures of a model source file between the row-major and the Morton layout, in place.
+
+In the Morton (Z-order) layout, the texels of every level are ordered along a Z curve inside squares
+of the smaller dimension and the squares follow each other along the larger dimension, so texels
+that are close in texture space are close in memory whatever direction a scanline walks. Both
+NAME and NAME_mipmaps are reordered and the initializer gets `.layout = PGL_TEXTURE_LAYOUT_MORTON`.
+Run it after tools/mipmap.py, tools/quantise.py and tools/atlas.py, which expect row-major texels.
+
+    python3 tools/swizzle.py scene_models.c [--linear] [--format rgb565|rgb332] [NAME ...]
+"""
+
+import argparse
+import sys
+
+import texture_source as ts
+
+# The smaller dimension is spread through a table of this many bits by pgl
+MAX_SQUARE_BITS = 8
+
+
+def morton_offset(x, y, square_bits):
+    offset = 0
+    for bit in range(square_bits):
+        offset |= ((x >> bit) & 1) << (2 * bit) | ((y >> bit) & 1) << (2 * bit + 1)
+    return offset | ((x | y) >> square_bits) << (2 * square_bits)
+
+
+def reorder(texels, width_bits, height_bits, to_morton):
+    width, height = 1 << width_bits, 1 << height_bits
+    square_bits = min(width_bits, height_bits)
+    out = [0] * (width * height)
+    for y in range(height):
+        for x in range(width):
+            linear, morton = y * width + x, morton_offset(x, y, square_bits)
+            if to_morton:
+                out[morton] = texels[linear]
+            else:
+                out[linear] = texels[morton]
+    return out
+
+
+def unpack_nibbles(values):
+    return [(byte >> shift) & 0xf for byte in values for shift in (0, 4)]
+
+
+def pack_nibbles(values):
+    return [values[i] | (values[i + 1] << 4) for i in range(0, len(values), 2)]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("source")
+    parser.add_argument("names", nargs="*", help="textures to convert, all of them by default")
+    parser.add_argument("--linear", action="store_true", help="convert back to the row-major layout")
+    parser.add_argument("--format", choices=ts.COLOUR_FORMATS.keys(), default="rgb565")
+    args = parser.parse_args()
+
+    with open(args.source) as f:
+        source = f.read()
+
+    textures = ts.textures(source)
+    names = args.names or list(textures)
+    to_morton = not args.linear
+
+    for name in names:
+        fields = textures.get(name)
+        if fields is None:
+            sys.exit("no texture initializer for " + name)
+        if ts.is_morton(fields) == to_morton:
+            print("%s: already %s, skipped" % (name, "Morton" if to_morton else "row-major"))
+            continue
+
+        width_bits, height_bits = int(fields["width_bits"]), int(fields["height_bits"])
+        if to_morton and min(width_bits, height_bits) > MAX_SQUARE_BITS:
+            sys.exit("%s is larger than %d texels in both dimensions" % (name, 1 << MAX_SQUARE_BITS))
+
+        index4 = fields.get("format") == "PGL_TEXTURE_FORMAT_INDEX4"
+        level_count = int(fields.get("level_count", "1")) if "mipmaps" in fields else 1
+        for array, first_level, last_level in ((name, 0, 1), (fields.get("mipmaps"), 1, level_count)):
+            if array is None or first_level >= last_level:
+                continue
+
+            match = ts.find_array(source, array)
+            element_type, values = match.group(1), ts.array_values(match)
+            texels = unpack_nibbles(values) if index4 else values
+
+            rows, comments, offset = [], {}, 0
+            for level in range(first_level, last_level):
+                level_width_bits, level_height_bits = width_bits - level, height_bits - level
+                count = 1 << (level_width_bits + level_height_bits)
+                level_texels = reorder(texels[offset:offset + count], level_width_bits, level_height_bits, to_morton)
+                offset += count
+
+                if level > 0:
+                    comments[len(rows)] = "Level %d: %dx%d" % (level, 1 << level_width_bits, 1 << level_height_bits)
+                row_length = 1 << level_width_bits
+                if index4:
+                    level_texels, row_length = pack_nibbles(level_texels), max(row_length // 2, 1)
+                rows += [level_texels[i:i + row_length] for i in range(0, len(level_texels), row_length)]
+
+            digits = 2 if element_type == "uint8_t" else ts.COLOUR_FORMATS[args.format][3]
+            source = source[:match.start()] + ts.format_array(element_type, array, rows, digits, comments) + source[match.end():]
+
+        if to_morton:
+            fields["layout"] = "PGL_TEXTURE_LAYOUT_MORTON"
+        else:
+            fields.pop("layout", None)
+        source = ts.replace_texture(source, fields)
+        print("%s: %s" % (name, "Morton" if to_morton else "row-major"))
+
+    with open(args.source, "w") as f:
+        f.write(source)
+
+
+if __name__ == "__main__":
+    main()
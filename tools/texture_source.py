@@ -0,0 +1,78 @@
+"""Reading and rewriting the texture arrays and `.texture = { ... }` initializers of model source files."""
+
+import re
+
+FIELD_ORDER = ("texels", "mipmaps", "palette", "width_bits", "height_bits", "level_count", "format", "layout")
+
+TEXTURE_INIT = re.compile(r"\.texture\s*=\s*\{([^}]*)\}")
+FIELD = re.compile(r"\.(\w+)\s*=\s*([\w]+)")
+
+COLOUR_FORMATS = {
+    # name: (red bits, green bits, blue bits, hex digits)
+    "rgb565": (5, 6, 5, 4),
+    "rgb332": (3, 3, 2, 2),
+}
+
+
+def textures(source):
+    """Returns the fields of every texture initializer, keyed by the name of its texel array."""
+    result = {}
+    for match in TEXTURE_INIT.finditer(source):
+        fields = dict(FIELD.findall(match.group(1)))
+        result[fields["texels"]] = fields
+    return result
+
+
+def replace_texture(source, fields):
+    init = ".texture = { " + ", ".join(".%s = %s" % (f, fields[f]) for f in FIELD_ORDER if f in fields) + " }"
+    pattern = r"\.texture\s*=\s*\{\s*\.texels\s*=\s*" + re.escape(fields["texels"]) + r"\s*,[^}]*\}"
+    return re.sub(pattern, lambda _: init, source)
+
+
+def is_indexed(fields):
+    return fields.get("format", "PGL_TEXTURE_FORMAT_COLOUR") != "PGL_TEXTURE_FORMAT_COLOUR"
+
+
+def is_morton(fields):
+    return fields.get("layout", "PGL_TEXTURE_LAYOUT_LINEAR") == "PGL_TEXTURE_LAYOUT_MORTON"
+
+
+def array_pattern(name, element_type=r"\w+"):
+    return re.compile(r"static const (" + element_type + r") " + re.escape(name) + r"\[\] = \{(.*?)\};\n", re.S)
+
+
+def find_array(source, name):
+    """Returns the match of the array, with its element type in group 1 and its body in group 2, or None."""
+    return array_pattern(name).search(source)
+
+
+def array_values(match):
+    return [int(v, 16) for v in re.findall(r"0x[0-9a-fA-F]+", match.group(2))]
+
+
+def remove_array(source, name):
+    return re.sub(r"\n?" + array_pattern(name).pattern, "", source, flags=re.S)
+
+
+def format_array(element_type, name, rows, digits, comments=None):
+    """rows is a list of lists of values, comments maps a row index to the comment line placed before it."""
+    lines = ["static const %s %s[] = {" % (element_type, name)]
+    for i, row in enumerate(rows):
+        if comments and i in comments:
+            lines.append("    // " + comments[i])
+        lines.append("    " + " ".join("0x%0*x," % (digits, v) for v in row))
+    lines.append("};")
+    return "\n".join(lines) + "\n"
+
+
+def unpack(colour, fmt):
+    r_bits, g_bits, b_bits, _ = COLOUR_FORMATS[fmt]
+    b = colour & ((1 << b_bits) - 1)
+    g = (colour >> b_bits) & ((1 << g_bits) - 1)
+    r = (colour >> (b_bits + g_bits)) & ((1 << r_bits) - 1)
+    return r, g, b
+
+
+def pack(r, g, b, fmt):
+    _, g_bits, b_bits, _ = COLOUR_FORMATS[fmt]
+    return (r << (b_bits + g_bits)) | (g << b_bits) | b
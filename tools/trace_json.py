@@ -0,0 +1,85 @@
+#!/usr/bin/env python3
+"""Converts the trace markers dumped by trace_dump into a Chrome trace.
+
+Build with TRACE_EVENT_COUNT=<events>, capture the serial output while pressing A to dump the frames
+recorded so far, then convert the capture and open the result in chrome://tracing or
+https://ui.perfetto.dev. Every core becomes a thread, so the overlap of the cores and the waits
+for each other and for the swapchain are visible frame by frame. Lines other than the markers are
+ignored, so the capture may hold other output and several dumps.
+
+    python3 tools/trace_json.py capture.txt trace.json
+"""
+
+import argparse
+import json
+import re
+import sys
+
+MARKER = re.compile(r"^TRACE (\d+) ([BE]) (\d+) (.+)$")
+DUMP = "TRACE DUMP"
+
+
+def convert(lines):
+    """Returns the Chrome trace events of the marker lines, dropping the unmatched ones."""
+    events, open_zones, last_time, dropped = [], {}, {}, set()
+    for line in lines:
+        if line.strip() == DUMP:
+            # The zones left open by the previous dump never end, the time in between was not recorded
+            for stack in open_zones.values():
+                dropped.update(stack)
+                stack.clear()
+            continue
+
+        match = MARKER.match(line.strip())
+        if match is None:
+            continue
+
+        core, phase, time_us, zone = int(match.group(1)), match.group(2), int(match.group(3)), match.group(4)
+
+        # time_us_32 wraps around every 71 minutes
+        if core in last_time:
+            while time_us < last_time[core] - (1 << 31):
+                time_us += 1 << 32
+        last_time[core] = time_us
+
+        stack = open_zones.setdefault(core, [])
+        if phase == "B":
+            stack.append(len(events))
+            events.append({"name": zone, "ph": "B", "ts": time_us, "pid": 0, "tid": core})
+        elif stack and events[stack[-1]]["name"] == zone:
+            stack.pop()
+            events.append({"name": zone, "ph": "E", "ts": time_us, "pid": 0, "tid": core})
+        else:
+            # The ring overwrote the begin marker of the zone
+            dropped.update(stack)
+            stack.clear()
+
+    # Zones still open at the end of the capture have no duration
+    for stack in open_zones.values():
+        dropped.update(stack)
+    events = [event for index, event in enumerate(events) if index not in dropped]
+
+    names = [{"name": "thread_name", "ph": "M", "pid": 0, "tid": core, "args": {"name": "core%d" % core}} for core in sorted(open_zones)]
+    return names + events
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("capture")
+    parser.add_argument("output")
+    args = parser.parse_args()
+
+    with open(args.capture, errors="replace") as f:
+        events = convert(f)
+    if not events:
+        sys.exit("no trace markers found in " + args.capture)
+
+    with open(args.output, "w") as f:
+        json.dump({"traceEvents": events, "displayTimeUnit": "ms"}, f)
+
+    print("%d events of %d cores written to %s" % (sum(1 for e in events if e["ph"] != "M"),
+                                                    sum(1 for e in events if e["ph"] == "M"), args.output))
+
+
+if __name__ == "__main__":
+    main()